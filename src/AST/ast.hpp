@@ -66,13 +66,22 @@ struct StmtVisitor
     virtual ~StmtVisitor() = default;
 };
 
+// Ids follow construction order, so parsing the same source always yields the
+// same ids; execution profiles are keyed by them
+inline int nextExprNodeId()
+{
+    static int counter = 0;
+    return ++counter;
+}
+
 // Base class for all expression nodes
 struct Expr
 {
     int line_number = 0;  // Line number for error reporting
     int column_number = 0; // Column number for error reporting
+    int node_id;           // Stable id for profiling (see nextExprNodeId)
     
-    Expr(int line = 0, int col = 0) : line_number(line), column_number(col) {}
+    Expr(int line = 0, int col = 0) : line_number(line), column_number(col), node_id(nextExprNodeId()) {}
     virtual void accept(ExprVisitor *v) = 0;
     virtual ~Expr() = default;
 };
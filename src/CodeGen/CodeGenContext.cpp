@@ -1,12 +1,57 @@
 #include "CodeGenContext.hpp"
 #include "../AST/ast.hpp"
 #include "LLVMCodeGenerator.hpp"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#if LLVM_VERSION_MAJOR >= 14
+#include "llvm/MC/TargetRegistry.h"
+#else
+#include "llvm/Support/TargetRegistry.h"
+#endif
+#if LLVM_VERSION_MAJOR >= 17
+#include "llvm/TargetParser/Host.h"
+#include "llvm/TargetParser/SubtargetFeature.h"
+#else
+#include "llvm/Support/Host.h"
+#include "llvm/MC/SubtargetFeature.h"
+#endif
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <set>
 #include <stdexcept>
 
+#if HULK_EMBED_RUNTIME_BC
+// Bitcode of hulk_runtime.c, embedded by src/Runtime/hulk_runtime_bc.S
+extern "C" const char hulk_runtime_bc_start[];
+extern "C" const char hulk_runtime_bc_end[];
+#endif
+
 CodeGenContext::CodeGenContext() 
     : context_()
     , module_(std::make_unique<llvm::Module>("hulk_enhanced_module", context_))
@@ -14,6 +59,30 @@ CodeGenContext::CodeGenContext()
     , current_function_(nullptr)
     , current_self_(nullptr)
     , current_type_("") {
+#if LLVM_VERSION_MAJOR < 15
+    // Object headers, vtables and method calls assume opaque pointers (default since LLVM 15)
+    context_.enableOpaquePointers();
+#endif
+    
+    // Common prefix of every object struct: { i32 type_id, ptr vtable }
+    object_header_type_ = llvm::StructType::create(
+        context_,
+        {llvm::Type::getInt32Ty(context_), llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_))},
+        "hulk.object_header");
+    
+    // { i64 refcount, i64 length, ptr data, [N x i8] inline_buf }
+    string_type_ = llvm::StructType::create(
+        context_,
+        {llvm::Type::getInt64Ty(context_), llvm::Type::getInt64Ty(context_),
+         llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_)),
+         llvm::ArrayType::get(llvm::Type::getInt8Ty(context_), kStringInlineCapacity + 1)},
+        "hulk.string");
+    
+    dynamic_value_type_ = llvm::StructType::create(
+        context_, {llvm::Type::getInt64Ty(context_), llvm::Type::getInt64Ty(context_)}, "hulk.value");
+    
+    // Struct sizes and field offsets must match the machine the code runs on
+    initializeTarget();
     
     // Initialize variable scope
     pushScope();
@@ -22,6 +91,274 @@ CodeGenContext::CodeGenContext()
     createBuiltinFunctions();
 }
 
+void CodeGenContext::initializeTarget() {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    
+    std::string triple = llvm::sys::getDefaultTargetTriple();
+    target_machine_ = createTargetMachine(triple);
+    if (target_machine_) {
+        module_->setTargetTriple(triple);
+        module_->setDataLayout(target_machine_->createDataLayout());
+    }
+}
+
+bool CodeGenContext::linkRuntimeBitcode() {
+#if HULK_EMBED_RUNTIME_BC
+    llvm::StringRef bitcode(hulk_runtime_bc_start, hulk_runtime_bc_end - hulk_runtime_bc_start);
+    auto runtime = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, "hulk_runtime.bc"), context_);
+    if (!runtime) {
+        std::cerr << "Warning: cannot load runtime bitcode: "
+                  << llvm::toString(runtime.takeError()) << std::endl;
+        return false;
+    }
+    (*runtime)->setTargetTriple(module_->getTargetTriple());
+    (*runtime)->setDataLayout(module_->getDataLayout());
+    
+    std::set<std::string> runtime_definitions;
+    for (const auto& function : **runtime) {
+        if (!function.isDeclaration()) {
+            runtime_definitions.insert(function.getName().str());
+        }
+    }
+    for (const auto& global : (*runtime)->globals()) {
+        if (!global.isDeclaration()) {
+            runtime_definitions.insert(global.getName().str());
+        }
+    }
+    
+    // Only what the program (transitively) uses is linked in
+    if (llvm::Linker::linkModules(*module_, std::move(*runtime), llvm::Linker::Flags::LinkOnlyNeeded)) {
+        std::cerr << "Warning: cannot link runtime bitcode" << std::endl;
+        return false;
+    }
+    
+    // The program is the only user of its copy, so the optimizer may inline,
+    // specialize or drop these freely
+    for (const auto& name : runtime_definitions) {
+        llvm::GlobalValue* value = module_->getNamedValue(name);
+        if (value && !value->isDeclaration()) {
+            value->setLinkage(llvm::GlobalValue::InternalLinkage);
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::unique_ptr<llvm::TargetMachine> CodeGenContext::createTargetMachine(const std::string& triple) const {
+    std::string error;
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, error);
+    if (!target) {
+        std::cerr << "Warning: no LLVM target for " << triple << ": " << error << std::endl;
+        return nullptr;
+    }
+    
+    // Further machines (parallel codegen workers) copy the primary one's settings
+    llvm::TargetOptions options = target_machine_ ? target_machine_->Options : llvm::TargetOptions();
+    std::string cpu = target_machine_ ? target_machine_->getTargetCPU().str() : "generic";
+    std::string features = target_machine_ ? target_machine_->getTargetFeatureString().str() : "";
+    return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+        triple, cpu, features, options, llvm::Reloc::PIC_));
+}
+
+bool CodeGenContext::setTargetCPU(const std::string& cpu) {
+    if (!target_machine_) {
+        return false;
+    }
+    std::string name = cpu;
+    std::string features;
+    if (cpu == "native") {
+        name = llvm::sys::getHostCPUName().str();
+        llvm::StringMap<bool> host_features;
+        if (llvm::sys::getHostCPUFeatures(host_features)) {
+            llvm::SubtargetFeatures feature_list;
+            for (const auto& feature : host_features) {
+                feature_list.AddFeature(feature.first(), feature.second);
+            }
+            features = feature_list.getString();
+        }
+    } else if (!target_machine_->getMCSubtargetInfo()->isCPUStringValid(cpu)) {
+        std::cerr << "Warning: unknown CPU '" << cpu << "' for " << module_->getTargetTriple() << std::endl;
+        return false;
+    }
+    
+    llvm::TargetOptions options = target_machine_->Options;
+    target_machine_.reset(target_machine_->getTarget().createTargetMachine(
+        module_->getTargetTriple(), name, features, options, llvm::Reloc::PIC_));
+    module_->setDataLayout(target_machine_->createDataLayout());
+    target_cpu_set_ = true;
+    return true;
+}
+
+// The optimizer's cost models and the backend read the CPU per function
+void CodeGenContext::applyTargetAttributes() {
+    if (!target_cpu_set_) {
+        return;
+    }
+    std::string cpu = target_machine_->getTargetCPU().str();
+    std::string features = target_machine_->getTargetFeatureString().str();
+    for (llvm::Function& function : *module_) {
+        if (function.isDeclaration() || function.hasFnAttribute("target-cpu")) {
+            continue; // multiversioned clones and the linked runtime keep their own
+        }
+        function.addFnAttr("target-cpu", cpu);
+        if (!features.empty()) {
+            function.addFnAttr("target-features", features);
+        }
+    }
+}
+
+bool CodeGenContext::multiversionFunction(llvm::Function* function) {
+    if (llvm::Triple(module_->getTargetTriple()).getArch() != llvm::Triple::x86_64) {
+        return false;
+    }
+    // Most capable first; the resolver takes the first the CPU supports
+    // (levels from hulk_cpu_level: 2 = AVX-512, 1 = AVX2, 0 = baseline)
+    struct Version {
+        const char* suffix;
+        const char* cpu;
+        int level;
+    };
+    static const Version kVersions[] = {{"avx512", "x86-64-v4", 2}, {"avx2", "x86-64-v3", 1}};
+    
+    std::string name = function->getName().str();
+    function->setName(name + ".baseline");
+    function->setLinkage(llvm::GlobalValue::InternalLinkage);
+    function->removeFnAttr("target-features");
+    function->addFnAttr("target-cpu", "x86-64");
+    
+    std::vector<std::pair<llvm::Function*, int>> versions;
+    for (const Version& version : kVersions) {
+        llvm::ValueToValueMapTy value_map;
+        llvm::Function* clone = llvm::CloneFunction(function, value_map);
+        clone->setName(name + "." + version.suffix);
+        clone->addFnAttr("target-cpu", version.cpu);
+        // Recursion stays within the version
+        function->replaceUsesWithIf(clone, [clone](llvm::Use& use) {
+            auto* instruction = llvm::dyn_cast<llvm::Instruction>(use.getUser());
+            return instruction && instruction->getFunction() == clone;
+        });
+        versions.emplace_back(clone, version.level);
+    }
+    versions.emplace_back(function, 0);
+    
+    // Every other caller goes through the ifunc, bound once when the program is loaded
+    llvm::Type* ptr_type = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_));
+    llvm::Function* resolver = llvm::Function::Create(
+        llvm::FunctionType::get(ptr_type, false), llvm::GlobalValue::InternalLinkage,
+        name + ".resolver", *module_);
+    llvm::GlobalIFunc* ifunc = llvm::GlobalIFunc::create(
+        function->getFunctionType(), 0, llvm::GlobalValue::ExternalLinkage, name, resolver, module_.get());
+    function->replaceUsesWithIf(ifunc, [&](llvm::Use& use) {
+        auto* instruction = llvm::dyn_cast<llvm::Instruction>(use.getUser());
+        return !instruction || instruction->getFunction() != function;
+    });
+    
+    llvm::Function* cpu_level = lookupFunction("hulk_cpu_level");
+    if (!cpu_level) {
+        cpu_level = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getInt32Ty(context_), false),
+            llvm::Function::ExternalLinkage, "hulk_cpu_level", *module_);
+        declareFunction("hulk_cpu_level", cpu_level);
+    }
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context_, "entry", resolver));
+    llvm::Value* level = builder.CreateCall(cpu_level, {}, "level");
+    llvm::Value* chosen = function;
+    for (auto it = versions.rbegin() + 1; it != versions.rend(); ++it) {
+        llvm::Value* supported = builder.CreateICmpSGE(level, builder.getInt32(it->second));
+        chosen = builder.CreateSelect(supported, it->first, chosen);
+    }
+    builder.CreateRet(chosen);
+    ++multiversioned_functions_;
+    return true;
+}
+
+// Invalid IR is a compiler bug: it must never be optimized, cached or written out
+void CodeGenContext::verifyGeneratedModule() {
+    std::string error_str;
+    llvm::raw_string_ostream error_stream(error_str);
+    if (llvm::verifyModule(*module_, &error_stream)) {
+        throw std::runtime_error("generated module failed verification: " + error_stream.str());
+    }
+}
+
+void CodeGenContext::optimizeModule(unsigned level) {
+    opt_level_ = level;
+    finalizeDebugInfo();
+    applyTargetAttributes();
+    
+    // The pass pipeline assumes well-formed IR
+    verifyGeneratedModule();
+    
+    // The same IR with the same settings optimizes to the same module, so a
+    // cached one skips the pipeline altogether
+    std::string cache_entry;
+    if (openObjectCache()) {
+        object_cache_key_ = objectCacheKey();
+        cache_entry = objectCacheEntry(".bc");
+        if (loadCachedModule(cache_entry)) {
+            return;
+        }
+    }
+    
+    // Runtime helpers become visible to the inliner and constant folding
+    if (level > 0) {
+        linkRuntimeBitcode();
+    }
+    
+    llvm::LoopAnalysisManager loop_am;
+    llvm::FunctionAnalysisManager function_am;
+    llvm::CGSCCAnalysisManager cgscc_am;
+    llvm::ModuleAnalysisManager module_am;
+    
+    // Target info lets the vectorizer and unroller use real cost models
+    llvm::PipelineTuningOptions tuning;
+    tuning.LoopVectorization = level >= 2;
+    tuning.SLPVectorization = level >= 2;
+    tuning.LoopUnrolling = level >= 2;
+    llvm::PassBuilder pass_builder(target_machine_.get(), tuning);
+    
+    // Let the vectorizer widen math calls into libmvec variants (glibc x86-64)
+    llvm::Triple triple(module_->getTargetTriple());
+    llvm::TargetLibraryInfoImpl library_info(triple);
+    if (triple.getArch() == llvm::Triple::x86_64 && triple.isOSLinux() && triple.isGNUEnvironment()) {
+#if LLVM_VERSION_MAJOR >= 16
+        library_info.addVectorizableFunctionsFromVecLib(llvm::TargetLibraryInfoImpl::LIBMVEC_X86, triple);
+#else
+        library_info.addVectorizableFunctionsFromVecLib(llvm::TargetLibraryInfoImpl::LIBMVEC_X86);
+#endif
+    }
+    function_am.registerPass([&] { return llvm::TargetLibraryAnalysis(library_info); });
+    
+    pass_builder.registerModuleAnalyses(module_am);
+    pass_builder.registerCGSCCAnalyses(cgscc_am);
+    pass_builder.registerFunctionAnalyses(function_am);
+    pass_builder.registerLoopAnalyses(loop_am);
+    pass_builder.crossRegisterProxies(loop_am, function_am, cgscc_am, module_am);
+    
+    llvm::OptimizationLevel opt_level = llvm::OptimizationLevel::O0;
+    switch (level) {
+        case 0: opt_level = llvm::OptimizationLevel::O0; break;
+        case 1: opt_level = llvm::OptimizationLevel::O1; break;
+        case 2: opt_level = llvm::OptimizationLevel::O2; break;
+        default: opt_level = llvm::OptimizationLevel::O3; break;
+    }
+    
+    llvm::ModulePassManager module_pm = level == 0
+        ? pass_builder.buildO0DefaultPipeline(opt_level)
+        : pass_builder.buildPerModuleDefaultPipeline(opt_level);
+    module_pm.run(*module_, module_am);
+    
+    if (!cache_entry.empty()) {
+        llvm::SmallString<0> bitcode;
+        llvm::raw_svector_ostream stream(bitcode);
+        llvm::WriteBitcodeToFile(*module_, stream);
+        storeCacheEntry(cache_entry, "", bitcode);
+    }
+}
+
 void CodeGenContext::generateCode(Program* program) {
     LLVMCodeGenerator generator(*this);
     
@@ -76,56 +413,368 @@ llvm::Value* CodeGenContext::peekValue() const {
 }
 
 void CodeGenContext::pushScope() {
-    variable_stack_.push(std::map<std::string, llvm::Value*>());
+    variables_.pushScope();
 }
 
 void CodeGenContext::popScope() {
-    if (!variable_stack_.empty()) {
-        variable_stack_.pop();
-    }
+    variables_.popScope();
 }
 
 void CodeGenContext::declareVariable(const std::string& name, llvm::Value* value) {
-    if (!variable_stack_.empty()) {
-        variable_stack_.top()[name] = value;
+    variables_.declare(name, value);
+}
+
+void CodeGenContext::assignVariable(const std::string& name, llvm::Value* value) {
+    // Update the variable in the scope that declared it
+    if (llvm::Value** binding = variables_.lookup(name)) {
+        *binding = value;
+    } else {
+        declareVariable(name, value);
     }
 }
 
+llvm::AllocaInst* CodeGenContext::createEntryAlloca(llvm::Type* type, const std::string& name) {
+    // Allocas at the top of the entry block are what mem2reg promotes to SSA
+    llvm::Function* function = builder_->GetInsertBlock()->getParent();
+    llvm::IRBuilder<> entry_builder(&function->getEntryBlock(), function->getEntryBlock().begin());
+    return entry_builder.CreateAlloca(type, nullptr, name);
+}
+
 llvm::Value* CodeGenContext::lookupVariable(const std::string& name) {
-    // Search from current scope to global scope
-    std::stack<std::map<std::string, llvm::Value*>> temp_stack;
-    llvm::Value* result = nullptr;
+    llvm::Value** binding = variables_.lookup(name);
+    return binding ? *binding : nullptr;
+}
+
+void CodeGenContext::declareFunction(const std::string& name, llvm::Function* function) {
+    functions_[symbols_.intern(name)] = function;
+}
+
+llvm::Function* CodeGenContext::lookupFunction(const std::string& name) {
+    llvm::Function** function = functions_.find(symbols_.find(name));
+    return function ? *function : nullptr;
+}
+
+void CodeGenContext::setFastMathOptions(bool fast_math, bool fp_contract, bool no_nans) {
+    llvm::FastMathFlags flags;
+    if (fast_math) {
+        flags.setFast();
+    }
+    if (fp_contract) {
+        flags.setAllowContract(true);
+    }
+    if (no_nans) {
+        flags.setNoNaNs(true);
+    }
+    builder_->setFastMathFlags(flags);
+    
+    // Contractable fmul/fadd pairs may then be fused into FMA by the backend
+    if (target_machine_ && flags.allowContract()) {
+        target_machine_->Options.AllowFPOpFusion = llvm::FPOpFusion::Fast;
+    }
+}
+
+static void emitObjectFile(llvm::Module& module, llvm::TargetMachine& machine, const std::string& filename) {
+    std::error_code error_code;
+    llvm::raw_fd_ostream file(filename, error_code, llvm::sys::fs::OF_None);
+    if (error_code) {
+        throw std::runtime_error("Failed to open file for object output: " + error_code.message());
+    }
+    
+    llvm::legacy::PassManager pass_manager;
+#if LLVM_VERSION_MAJOR >= 18
+    auto file_type = llvm::CodeGenFileType::ObjectFile;
+#else
+    auto file_type = llvm::CGFT_ObjectFile;
+#endif
+    if (machine.addPassesToEmitFile(pass_manager, file, nullptr, file_type)) {
+        throw std::runtime_error("Target cannot emit object files");
+    }
+    pass_manager.run(module);
+    file.flush();
+}
+
+bool CodeGenContext::openObjectCache() {
+    if (object_cache_dir_.empty() || !target_machine_) {
+        return false;
+    }
+    if (std::error_code error_code = llvm::sys::fs::create_directories(object_cache_dir_)) {
+        std::cerr << "Warning: compilation cache disabled, cannot create " << object_cache_dir_
+                  << ": " << error_code.message() << std::endl;
+        object_cache_dir_.clear();
+        return false;
+    }
+    return true;
+}
+
+std::string CodeGenContext::objectCacheKey() const {
+    // The bitcode already carries the producer (LLVM version); add the knobs
+    // that change the result without changing the IR
+    std::string settings = module_->getTargetTriple() + "|" +
+        target_machine_->getTargetCPU().str() + "|" +
+        target_machine_->getTargetFeatureString().str() + "|O" + std::to_string(opt_level_) +
+        "|fuse" + std::to_string(static_cast<int>(target_machine_->Options.AllowFPOpFusion));
     
-    while (!variable_stack_.empty()) {
-        auto& current_scope = variable_stack_.top();
-        auto it = current_scope.find(name);
-        if (it != current_scope.end()) {
-            result = it->second;
-            break;
+    llvm::SmallString<0> bitcode;
+    llvm::raw_svector_ostream stream(bitcode);
+    llvm::WriteBitcodeToFile(*module_, stream);
+    
+    llvm::SHA1 hasher;
+    hasher.update(settings);
+#if HULK_EMBED_RUNTIME_BC
+    // Linked in before optimization, so a rebuilt runtime invalidates the cache
+    hasher.update(llvm::StringRef(hulk_runtime_bc_start, hulk_runtime_bc_end - hulk_runtime_bc_start));
+#endif
+    hasher.update(bitcode.str());
+    return llvm::toHex(hasher.final(), true);
+}
+
+std::string CodeGenContext::objectCacheEntry(llvm::StringRef extension) const {
+    // pruneCache only considers files named llvmcache-*
+    llvm::SmallString<128> path(object_cache_dir_);
+    llvm::sys::path::append(path, "llvmcache-" + object_cache_key_ + extension.str());
+    return path.str().str();
+}
+
+bool CodeGenContext::loadCachedModule(const std::string& entry) {
+    auto buffer = llvm::MemoryBuffer::getFile(entry);
+    if (!buffer) {
+        ++object_cache_misses_;
+        return false;
+    }
+    auto cached = llvm::parseBitcodeFile((*buffer)->getMemBufferRef(), context_);
+    if (!cached) {
+        // A damaged entry is a miss; it is rewritten after optimizing
+        llvm::consumeError(cached.takeError());
+        ++object_cache_misses_;
+        return false;
+    }
+    // The old module stays alive: the generator's function tables point into it
+    (*cached)->setModuleIdentifier(module_->getModuleIdentifier());
+    uncached_module_ = std::move(module_);
+    module_ = std::move(*cached);
+    ++object_cache_hits_;
+    return true;
+}
+
+// Entries are published atomically so concurrent compilers never see a partial
+// one, and the cache is trimmed afterwards. Failing to store is not an error.
+void CodeGenContext::storeCacheEntry(const std::string& entry, llvm::StringRef source_file,
+                                     llvm::StringRef contents) {
+    int fd = -1;
+    llvm::SmallString<128> temp_path;
+    std::error_code error_code = llvm::sys::fs::createUniqueFile(entry + ".%%%%%%.tmp", fd, temp_path);
+    if (!error_code) {
+        llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+        if (!source_file.empty()) {
+            error_code = llvm::sys::fs::copy_file(source_file, temp_path);
+        } else {
+            llvm::raw_fd_ostream file(temp_path, error_code, llvm::sys::fs::OF_None);
+            if (!error_code) {
+                file << contents;
+                file.close();
+                error_code = file.error();
+            }
+        }
+        if (!error_code) {
+            error_code = llvm::sys::fs::rename(temp_path, entry);
         }
-        temp_stack.push(current_scope);
-        variable_stack_.pop();
+        if (error_code) {
+            llvm::sys::fs::remove(temp_path);
+        }
+    }
+    if (error_code) {
+        std::cerr << "Warning: cannot store " << entry << " in the compilation cache: "
+                  << error_code.message() << std::endl;
+        return;
     }
     
-    // Restore the stack
-    while (!temp_stack.empty()) {
-        variable_stack_.push(temp_stack.top());
-        temp_stack.pop();
+    // Least recently used entries go first once the cache outgrows its bound;
+    // entries unused for a week go regardless (checked at most every 20 minutes)
+    llvm::CachePruningPolicy policy;
+    policy.Interval = std::chrono::minutes(20);
+    policy.Expiration = std::chrono::hours(24 * 7);
+    policy.MaxSizeBytes = kObjectCacheMaxBytes;
+    llvm::pruneCache(object_cache_dir_, policy);
+}
+
+void CodeGenContext::writeObjectFile(const std::string& filename, unsigned jobs) {
+    if (!target_machine_) {
+        throw std::runtime_error("No target machine available for object file output");
     }
+    verifyGeneratedModule();
+    applyTargetAttributes();
     
-    return result;
+    // An object built from this exact module before is copied from the cache.
+    // After optimizeModule the key is the one of the IR it started from, which
+    // stays the same whether the pipeline ran or was skipped.
+    std::string cache_entry;
+    if (openObjectCache()) {
+        if (object_cache_key_.empty()) {
+            object_cache_key_ = objectCacheKey();
+        }
+        cache_entry = objectCacheEntry(".o");
+        if (!llvm::sys::fs::copy_file(cache_entry, filename)) {
+            ++object_cache_hits_;
+            return;
+        }
+        ++object_cache_misses_;
+    }
+    emitModuleObject(filename, jobs);
+    if (!cache_entry.empty()) {
+        storeCacheEntry(cache_entry, filename, "");
+    }
 }
 
-void CodeGenContext::declareFunction(const std::string& name, llvm::Function* function) {
-    functions_[name] = function;
+void CodeGenContext::emitModuleObject(const std::string& filename, unsigned jobs) {
+    // Partitions are made with CloneModule, which does not carry ifuncs over,
+    // so multiversioned modules are emitted whole
+    std::string linker;
+    if (jobs > 1 && module_->ifunc_empty()) {
+        if (auto found = llvm::sys::findProgramByName("ld")) {
+            linker = *found;
+        } else {
+            std::cerr << "Warning: no linker (ld) to merge partitions, generating code on one thread"
+                      << std::endl;
+        }
+    }
+    if (linker.empty()) {
+        emitObjectFile(*module_, *target_machine_, filename);
+        return;
+    }
+    
+    // Partitions are cloned into our LLVMContext, which is not thread-safe, so each
+    // one travels to its worker as bitcode and is parsed into a private context
+    std::vector<llvm::SmallString<0>> partitions;
+    llvm::SplitModule(*module_, jobs, [&](std::unique_ptr<llvm::Module> partition) {
+        bool has_definitions = false;
+        for (const auto& function : *partition) {
+            has_definitions |= !function.isDeclaration();
+        }
+        for (const auto& global : partition->globals()) {
+            has_definitions |= !global.isDeclaration();
+        }
+        if (!has_definitions) {
+            return;
+        }
+        partitions.emplace_back();
+        llvm::raw_svector_ostream stream(partitions.back());
+        llvm::WriteBitcodeToFile(*partition, stream);
+    });
+    std::vector<std::string> partition_files;
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        partition_files.push_back(filename + ".part" + std::to_string(i) + ".o");
+    }
+    
+    // Target machines are created up front; workers must not share one
+    std::vector<std::unique_ptr<llvm::TargetMachine>> machines;
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        machines.push_back(createTargetMachine(module_->getTargetTriple()));
+    }
+    
+    std::vector<std::string> errors(partitions.size());
+    llvm::ThreadPool pool(llvm::hardware_concurrency(jobs));
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        pool.async([&, i] {
+            llvm::LLVMContext context;
+#if LLVM_VERSION_MAJOR < 15
+            context.enableOpaquePointers();
+#endif
+            llvm::MemoryBufferRef buffer(partitions[i].str(), "partition" + std::to_string(i));
+            auto partition = llvm::parseBitcodeFile(buffer, context);
+            if (!partition) {
+                errors[i] = llvm::toString(partition.takeError());
+                return;
+            }
+            try {
+                emitObjectFile(**partition, *machines[i], partition_files[i]);
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        });
+    }
+    pool.wait();
+    
+    // Merge the partitions in order so the result does not depend on scheduling.
+    // The linker is run directly, without a shell, so paths need no quoting.
+    std::string error;
+    for (size_t i = 0; i < errors.size() && error.empty(); ++i) {
+        error = errors[i];
+    }
+    if (error.empty()) {
+        std::vector<llvm::StringRef> arguments = {linker, "-r", "-o", filename};
+        arguments.insert(arguments.end(), partition_files.begin(), partition_files.end());
+        std::string message;
+        if (llvm::sys::ExecuteAndWait(linker, arguments, {}, {}, 0, 0, &message) != 0) {
+            error = "failed to merge partitions with " + linker + (message.empty() ? "" : ": " + message);
+        }
+    }
+    for (const auto& partition_file : partition_files) {
+        llvm::sys::fs::remove(partition_file);
+    }
+    if (!error.empty()) {
+        throw std::runtime_error("Object code generation failed: " + error);
+    }
 }
 
-llvm::Function* CodeGenContext::lookupFunction(const std::string& name) {
-    auto it = functions_.find(name);
-    return (it != functions_.end()) ? it->second : nullptr;
+void CodeGenContext::printStats(std::ostream& out) const {
+    out << "=== Code generation statistics ===" << std::endl;
+    unsigned lookups = object_cache_hits_ + object_cache_misses_;
+    if (lookups == 0) {
+        out << "Compilation cache: not used" << std::endl;
+    } else {
+        out << "Compilation cache: " << object_cache_hits_ << " hits, " << object_cache_misses_
+            << " misses (" << (100 * object_cache_hits_ / lookups) << "% hit rate) in "
+            << object_cache_dir_ << std::endl;
+    }
+    if (object_allocation_sites_ > 0) {
+        out << "Object allocations: " << stack_objects_ << " of " << object_allocation_sites_
+            << " `new` sites on the stack" << std::endl;
+    }
+    if (multiversioned_functions_ > 0) {
+        out << "Multiversioned functions: " << multiversioned_functions_
+            << " (AVX-512, AVX2 and baseline, chosen at load time)" << std::endl;
+    }
+    
+    // Object layouts in declaration order (type ids are assigned as types are declared)
+    std::vector<std::pair<int, std::string>> types;
+    for (const auto& [name, id] : type_ids_) {
+        types.emplace_back(id, name);
+    }
+    std::sort(types.begin(), types.end());
+    const llvm::DataLayout& data_layout = module_->getDataLayout();
+    for (const auto& [id, name] : types) {
+        const TypeFields* fields = type_fields_.find(symbols_.find(name));
+        llvm::StructType* const* struct_type = custom_types_.find(symbols_.find(name));
+        if (!fields || !struct_type || (*struct_type)->isOpaque()) continue;
+        
+        const llvm::StructLayout* layout = data_layout.getStructLayout(*struct_type);
+        uint64_t used = 0;
+        for (llvm::Type* element : (*struct_type)->elements()) {
+            used += data_layout.getTypeStoreSize(element);
+        }
+        out << "Type " << name << ": " << layout->getSizeInBytes() << " bytes per object ("
+            << (layout->getSizeInBytes() - used) << " padding)";
+        std::vector<std::pair<uint64_t, std::string>> slots;
+        for (const auto& field : fields->names) {
+            const int* slot = fields->index.find(symbols_.find(field));
+            if (!slot) continue;
+            unsigned element = static_cast<unsigned>(*slot) + kObjectHeaderFields;
+            std::string type_name;
+            llvm::raw_string_ostream type_out(type_name);
+            // Boxed fields print as %hulk.value rather than the struct body
+            (*struct_type)->getElementType(element)->print(type_out, false, true);
+            slots.emplace_back(layout->getElementOffset(element), field + ": " + type_out.str());
+        }
+        std::sort(slots.begin(), slots.end());
+        for (size_t i = 0; i < slots.size(); ++i) {
+            out << (i == 0 ? " - " : ", ") << slots[i].second << " @" << slots[i].first;
+        }
+        out << std::endl;
+    }
 }
 
 void CodeGenContext::dumpIR(const std::string& filename) {
+    verifyGeneratedModule();
     if (filename.empty()) {
         module_->print(llvm::outs(), nullptr);
     } else {
@@ -138,8 +787,218 @@ void CodeGenContext::dumpIR(const std::string& filename) {
     }
 }
 
+void CodeGenContext::enableDebugInfo(const std::string& source_path) {
+    if (di_builder_) {
+        return;
+    }
+    module_->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+    module_->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
+    
+    llvm::SmallString<256> absolute_path(source_path);
+    llvm::sys::fs::make_absolute(absolute_path);
+    di_builder_ = std::make_unique<llvm::DIBuilder>(*module_);
+    di_file_ = di_builder_->createFile(llvm::sys::path::filename(absolute_path),
+                                       llvm::sys::path::parent_path(absolute_path));
+    // DWARF has no language code for HULK; C is what debuggers handle best
+    di_builder_->createCompileUnit(llvm::dwarf::DW_LANG_C, di_file_, "hulk", false, "", 0);
+    
+    // Parameters and results are not described, so every function shares one signature
+    di_function_type_ = di_builder_->createSubroutineType(di_builder_->getOrCreateTypeArray({}));
+}
+
+void CodeGenContext::beginFunctionDebugInfo(llvm::Function* function, const std::string& name, int line) {
+    if (!di_builder_) {
+        return;
+    }
+    unsigned first_line = line > 0 ? line : 0;
+    llvm::DISubprogram* subprogram = di_builder_->createFunction(
+        di_file_, name, function->getName(), di_file_, first_line, di_function_type_, first_line,
+        llvm::DINode::FlagPrototyped, llvm::DISubprogram::SPFlagDefinition);
+    function->setSubprogram(subprogram);
+    builder_->SetCurrentDebugLocation(llvm::DILocation::get(context_, first_line, 0, subprogram));
+}
+
+void CodeGenContext::setDebugLocation(int line, int column) {
+    if (!di_builder_ || line <= 0 || !current_function_) {
+        return;
+    }
+    if (llvm::DISubprogram* subprogram = current_function_->getSubprogram()) {
+        builder_->SetCurrentDebugLocation(
+            llvm::DILocation::get(context_, line, column > 0 ? column : 0, subprogram));
+    }
+}
+
+void CodeGenContext::finalizeDebugInfo() {
+    if (!di_builder_ || di_finalized_) {
+        return;
+    }
+    di_finalized_ = true;
+    
+    // The builder's location outlives the function it was set in, so code
+    // emitted afterwards (constructors, helpers, the next function's prologue)
+    // can carry a line from the wrong subprogram: rescope or drop it
+    for (llvm::Function& function : *module_) {
+        llvm::DISubprogram* subprogram = function.getSubprogram();
+        for (llvm::Instruction& inst : llvm::instructions(function)) {
+            const llvm::DebugLoc& loc = inst.getDebugLoc();
+            if (!subprogram) {
+                if (loc) inst.setDebugLoc(llvm::DebugLoc());
+            } else if (loc ? loc->getScope()->getSubprogram() != subprogram : llvm::isa<llvm::CallBase>(inst)) {
+                // Calls need a location in functions with debug info (for the inliner)
+                inst.setDebugLoc(llvm::DILocation::get(context_, 0, 0, subprogram));
+            }
+        }
+    }
+    builder_->SetCurrentDebugLocation(llvm::DebugLoc());
+    di_builder_->finalize();
+}
+
+void CodeGenContext::setInstrumentation(bool functions, bool branches) {
+    instrument_functions_ = functions || branches;
+    instrument_branches_ = branches;
+    if (instrument_functions_ && !probe_type_) {
+        // Mirrors HulkProbe in hulk_runtime.h
+        llvm::Type* i64 = llvm::Type::getInt64Ty(context_);
+        llvm::Type* i32 = llvm::Type::getInt32Ty(context_);
+        probe_type_ = llvm::StructType::create(
+            context_, {i64, i64, i64, llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_)), i32, i32}, "HulkProbe");
+    }
+}
+
+llvm::GlobalVariable* CodeGenContext::createProbe(const std::string& name, int kind, int line) {
+    llvm::Type* i64 = llvm::Type::getInt64Ty(context_);
+    llvm::Type* i32 = llvm::Type::getInt32Ty(context_);
+    llvm::Constant* zero = llvm::ConstantInt::get(i64, 0);
+    llvm::Constant* init = llvm::ConstantStruct::get(probe_type_, {
+        zero, zero, zero, builder_->CreateGlobalString(name, "probe.name", 0, module_.get()),
+        llvm::ConstantInt::get(i32, kind), llvm::ConstantInt::get(i32, line > 0 ? line : 0)});
+    auto* probe = new llvm::GlobalVariable(*module_, probe_type_, false, llvm::GlobalValue::InternalLinkage,
+                                           init, "probe");
+    probes_.push_back(probe);
+    return probe;
+}
+
+void CodeGenContext::emitProbeIncrement(llvm::IRBuilder<>& builder, llvm::GlobalVariable* probe,
+                                        unsigned field, int64_t delta) {
+    llvm::Type* i64 = llvm::Type::getInt64Ty(context_);
+    llvm::Value* address = builder.CreateStructGEP(probe_type_, probe, field);
+    llvm::Value* value = builder.CreateLoad(i64, address);
+    builder.CreateStore(builder.CreateAdd(value, llvm::ConstantInt::get(i64, delta)), address);
+}
+
+void CodeGenContext::instrumentFunction(llvm::Function* function, const std::string& name, int line) {
+    if (instrument_functions_) {
+        instrumented_functions_.emplace_back(function, createProbe(name, kProbeFunction, line));
+    }
+}
+
+void CodeGenContext::emitBranchProbe(ProbeKind kind, int line) {
+    if (instrument_branches_ && current_function_ && builder_->GetInsertBlock()) {
+        emitProbeIncrement(*builder_, createProbe(current_function_->getName().str(), kind, line), 0, 1);
+    }
+}
+
+size_t CodeGenContext::finalizeInstrumentation(const std::string& table_name) {
+    if (probes_.empty()) {
+        return 0;
+    }
+    llvm::Type* i64 = llvm::Type::getInt64Ty(context_);
+    llvm::Function* read_cycles = llvm::Intrinsic::getDeclaration(module_.get(), llvm::Intrinsic::readcyclecounter);
+    
+    // Entry: count the call and note the time; every return adds the elapsed
+    // cycles once the outermost activation (depth back to 0) leaves
+    for (const auto& [function, probe] : instrumented_functions_) {
+        if (function->empty()) continue;
+        llvm::BasicBlock& entry = function->getEntryBlock();
+        llvm::IRBuilder<> builder(&entry, entry.getFirstInsertionPt());
+        while (llvm::isa<llvm::AllocaInst>(&*builder.GetInsertPoint())) {
+            builder.SetInsertPoint(builder.GetInsertPoint()->getNextNode());
+        }
+        emitProbeIncrement(builder, probe, 0, 1);
+        emitProbeIncrement(builder, probe, 2, 1);
+        llvm::Value* start = builder.CreateCall(read_cycles, {}, "probe.start");
+        
+        std::vector<llvm::ReturnInst*> returns;
+        for (llvm::BasicBlock& block : *function) {
+            if (auto* ret = llvm::dyn_cast_or_null<llvm::ReturnInst>(block.getTerminator())) {
+                returns.push_back(ret);
+            }
+        }
+        for (llvm::ReturnInst* ret : returns) {
+            builder.SetInsertPoint(ret);
+            llvm::Value* now = builder.CreateCall(read_cycles, {});
+            llvm::Value* depth_address = builder.CreateStructGEP(probe_type_, probe, 2);
+            llvm::Value* depth = builder.CreateSub(builder.CreateLoad(i64, depth_address), llvm::ConstantInt::get(i64, 1));
+            builder.CreateStore(depth, depth_address);
+            llvm::Value* elapsed = builder.CreateSelect(
+                builder.CreateICmpEQ(depth, llvm::ConstantInt::get(i64, 0)),
+                builder.CreateSub(now, start), llvm::ConstantInt::get(i64, 0));
+            llvm::Value* cycles_address = builder.CreateStructGEP(probe_type_, probe, 1);
+            builder.CreateStore(builder.CreateAdd(builder.CreateLoad(i64, cycles_address), elapsed), cycles_address);
+        }
+    }
+    
+    llvm::Type* ptr_type = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_));
+    llvm::ArrayType* table_type = llvm::ArrayType::get(ptr_type, probes_.size());
+    std::vector<llvm::Constant*> entries(probes_.begin(), probes_.end());
+    auto* table = new llvm::GlobalVariable(*module_, table_type, true, llvm::GlobalValue::ExternalLinkage,
+                                           llvm::ConstantArray::get(table_type, entries), table_name);
+    size_t probe_count = probes_.size();
+    
+    llvm::Function* main_func = module_->getFunction("main");
+    if (main_func && !main_func->empty()) {
+        llvm::Function* register_func = lookupFunction("hulk_instrument_register");
+        if (!register_func) {
+            register_func = llvm::Function::Create(
+                llvm::FunctionType::get(llvm::Type::getVoidTy(context_), {ptr_type, i64}, false),
+                llvm::Function::ExternalLinkage, "hulk_instrument_register", *module_);
+            declareFunction("hulk_instrument_register", register_func);
+        }
+        llvm::BasicBlock& entry = main_func->getEntryBlock();
+        llvm::IRBuilder<> builder(&entry, entry.getFirstInsertionPt());
+        while (llvm::isa<llvm::AllocaInst>(&*builder.GetInsertPoint())) {
+            builder.SetInsertPoint(builder.GetInsertPoint()->getNextNode());
+        }
+        builder.CreateCall(register_func, {table, llvm::ConstantInt::get(i64, probe_count)});
+    }
+    
+    probes_.clear();
+    instrumented_functions_.clear();
+    return probe_count;
+}
+
 llvm::Value* CodeGenContext::createStringConstant(const std::string& str) {
-    return builder_->CreateGlobalString(str, "str");
+    llvm::GlobalVariable*& pooled = string_constants_[str];
+    if (!pooled) {
+        pooled = builder_->CreateGlobalString(str, "str");
+    }
+    return pooled;
+}
+
+llvm::Value* CodeGenContext::createStringLiteral(const std::string& str) {
+    llvm::GlobalVariable*& pooled = string_literals_[str];
+    if (pooled) {
+        return pooled;
+    }
+    
+    // Character data lives in its own constant; the inline buffer stays unused
+    llvm::Constant* chars_init = llvm::ConstantDataArray::getString(context_, str, true);
+    auto* chars = new llvm::GlobalVariable(
+        *module_, chars_init->getType(), true, llvm::GlobalValue::PrivateLinkage, chars_init, "str");
+    chars->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    chars->setAlignment(llvm::Align(1));
+    
+    // A negative refcount marks the literal as immortal for retain/release
+    llvm::Constant* literal_init = llvm::ConstantStruct::get(string_type_, {
+        llvm::ConstantInt::get(llvm::Type::getInt64Ty(context_), -1, true),
+        llvm::ConstantInt::get(llvm::Type::getInt64Ty(context_), str.size()),
+        chars,
+        llvm::ConstantAggregateZero::get(string_type_->getElementType(3))});
+    auto* literal = new llvm::GlobalVariable(
+        *module_, string_type_, true, llvm::GlobalValue::PrivateLinkage, literal_init, "str.obj");
+    literal->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    pooled = literal;
+    return literal;
 }
 
 llvm::Value* CodeGenContext::createNumberConstant(double value) {
@@ -184,17 +1043,9 @@ void CodeGenContext::createBuiltinFunctions() {
     // Math functions
     auto double_type = llvm::Type::getDoubleTy(context_);
     
-    // sin, cos, sqrt, exp functions
-    std::vector<std::string> unary_math_funcs = {"sin", "cos", "sqrt", "exp"};
-    for (const auto& func_name : unary_math_funcs) {
-        llvm::FunctionType* func_type = llvm::FunctionType::get(double_type, {double_type}, false);
-        llvm::Function* func = llvm::Function::Create(
-            func_type, llvm::Function::ExternalLinkage, func_name, *module_);
-        declareFunction(func_name, func);
-    }
-    
-    // Binary math functions (min, max, pow)
-    std::vector<std::string> binary_math_funcs = {"fmin", "fmax", "pow"};
+    // sin, cos, sqrt, exp, log and pow are lowered to LLVM intrinsics at the call
+    // site, so only the math functions without an intrinsic are declared here
+    std::vector<std::string> binary_math_funcs = {"fmin", "fmax"};
     for (const auto& func_name : binary_math_funcs) {
         llvm::FunctionType* func_type = llvm::FunctionType::get(
             double_type, {double_type, double_type}, false);
@@ -209,68 +1060,184 @@ void CodeGenContext::createBuiltinFunctions() {
         rand_type, llvm::Function::ExternalLinkage, "hulk_rand", *module_);
     declareFunction("hulk_rand", rand_func);
     
-    // String concatenation functions (for your enhanced operators)
+    // String functions from the runtime (all strings are HulkString*)
     auto string_type = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_));
+    auto int_type = llvm::Type::getInt32Ty(context_);
+    auto void_type = llvm::Type::getVoidTy(context_);
+    
+    auto declare_runtime = [this](const std::string& name, llvm::Type* result, std::vector<llvm::Type*> params) {
+        llvm::FunctionType* func_type = llvm::FunctionType::get(result, params, false);
+        llvm::Function* func = llvm::Function::Create(
+            func_type, llvm::Function::ExternalLinkage, name, *module_);
+        declareFunction(name, func);
+    };
+    
+    // String concat (@) and concat with space (@@)
+    declare_runtime("hulk_string_concat", string_type, {string_type, string_type});
+    declare_runtime("hulk_string_concat_space", string_type, {string_type, string_type});
+    declare_runtime("hulk_string_concat_n", string_type, {string_type, llvm::Type::getInt64Ty(context_)});
+    
+    // String equality (C int result)
+    declare_runtime("hulk_string_equal", int_type, {string_type, string_type});
+    
+    // Garbage-collected object heap
+    declare_runtime("hulk_gc_alloc", string_type, {llvm::Type::getInt64Ty(context_)});
+    declare_runtime("hulk_gc_init", void_type, {string_type, llvm::Type::getInt64Ty(context_), string_type});
+    
+    // Reference counting
+    declare_runtime("hulk_string_retain", string_type, {string_type});
+    declare_runtime("hulk_string_release", void_type, {string_type});
     
-    // String concat (@)
-    llvm::FunctionType* concat_type = llvm::FunctionType::get(
-        string_type, {string_type, string_type}, false);
-    llvm::Function* concat_func = llvm::Function::Create(
-        concat_type, llvm::Function::ExternalLinkage, "hulk_str_concat", *module_);
-    declareFunction("hulk_str_concat", concat_func);
-    
-    // String concat with space (@@)
-    llvm::Function* concat_space_func = llvm::Function::Create(
-        concat_type, llvm::Function::ExternalLinkage, "hulk_str_concat_space", *module_);
-    declareFunction("hulk_str_concat_space", concat_space_func);
-    
-    // String equality
-    llvm::FunctionType* str_eq_type = llvm::FunctionType::get(
-        llvm::Type::getInt1Ty(context_), {string_type, string_type}, false);
-    llvm::Function* str_eq_func = llvm::Function::Create(
-        str_eq_type, llvm::Function::ExternalLinkage, "hulk_str_equals", *module_);
-    declareFunction("hulk_str_equals", str_eq_func);
-    
-    // Type conversion functions
-    // Double to string conversion
-    llvm::FunctionType* double_to_str_type = llvm::FunctionType::get(
-        string_type, {double_type}, false);
-    llvm::Function* double_to_str_func = llvm::Function::Create(
-        double_to_str_type, llvm::Function::ExternalLinkage, "hulk_double_to_str", *module_);
-    declareFunction("hulk_double_to_str", double_to_str_func);
-    
-    // Boolean to string conversion
-    llvm::FunctionType* bool_to_str_type = llvm::FunctionType::get(
-        string_type, {llvm::Type::getInt1Ty(context_)}, false);
-    llvm::Function* bool_to_str_func = llvm::Function::Create(
-        bool_to_str_type, llvm::Function::ExternalLinkage, "hulk_bool_to_str", *module_);
-    declareFunction("hulk_bool_to_str", bool_to_str_func);
+    // Type conversion functions (str built-in); booleans are passed as C int
+    declare_runtime("hulk_str_number", string_type, {double_type});
+    declare_runtime("hulk_str_boolean", string_type, {int_type});
+    
+    // Print functions
+    declare_runtime("hulk_print_number", void_type, {double_type});
+    declare_runtime("hulk_print_string", void_type, {string_type});
+    declare_runtime("hulk_print_boolean", void_type, {int_type});
+    declare_runtime("hulk_println", void_type, {});
+    
+    // Dynamic values, passed as (tag, payload)
+    auto i64_type = llvm::Type::getInt64Ty(context_);
+    declare_runtime("hulk_value_pointer_tag", i64_type, {string_type});
+    declare_runtime("hulk_value_to_number", double_type, {i64_type, i64_type});
+    declare_runtime("hulk_value_truthy", int_type, {i64_type, i64_type});
+    declare_runtime("hulk_value_to_string", string_type, {i64_type, i64_type});
+    declare_runtime("hulk_value_to_pointer", string_type, {i64_type, i64_type});
+    declare_runtime("hulk_value_print", void_type, {i64_type, i64_type});
+    declare_runtime("hulk_value_equal", int_type, {i64_type, i64_type, i64_type, i64_type});
+    declare_runtime("hulk_dynamic_error", void_type, {string_type});
+}
+
+llvm::Value* CodeGenContext::boxValue(llvm::Value* value, int pointer_tag) {
+    if (isDynamicValue(value)) return value;
+    llvm::Type* i64_type = builder_->getInt64Ty();
+    llvm::Type* type = value->getType();
+    if (type->isIntegerTy() && !type->isIntegerTy(1)) {
+        value = builder_->CreateSIToFP(value, builder_->getDoubleTy());
+        type = value->getType();
+    }
+    
+    llvm::Value* tag;
+    llvm::Value* payload;
+    if (type->isIntegerTy(1)) {
+        tag = builder_->getInt64(kValueBoolean);
+        payload = builder_->CreateZExt(value, i64_type);
+    } else if (type->isDoubleTy()) {
+        tag = builder_->getInt64(kValueNumber);
+        payload = builder_->CreateBitCast(value, i64_type);
+    } else if (type->isPointerTy()) {
+        tag = pointer_tag >= 0 ? builder_->getInt64(pointer_tag)
+                               : static_cast<llvm::Value*>(builder_->CreateCall(
+                                     lookupFunction("hulk_value_pointer_tag"), {value}, "value_tag"));
+        payload = builder_->CreatePtrToInt(value, i64_type);
+    } else {
+        // void results (e.g. print) box as the number 0
+        tag = builder_->getInt64(kValueNumber);
+        payload = builder_->getInt64(0);
+    }
+    llvm::Value* boxed = builder_->CreateInsertValue(llvm::UndefValue::get(dynamic_value_type_), tag, 0);
+    return builder_->CreateInsertValue(boxed, payload, 1, "boxed");
+}
+
+llvm::Value* CodeGenContext::callDynamicHelper(const std::string& name, llvm::Value* boxed) {
+    llvm::Value* tag = builder_->CreateExtractValue(boxed, 0, "tag");
+    llvm::Value* payload = builder_->CreateExtractValue(boxed, 1, "payload");
+    return builder_->CreateCall(lookupFunction(name), {tag, payload});
+}
+
+llvm::Value* CodeGenContext::unboxValue(llvm::Value* boxed, llvm::Type* type) {
+    if (type == dynamic_value_type_) return boxed;
+    if (type->isDoubleTy()) {
+        return callDynamicHelper("hulk_value_to_number", boxed);
+    }
+    if (type->isIntegerTy(1)) {
+        return builder_->CreateICmpNE(callDynamicHelper("hulk_value_truthy", boxed), builder_->getInt32(0));
+    }
+    if (type->isIntegerTy()) {
+        return builder_->CreateZExt(
+            builder_->CreateICmpNE(callDynamicHelper("hulk_value_truthy", boxed), builder_->getInt32(0)), type);
+    }
+    if (type->isPointerTy()) {
+        return callDynamicHelper("hulk_value_to_pointer", boxed);
+    }
+    return llvm::UndefValue::get(type);
+}
+
+llvm::Value* CodeGenContext::coerceValue(llvm::Value* value, llvm::Type* type) {
+    llvm::Type* from = value->getType();
+    if (from == type) return value;
+    if (type == dynamic_value_type_) return boxValue(value);
+    if (from == dynamic_value_type_) return unboxValue(value, type);
+    if (type->isDoubleTy() && from->isIntegerTy()) {
+        return from->isIntegerTy(1) ? builder_->CreateUIToFP(value, type) : builder_->CreateSIToFP(value, type);
+    }
+    if (type->isIntegerTy(1) && from->isDoubleTy()) {
+        return builder_->CreateFCmpONE(value, llvm::ConstantFP::get(from, 0.0));
+    }
+    return unboxValue(boxValue(value), type);
+}
+
+void CodeGenContext::emitDynamicError(const std::string& message) {
+    builder_->CreateCall(lookupFunction("hulk_dynamic_error"), {createStringConstant(message)});
 }
 
 // Type management methods
-void CodeGenContext::declareType(const std::string& name, llvm::StructType* type, const std::vector<std::string>& field_names) {
-    custom_types_[name] = type;
-    type_fields_[name] = field_names;
+void CodeGenContext::declareType(const std::string& name, llvm::StructType* type, const std::vector<std::string>& field_names,
+                                 const std::vector<int>& field_slots) {
+    SymbolInterner::Symbol symbol = symbols_.intern(name);
+    custom_types_[symbol] = type;
+    
+    TypeFields& fields = type_fields_[symbol];
+    fields.names = field_names;
+    fields.index = SymbolMap<int>();
+    for (size_t i = 0; i < field_names.size(); ++i) {
+        int slot = i < field_slots.size() ? field_slots[i] : static_cast<int>(i);
+        fields.index[symbols_.intern(field_names[i])] = slot;
+    }
+    
+    // The parent's layout is a prefix of this one (see LLVMCodeGenerator::createStructForType)
+    llvm::StructType* parent = lookupType(getParentType(name));
+    layout_parents_[type] = parent && parent != type && parent->getNumElements() <= type->getNumElements()
+                                ? parent
+                                : object_header_type_;
+    
+    // Type ids start at 1 so that a zeroed header never matches a real type
+    if (type_ids_.find(name) == type_ids_.end()) {
+        int next_id = static_cast<int>(type_ids_.size()) + 1;
+        type_ids_[name] = next_id;
+    }
 }
 
 llvm::StructType* CodeGenContext::lookupType(const std::string& name) {
-    auto it = custom_types_.find(name);
-    return (it != custom_types_.end()) ? it->second : nullptr;
+    llvm::StructType** type = custom_types_.find(symbols_.find(name));
+    return type ? *type : nullptr;
 }
 
-std::vector<std::string> CodeGenContext::getTypeFields(const std::string& name) {
-    auto it = type_fields_.find(name);
-    return (it != type_fields_.end()) ? it->second : std::vector<std::string>();
+const std::vector<std::string>& CodeGenContext::getTypeFields(const std::string& name) const {
+    static const std::vector<std::string> no_fields;
+    const TypeFields* fields = type_fields_.find(symbols_.find(name));
+    return fields ? fields->names : no_fields;
 }
 
 int CodeGenContext::getFieldIndex(const std::string& type_name, const std::string& field_name) {
-    auto fields = getTypeFields(type_name);
-    for (size_t i = 0; i < fields.size(); ++i) {
-        if (fields[i] == field_name) {
-            return static_cast<int>(i);
-        }
+    const TypeFields* fields = type_fields_.find(symbols_.find(type_name));
+    if (!fields) {
+        return -1;
     }
-    return -1; // Field not found
+    const int* index = fields->index.find(symbols_.find(field_name));
+    // User fields come after the object header
+    return index ? *index + static_cast<int>(kObjectHeaderFields) : -1;
+}
+
+std::vector<std::string> CodeGenContext::getAllTypeNames() const {
+    std::vector<std::string> types;
+    custom_types_.forEach([&](SymbolInterner::Symbol symbol, llvm::StructType*) {
+        types.push_back(symbols_.name(symbol));
+    });
+    std::sort(types.begin(), types.end());
+    return types;
 }
 
 // Type management helper methods
@@ -290,13 +1257,122 @@ llvm::Type* CodeGenContext::getFieldType(const std::string& type_name, int field
     return struct_type->getElementType(static_cast<unsigned>(field_index));
 }
 
+llvm::Type* CodeGenContext::getFieldValueType(llvm::Type* storage_type) {
+    if (storage_type && storage_type->isIntegerTy(8)) {
+        return llvm::Type::getInt1Ty(storage_type->getContext());
+    }
+    return storage_type;
+}
+
+llvm::Value* CodeGenContext::loadField(llvm::StructType* type, llvm::Value* object, int field_index,
+                                       const std::string& name) {
+    llvm::Type* storage_type = type->getElementType(static_cast<unsigned>(field_index));
+    llvm::Value* field_ptr = builder_->CreateStructGEP(type, object, static_cast<unsigned>(field_index), name + "_ptr");
+    llvm::LoadInst* value = builder_->CreateLoad(storage_type, field_ptr, name);
+    tagFieldAccess(value, type, static_cast<unsigned>(field_index));
+    if (storage_type->isIntegerTy(8)) {
+        return builder_->CreateICmpNE(value, llvm::ConstantInt::get(storage_type, 0), name + "_bool");
+    }
+    return value;
+}
+
+void CodeGenContext::storeField(llvm::StructType* type, llvm::Value* object, int field_index, llvm::Value* value,
+                                const std::string& name) {
+    llvm::Type* storage_type = type->getElementType(static_cast<unsigned>(field_index));
+    llvm::Value* field_ptr = builder_->CreateStructGEP(type, object, static_cast<unsigned>(field_index), name + "_ptr");
+    if (isDynamicValue(value)) {
+        value = unboxValue(value, getFieldValueType(storage_type));
+    }
+    llvm::Type* value_type = value->getType();
+    if (storage_type->isIntegerTy(8) && value_type != storage_type) {
+        // Booleans: any other representation is normalized to 0/1
+        if (value_type->isDoubleTy()) {
+            value = builder_->CreateFCmpONE(value, llvm::ConstantFP::get(value_type, 0.0));
+        } else if (value_type->isIntegerTy() && !value_type->isIntegerTy(1)) {
+            value = builder_->CreateICmpNE(value, llvm::ConstantInt::get(value_type, 0));
+        } else if (value_type->isPointerTy()) {
+            value = builder_->CreateIsNotNull(value);
+        }
+        if (value->getType()->isIntegerTy(1)) {
+            value = builder_->CreateZExt(value, storage_type);
+        }
+    } else if (storage_type->isDoubleTy() && value_type->isIntegerTy()) {
+        value = value_type->isIntegerTy(1) ? builder_->CreateUIToFP(value, storage_type)
+                                           : builder_->CreateSIToFP(value, storage_type);
+    }
+    tagFieldAccess(builder_->CreateStore(value, field_ptr), type, static_cast<unsigned>(field_index));
+}
+
+llvm::MDNode* CodeGenContext::getTBAAScalarNode(llvm::Type* type) {
+    llvm::MDBuilder md(context_);
+    if (!tbaa_root_) {
+        tbaa_root_ = md.createTBAARoot("HULK TBAA");
+        tbaa_scalars_[nullptr] = md.createTBAAScalarTypeNode("any field", tbaa_root_);
+    }
+    const char* name = type->isDoubleTy()      ? "Number"
+                       : type->isIntegerTy(8)  ? "Boolean"
+                       : type->isIntegerTy(32) ? "type id"
+                       : type->isPointerTy()   ? "pointer"
+                                               : nullptr;
+    if (!name) {
+        return tbaa_scalars_[nullptr];
+    }
+    llvm::MDNode*& node = tbaa_scalars_[type];
+    if (!node) {
+        node = md.createTBAAScalarTypeNode(name, tbaa_scalars_[nullptr]);
+    }
+    return node;
+}
+
+llvm::MDNode* CodeGenContext::getTBAAStructNode(llvm::StructType* type) {
+    auto cached = tbaa_structs_.find(type);
+    if (cached != tbaa_structs_.end()) {
+        return cached->second;
+    }
+    const llvm::StructLayout* layout = module_->getDataLayout().getStructLayout(type);
+    std::vector<std::pair<llvm::MDNode*, uint64_t>> fields;
+    unsigned first_own_field = 0;
+    auto parent = layout_parents_.find(type);
+    if (parent != layout_parents_.end()) {
+        fields.emplace_back(getTBAAStructNode(parent->second), 0);
+        first_own_field = parent->second->getNumElements();
+    }
+    for (unsigned i = first_own_field; i < type->getNumElements(); ++i) {
+        fields.emplace_back(getTBAAScalarNode(type->getElementType(i)), layout->getElementOffset(i));
+    }
+    llvm::MDNode* node = llvm::MDBuilder(context_).createTBAAStructTypeNode(type->getName(), fields);
+    tbaa_structs_[type] = node;
+    return node;
+}
+
+void CodeGenContext::tagFieldAccess(llvm::Instruction* access, llvm::StructType* type, unsigned field_index) {
+    // A store to one field can then only clobber that field of objects whose
+    // layout shares it (the same type, its ancestors or its descendants)
+    uint64_t offset = module_->getDataLayout().getStructLayout(type)->getElementOffset(field_index);
+    llvm::MDNode* tag = llvm::MDBuilder(context_).createTBAAStructTagNode(
+        getTBAAStructNode(type), getTBAAScalarNode(type->getElementType(field_index)), offset);
+    access->setMetadata(llvm::LLVMContext::MD_tbaa, tag);
+}
+
+void CodeGenContext::markSelfParameter(llvm::Function* method, llvm::StructType* type, bool fresh) {
+    const llvm::DataLayout& data_layout = module_->getDataLayout();
+    llvm::Argument* self = method->getArg(0);
+    self->addAttr(llvm::Attribute::NonNull);
+    self->addAttr(llvm::Attribute::getWithDereferenceableBytes(context_, data_layout.getTypeAllocSize(type)));
+    self->addAttr(llvm::Attribute::getWithAlignment(context_, data_layout.getABITypeAlign(type)));
+    if (fresh) {
+        self->addAttr(llvm::Attribute::NoAlias);
+    }
+}
+
 // Virtual table management methods
 void CodeGenContext::createVTable(const std::string& type_name, const std::vector<std::string>& method_names) {
     // Create array type for vtable (array of function pointers)
     llvm::Type* func_ptr_type = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_));
     llvm::ArrayType* vtable_type = llvm::ArrayType::get(func_ptr_type, method_names.size());
     
-    // Create vtable as global variable
+    // The initializer is filled in by finalizeVTables() once every method body exists;
+    // until then the global is only a declaration that allocations can reference
     std::string vtable_name = type_name + "_vtable";
     llvm::GlobalVariable* vtable = new llvm::GlobalVariable(
         *module_, vtable_type, true, // isConstant = true
@@ -311,6 +1387,142 @@ llvm::GlobalVariable* CodeGenContext::getVTable(const std::string& type_name) {
     return (it != vtables_.end()) ? it->second : nullptr;
 }
 
+const std::vector<std::string>& CodeGenContext::getVTableLayout(const std::string& type_name) const {
+    static const std::vector<std::string> empty_layout;
+    auto it = virtual_methods_.find(type_name);
+    return (it != virtual_methods_.end()) ? it->second : empty_layout;
+}
+
+int CodeGenContext::getVTableSlot(const std::string& type_name, const std::string& method_name) const {
+    const auto& layout = getVTableLayout(type_name);
+    for (size_t i = 0; i < layout.size(); ++i) {
+        if (layout[i] == method_name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1; // Method not in this type's vtable
+}
+
+llvm::Function* CodeGenContext::resolveMethod(const std::string& type_name, const std::string& method_name) {
+    // Walk up the inheritance chain until a type implements the method
+    std::string current = type_name;
+    while (!current.empty()) {
+        llvm::Function* method = lookupFunction(current + "_" + method_name);
+        if (method) {
+            return method;
+        }
+        current = getParentType(current);
+    }
+    return nullptr;
+}
+
+void CodeGenContext::finalizeVTables() {
+    llvm::PointerType* func_ptr_type = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_));
+    
+    for (auto& entry : vtables_) {
+        const std::string& type_name = entry.first;
+        llvm::GlobalVariable* vtable = entry.second;
+        if (vtable->hasInitializer()) {
+            continue;
+        }
+        
+        // Each slot points at the most derived implementation visible from this type
+        std::vector<llvm::Constant*> slots;
+        for (const auto& method_name : getVTableLayout(type_name)) {
+            llvm::Function* method = resolveMethod(type_name, method_name);
+            if (method) {
+                slots.push_back(llvm::ConstantExpr::getBitCast(method, func_ptr_type));
+            } else {
+                slots.push_back(llvm::ConstantPointerNull::get(func_ptr_type));
+            }
+        }
+        
+        auto* vtable_type = llvm::cast<llvm::ArrayType>(vtable->getValueType());
+        vtable->setInitializer(llvm::ConstantArray::get(vtable_type, slots));
+        vtable->setLinkage(llvm::GlobalValue::PrivateLinkage);
+        vtable->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    }
+}
+
+llvm::GlobalVariable* CodeGenContext::createTypeLayoutTable() {
+    // { i64 size, i64 pointer_count, ptr pointer_offsets, i64 tagged_count,
+    //   ptr tagged_offsets }, mirrors HulkTypeLayout
+    llvm::Type* i64_type = llvm::Type::getInt64Ty(context_);
+    llvm::PointerType* ptr_type = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_));
+    llvm::StructType* layout_type = llvm::StructType::get(
+        context_, {i64_type, i64_type, ptr_type, i64_type, ptr_type});
+    
+    // Entries are indexed by type id; id 0 stays empty
+    std::vector<llvm::Constant*> entries(type_ids_.size() + 1, llvm::ConstantAggregateZero::get(layout_type));
+    const llvm::DataLayout& data_layout = module_->getDataLayout();
+    
+    // Private i64 array of field offsets, or null when there are none
+    auto offsets_table = [&](const std::vector<llvm::Constant*>& offsets, const std::string& name) -> llvm::Constant* {
+        if (offsets.empty()) {
+            return llvm::ConstantPointerNull::get(ptr_type);
+        }
+        llvm::ArrayType* offsets_type = llvm::ArrayType::get(i64_type, offsets.size());
+        return new llvm::GlobalVariable(
+            *module_, offsets_type, true, llvm::GlobalValue::PrivateLinkage,
+            llvm::ConstantArray::get(offsets_type, offsets), name);
+    };
+    
+    for (const auto& entry : type_ids_) {
+        llvm::StructType* struct_type = lookupType(entry.first);
+        if (!struct_type) {
+            continue;
+        }
+        
+        // Pointer fields after the header may reference other objects; boxed
+        // fields do when their tag says string or object
+        const llvm::StructLayout* struct_layout = data_layout.getStructLayout(struct_type);
+        std::vector<llvm::Constant*> offsets;
+        std::vector<llvm::Constant*> tagged_offsets;
+        for (unsigned i = kObjectHeaderFields; i < struct_type->getNumElements(); ++i) {
+            llvm::Type* element_type = struct_type->getElementType(i);
+            llvm::Constant* offset = llvm::ConstantInt::get(i64_type, struct_layout->getElementOffset(i));
+            if (element_type->isPointerTy()) {
+                offsets.push_back(offset);
+            } else if (element_type == dynamic_value_type_) {
+                tagged_offsets.push_back(offset);
+            }
+        }
+        
+        entries[entry.second] = llvm::ConstantStruct::get(layout_type, {
+            llvm::ConstantInt::get(i64_type, data_layout.getTypeAllocSize(struct_type)),
+            llvm::ConstantInt::get(i64_type, offsets.size()),
+            offsets_table(offsets, entry.first + "_pointer_offsets"),
+            llvm::ConstantInt::get(i64_type, tagged_offsets.size()),
+            offsets_table(tagged_offsets, entry.first + "_tagged_offsets")});
+    }
+    
+    llvm::ArrayType* table_type = llvm::ArrayType::get(layout_type, entries.size());
+    return new llvm::GlobalVariable(
+        *module_, table_type, true, llvm::GlobalValue::PrivateLinkage,
+        llvm::ConstantArray::get(table_type, entries), "hulk_type_layouts");
+}
+
+int CodeGenContext::getTypeId(const std::string& type_name) const {
+    auto it = type_ids_.find(type_name);
+    return (it != type_ids_.end()) ? it->second : 0;
+}
+
+llvm::Value* CodeGenContext::loadTypeId(llvm::Value* object) {
+    llvm::Value* id_ptr = builder_->CreateStructGEP(object_header_type_, object, 0, "type_id_ptr");
+    llvm::LoadInst* type_id = builder_->CreateLoad(llvm::Type::getInt32Ty(context_), id_ptr, "type_id");
+    tagFieldAccess(type_id, object_header_type_, 0);
+    return type_id;
+}
+
+llvm::Value* CodeGenContext::loadVTableSlot(llvm::Value* object, int slot) {
+    llvm::Type* ptr_type = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_));
+    llvm::Value* vtable_ptr = builder_->CreateStructGEP(object_header_type_, object, 1, "vtable_ptr");
+    llvm::LoadInst* vtable = builder_->CreateLoad(ptr_type, vtable_ptr, "vtable");
+    tagFieldAccess(vtable, object_header_type_, 1);
+    llvm::Value* slot_ptr = builder_->CreateConstInBoundsGEP1_32(ptr_type, vtable, static_cast<unsigned>(slot), "slot_ptr");
+    return builder_->CreateLoad(ptr_type, slot_ptr, "method_ptr");
+}
+
 // Memory management helper methods
 llvm::Value* CodeGenContext::createObjectAllocation(const std::string& type_name) {
     llvm::StructType* struct_type = lookupType(type_name);
@@ -321,24 +1533,213 @@ llvm::Value* CodeGenContext::createObjectAllocation(const std::string& type_name
     const llvm::DataLayout& data_layout = module_->getDataLayout();
     uint64_t type_size = data_layout.getTypeAllocSize(struct_type);
     
-    // Create malloc call
-    llvm::Function* malloc_func = lookupFunction("malloc");
-    if (!malloc_func) {
-        // Declare malloc if not already declared
-        llvm::FunctionType* malloc_type = llvm::FunctionType::get(
-            llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_)),
-            {llvm::Type::getInt64Ty(context_)}, false);
-        malloc_func = llvm::Function::Create(
-            malloc_type, llvm::Function::ExternalLinkage, "malloc", *module_);
-        declareFunction("malloc", malloc_func);
-    }
-    
-    // Create malloc call with proper size
+    // Objects live on the collected heap (zero-filled by the runtime)
+    llvm::Function* alloc_func = lookupFunction("hulk_gc_alloc");
     llvm::Value* size_val = llvm::ConstantInt::get(context_, llvm::APInt(64, type_size));
-    llvm::Value* allocated_ptr = builder_->CreateCall(malloc_func, {size_val});
+    llvm::CallInst* allocated_ptr = builder_->CreateCall(alloc_func, {size_val});
+    object_allocations_.emplace_back(allocated_ptr, struct_type);
+    ++object_allocation_sites_;
     
     // Cast to proper type
-    return builder_->CreateBitCast(allocated_ptr, llvm::PointerType::getUnqual(struct_type));
+    llvm::Value* object = builder_->CreateBitCast(allocated_ptr, llvm::PointerType::getUnqual(struct_type));
+    
+    // Fill in the object header so dynamic dispatch can find the real type
+    llvm::Value* id_ptr = builder_->CreateStructGEP(struct_type, object, 0, "type_id_ptr");
+    tagFieldAccess(builder_->CreateStore(
+                       llvm::ConstantInt::get(llvm::Type::getInt32Ty(context_), getTypeId(type_name)), id_ptr),
+                   struct_type, 0);
+    
+    llvm::Value* vtable_ptr = builder_->CreateStructGEP(struct_type, object, 1, "vtable_ptr");
+    llvm::Value* vtable = getVTable(type_name);
+    if (!vtable) {
+        vtable = llvm::ConstantPointerNull::get(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_)));
+    }
+    tagFieldAccess(builder_->CreateStore(vtable, vtable_ptr), struct_type, 1);
+    
+    return object;
+}
+
+namespace {
+
+// What a defined function does with one of its pointer parameters
+struct ParamEscape {
+    bool captured = false; // may outlive the call (stored away, passed to unknown code)
+    bool returned = false; // may be the return value
+};
+using ParamEscapeMap = std::map<llvm::Argument*, ParamEscape>;
+
+/**
+ * @brief Follows every use of an object pointer to decide whether it escapes
+ *
+ * Aliases hold the object pointer itself: casts, results of calls that
+ * return the pointer they were given, and loads from private slots (allocas
+ * only ever loaded from or stored to, i.e. `let` variables). Addresses are
+ * pointers into the object (field GEPs) and may only be loaded or stored through.
+ */
+class ObjectEscapeWalker {
+public:
+    ObjectEscapeWalker(const ParamEscapeMap& params, bool allow_return)
+        : params_(params), allow_return_(allow_return) {}
+    
+    // False if the object may escape
+    bool walk(llvm::Value* root) {
+        std::vector<std::pair<llvm::Value*, bool>> worklist{{root, true}};
+        llvm::SmallPtrSet<llvm::Value*, 16> visited{root};
+        auto follow = [&](llvm::Value* value, bool is_alias) {
+            if (visited.insert(value).second) worklist.emplace_back(value, is_alias);
+        };
+        
+        while (!worklist.empty()) {
+            auto [value, is_alias] = worklist.back();
+            worklist.pop_back();
+            if (auto* inst = llvm::dyn_cast<llvm::Instruction>(value)) {
+                derived.push_back(inst);
+            }
+            
+            for (llvm::Use& use : value->uses()) {
+                auto* user = llvm::dyn_cast<llvm::Instruction>(use.getUser());
+                if (!user) return false;
+                
+                if (llvm::isa<llvm::LoadInst>(user) || llvm::isa<llvm::ICmpInst>(user)) {
+                    continue;
+                }
+                if (auto* store = llvm::dyn_cast<llvm::StoreInst>(user)) {
+                    if (use.getOperandNo() == llvm::StoreInst::getPointerOperandIndex()) continue;
+                    auto* slot = llvm::dyn_cast<llvm::AllocaInst>(store->getPointerOperand());
+                    if (!is_alias || !slot || !isPrivateSlot(slot)) return false;
+                    if (slots.insert(slot).second) {
+                        for (llvm::User* slot_user : slot->users()) {
+                            if (auto* load = llvm::dyn_cast<llvm::LoadInst>(slot_user)) follow(load, true);
+                        }
+                    }
+                    continue;
+                }
+                if (llvm::isa<llvm::GetElementPtrInst>(user)) {
+                    if (use.getOperandNo() != 0) return false;
+                    follow(user, false);
+                    continue;
+                }
+                if (llvm::isa<llvm::BitCastInst>(user)) {
+                    follow(user, is_alias);
+                    continue;
+                }
+                if (llvm::isa<llvm::ReturnInst>(user)) {
+                    if (!allow_return_ || !is_alias) return false;
+                    returned = true;
+                    continue;
+                }
+                if (auto* call = llvm::dyn_cast<llvm::CallInst>(user)) {
+                    if (llvm::isa<llvm::DbgInfoIntrinsic>(call) || call->isLifetimeStartOrEnd()) continue;
+                    llvm::Function* callee = call->getCalledFunction();
+                    if (!callee || callee->isDeclaration() || !call->isArgOperand(&use)) return false;
+                    auto param = params_.find(callee->getArg(call->getArgOperandNo(&use)));
+                    if (param == params_.end() || param->second.captured) return false;
+                    if (param->second.returned) {
+                        if (!is_alias) return false;
+                        follow(call, true);
+                    }
+                    continue;
+                }
+                return false; // phi, select, ptrtoint, invoke, ...
+            }
+        }
+        return true;
+    }
+    
+    bool returned = false;                          // reaches a ret (only with allow_return)
+    std::vector<llvm::Instruction*> derived;        // aliases and addresses
+    llvm::SmallPtrSet<llvm::AllocaInst*, 4> slots;  // private slots the object is stored in
+    
+private:
+    static bool isPrivateSlot(llvm::AllocaInst* slot) {
+        for (llvm::Use& use : slot->uses()) {
+            auto* store = llvm::dyn_cast<llvm::StoreInst>(use.getUser());
+            bool stored_to = store && use.getOperandNo() == llvm::StoreInst::getPointerOperandIndex();
+            if (!stored_to && !llvm::isa<llvm::LoadInst>(use.getUser())) return false;
+        }
+        return true;
+    }
+    
+    const ParamEscapeMap& params_;
+    bool allow_return_;
+};
+
+bool isInCycle(llvm::BasicBlock* block) {
+    std::vector<llvm::BasicBlock*> worklist(llvm::succ_begin(block), llvm::succ_end(block));
+    llvm::SmallPtrSet<llvm::BasicBlock*, 16> visited;
+    while (!worklist.empty()) {
+        llvm::BasicBlock* current = worklist.back();
+        worklist.pop_back();
+        if (current == block) return true;
+        if (!visited.insert(current).second) continue;
+        worklist.insert(worklist.end(), llvm::succ_begin(current), llvm::succ_end(current));
+    }
+    return false;
+}
+
+} // namespace
+
+size_t CodeGenContext::stackAllocateObjects() {
+    // Summaries for the pointer parameters of every defined function, refined
+    // to a fixed point (optimistically, so recursion does not force an escape)
+    ParamEscapeMap params;
+    for (llvm::Function& function : *module_) {
+        if (function.isDeclaration()) continue;
+        for (llvm::Argument& arg : function.args()) {
+            if (arg.getType()->isPointerTy()) params[&arg];
+        }
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto& [arg, escape] : params) {
+            if (escape.captured) continue;
+            ObjectEscapeWalker walker(params, true);
+            if (!walker.walk(arg)) {
+                escape.captured = true;
+                changed = true;
+            } else if (walker.returned && !escape.returned) {
+                escape.returned = true;
+                changed = true;
+            }
+        }
+    }
+    
+    size_t moved = 0;
+    for (auto& [allocation, type] : object_allocations_) {
+        ObjectEscapeWalker walker(params, false);
+        if (!walker.walk(allocation)) continue;
+        
+        // Inside a loop every iteration reuses the same stack object, so the
+        // previous one must be dead by then: it may live in at most one
+        // variable, and no pointer to it may be held across the allocation
+        if (isInCycle(allocation->getParent())) {
+            if (walker.slots.size() > 1) continue;
+            bool overlaps = false;
+            for (llvm::Instruction* def : walker.derived) {
+                for (llvm::User* user : def->users()) {
+                    auto* use = llvm::cast<llvm::Instruction>(user);
+                    overlaps |= use->getParent() != def->getParent() ||
+                                (allocation->getParent() == def->getParent() && def->comesBefore(allocation) &&
+                                 allocation->comesBefore(use));
+                }
+            }
+            if (overlaps) continue;
+        }
+        
+        llvm::BasicBlock& entry = allocation->getFunction()->getEntryBlock();
+        llvm::IRBuilder<> entry_builder(&entry, entry.getFirstInsertionPt());
+        llvm::AllocaInst* object = entry_builder.CreateAlloca(type, nullptr, "stack_object");
+        
+        // Zero-filled on every execution, like the collector's blocks
+        llvm::IRBuilder<> builder(allocation);
+        builder.CreateStore(llvm::Constant::getNullValue(type), object);
+        allocation->replaceAllUsesWith(object);
+        allocation->eraseFromParent();
+        ++moved;
+    }
+    object_allocations_.clear();
+    stack_objects_ += moved;
+    return moved;
 }
 
 llvm::Constant* CodeGenContext::getTypeSize(const std::string& type_name) {    llvm::StructType* struct_type = lookupType(type_name);
@@ -353,12 +1754,12 @@ llvm::Constant* CodeGenContext::getTypeSize(const std::string& type_name) {    l
 
 // Dynamic type management methods
 void CodeGenContext::declareVariableType(const std::string& name, const std::string& type) {
-    variable_types_[name] = type;
+    variable_types_[symbols_.intern(name)] = type;
 }
 
 std::string CodeGenContext::getVariableType(const std::string& name) const {
-    auto it = variable_types_.find(name);
-    return (it != variable_types_.end()) ? it->second : "";
+    const std::string* type = variable_types_.find(symbols_.find(name));
+    return type ? *type : "";
 }
 
 void CodeGenContext::addLetVariable(const std::string& name, const std::string& type) {
@@ -377,4 +1778,13 @@ void CodeGenContext::declareInheritance(const std::string& child, const std::str
 std::string CodeGenContext::getParentType(const std::string& child) const {
     auto it = inheritance_map_.find(child);
     return (it != inheritance_map_.end()) ? it->second : "";
+}
+
+bool CodeGenContext::hasSubtypes(const std::string& type_name) const {
+    for (const auto& pair : inheritance_map_) {
+        if (pair.second == type_name) {
+            return true;
+        }
+    }
+    return false;
 }
\ No newline at end of file
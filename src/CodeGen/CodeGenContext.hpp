@@ -5,6 +5,9 @@
 #include "llvm/IR/Value.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/DIBuilder.h"
+#include "llvm/Target/TargetMachine.h"
+#include "SymbolTable.hpp"
 #include <string>
 #include <map>
 #include <vector>
@@ -27,19 +30,49 @@ class CodeGenContext {
 private:
     llvm::LLVMContext context_;
     std::unique_ptr<llvm::Module> module_;
+    std::unique_ptr<llvm::Module> uncached_module_; // replaced by a cache hit; the generator still points into it
     std::unique_ptr<llvm::IRBuilder<>> builder_;
+    std::unique_ptr<llvm::TargetMachine> target_machine_; // host target, null if unavailable
+    unsigned opt_level_ = 0;
+    bool target_cpu_set_ = false;       // --march: functions carry target-cpu/target-features
+    size_t multiversioned_functions_ = 0;
     
-    // Symbol tables
-    std::stack<std::map<std::string, llvm::Value*>> variable_stack_;
-    std::map<std::string, llvm::Function*> functions_;
+    // Compilation cache (opt-in, empty dir = disabled): optimized modules keyed by
+    // the IR before optimization, and objects keyed by the IR they were built from,
+    // each hashed along with everything else that affects the result
+    std::string object_cache_dir_;
+    std::string object_cache_key_; // hash of the module as generated, set on first use
+    unsigned object_cache_hits_ = 0;
+    unsigned object_cache_misses_ = 0;
+    
+    // Symbol tables, keyed by interned names
+    SymbolInterner symbols_;
+    ScopedSymbolTable<llvm::Value*> variables_{symbols_};
+    SymbolMap<llvm::Function*> functions_;
     
     // Type management for custom types (structs)
-    std::map<std::string, llvm::StructType*> custom_types_;
-    std::map<std::string, std::vector<std::string>> type_fields_; // field names for each type
+    struct TypeFields {
+        std::vector<std::string> names; // declaration order, inherited fields first
+        SymbolMap<int> index;           // field name -> struct element (after the header)
+    };
+    SymbolMap<llvm::StructType*> custom_types_;
+    SymbolMap<TypeFields> type_fields_;
     
     // Virtual table management for polymorphism
     std::map<std::string, llvm::GlobalVariable*> vtables_;
-    std::map<std::string, std::vector<std::string>> virtual_methods_; // method names for each type
+    std::map<std::string, std::vector<std::string>> virtual_methods_; // slot layout for each type
+    std::map<std::string, int> type_ids_; // runtime type id stored in every object header
+    llvm::StructType* object_header_type_;
+    
+    // Runtime string layout (mirrors HulkString in hulk_runtime.h)
+    llvm::StructType* string_type_;
+    
+    // Dynamic value layout (mirrors HulkValue): { i64 tag, i64 payload }
+    llvm::StructType* dynamic_value_type_;
+    
+    // Module-wide literal pools: one global per distinct text
+    std::map<std::string, llvm::GlobalVariable*> string_literals_;
+    std::map<std::string, llvm::GlobalVariable*> string_constants_;
     
     // Value stack for expressions
     std::stack<llvm::Value*> value_stack_;
@@ -52,7 +85,7 @@ private:
     std::string current_type_;
     
     // Symbol table for variable types (variable_name -> type_name)
-    std::map<std::string, std::string> variable_types_;
+    SymbolMap<std::string> variable_types_;
     
     // Track let expressions for proper main generation
     std::vector<std::pair<std::string, std::string>> let_variables_; // (var_name, type_name)
@@ -60,8 +93,49 @@ private:
     // Track inheritance relationships (child -> parent)
     std::map<std::string, std::string> inheritance_map_;
     
+    // Type-based alias analysis: one struct-path node per object layout, whose
+    // subobject at offset 0 is the parent's layout (or the bare header)
+    llvm::MDNode* tbaa_root_ = nullptr;
+    std::map<llvm::Type*, llvm::MDNode*> tbaa_scalars_;  // null key = any field
+    std::map<llvm::StructType*, llvm::MDNode*> tbaa_structs_;
+    std::map<llvm::StructType*, llvm::StructType*> layout_parents_;
+    llvm::MDNode* getTBAAScalarNode(llvm::Type* type);
+    llvm::MDNode* getTBAAStructNode(llvm::StructType* type);
+    void tagFieldAccess(llvm::Instruction* access, llvm::StructType* type, unsigned field_index);
+    
+    // DWARF debug info (-g); null when disabled
+    std::unique_ptr<llvm::DIBuilder> di_builder_;
+    llvm::DIFile* di_file_ = nullptr;
+    llvm::DISubroutineType* di_function_type_ = nullptr;
+    bool di_finalized_ = false;
+    
+    // `new` sites still on the heap, and how many were moved to the stack
+    std::vector<std::pair<llvm::CallInst*, llvm::StructType*>> object_allocations_;
+    size_t object_allocation_sites_ = 0;
+    size_t stack_objects_ = 0;
+    
+    // Instrumentation (--instrument): one HulkProbe global per probe
+    bool instrument_functions_ = false;
+    bool instrument_branches_ = false;
+    llvm::StructType* probe_type_ = nullptr;
+    std::vector<llvm::GlobalVariable*> probes_;
+    std::vector<std::pair<llvm::Function*, llvm::GlobalVariable*>> instrumented_functions_;
+    llvm::GlobalVariable* createProbe(const std::string& name, int kind, int line);
+    void emitProbeIncrement(llvm::IRBuilder<>& builder, llvm::GlobalVariable* probe, unsigned field, int64_t delta);
+    
     // Helper methods
     void createBuiltinFunctions();
+    void initializeTarget();
+    std::unique_ptr<llvm::TargetMachine> createTargetMachine(const std::string& triple) const;
+    static constexpr uint64_t kObjectCacheMaxBytes = 256ull << 20; // pruned beyond this
+    bool openObjectCache();
+    std::string objectCacheKey() const;
+    std::string objectCacheEntry(llvm::StringRef extension) const;
+    bool loadCachedModule(const std::string& entry);
+    void storeCacheEntry(const std::string& entry, llvm::StringRef source_file, llvm::StringRef contents);
+    void emitModuleObject(const std::string& filename, unsigned jobs);
+    void applyTargetAttributes();
+    bool linkRuntimeBitcode();
     
 public:
     CodeGenContext();
@@ -85,25 +159,51 @@ public:
     void pushScope();
     void popScope();
     void declareVariable(const std::string& name, llvm::Value* value);
+    void assignVariable(const std::string& name, llvm::Value* value); // rebinds in the declaring scope
     llvm::Value* lookupVariable(const std::string& name);
+    llvm::AllocaInst* createEntryAlloca(llvm::Type* type, const std::string& name);
     
     // Function management
     void declareFunction(const std::string& name, llvm::Function* function);
     llvm::Function* lookupFunction(const std::string& name);
     
     // Type management
-    void declareType(const std::string& name, llvm::StructType* type, const std::vector<std::string>& field_names);
+    // `field_slots[i]` is the struct element of field_names[i] after the header
+    // (fields may be laid out out of declaration order); empty = in order
+    void declareType(const std::string& name, llvm::StructType* type, const std::vector<std::string>& field_names,
+                     const std::vector<int>& field_slots = {});
     llvm::StructType* lookupType(const std::string& name);
-    std::vector<std::string> getTypeFields(const std::string& name);
+    const std::vector<std::string>& getTypeFields(const std::string& name) const;
     int getFieldIndex(const std::string& type_name, const std::string& field_name);
     
     // Virtual table management
     void createVTable(const std::string& type_name, const std::vector<std::string>& method_names);
     llvm::GlobalVariable* getVTable(const std::string& type_name);
+    const std::vector<std::string>& getVTableLayout(const std::string& type_name) const;
+    int getVTableSlot(const std::string& type_name, const std::string& method_name) const;
+    llvm::Function* resolveMethod(const std::string& type_name, const std::string& method_name);
+    void finalizeVTables();
+    
+    // Object header: every object starts with { i32 type_id, ptr vtable }
+    static constexpr unsigned kObjectHeaderFields = 2;
+    static constexpr unsigned kStringInlineCapacity = 23; // HULK_STRING_INLINE_CAPACITY
+    llvm::StructType* getObjectHeaderType() const { return object_header_type_; }
+    int getTypeId(const std::string& type_name) const;
+    llvm::GlobalVariable* createTypeLayoutTable(); // per-type pointer maps for the collector
+    llvm::Value* loadTypeId(llvm::Value* object);
+    llvm::Value* loadVTableSlot(llvm::Value* object, int slot);
+    // Attributes of a method's self: a whole, aligned object of `type` or a subtype
+    // (never null); `fresh` (init) also makes it noalias, nothing else refers to it yet
+    void markSelfParameter(llvm::Function* method, llvm::StructType* type, bool fresh);
     
     // Memory management helpers
     llvm::Value* createObjectAllocation(const std::string& type_name);
     llvm::Constant* getTypeSize(const std::string& type_name);
+    // Escape analysis: objects from createObjectAllocation that cannot outlive
+    // their function (never stored in a field or global, returned, or passed
+    // to code that might keep them) become allocas in the entry block, which
+    // SROA then breaks into scalars. Returns the number of objects moved.
+    size_t stackAllocateObjects();
     
     // Current function
     void setCurrentFunction(llvm::Function* function) { current_function_ = function; }
@@ -115,16 +215,73 @@ public:
     void setCurrentType(const std::string& type) { current_type_ = type; }
     std::string getCurrentType() const { return current_type_; }
     
+    // Optimization (0-3, same levels as clang's -O flags); throws if the module does not verify.
+    // With the cache enabled a module optimized before is loaded instead of running the
+    // pipeline, and getModule() returns that module from then on
+    void optimizeModule(unsigned level);
+    void verifyGeneratedModule();
+    // Fast-math flags applied to every floating-point instruction emitted from now on
+    void setFastMathOptions(bool fast_math, bool fp_contract, bool no_nans);
+    llvm::TargetMachine* getTargetMachine() const { return target_machine_.get(); }
+    // Generate code for `cpu` (--march): "native" is the host's CPU and features,
+    // anything else an LLVM CPU name; false if the target does not know it
+    bool setTargetCPU(const std::string& cpu);
+    // Function multiversioning (--multiversion, x86-64 only): `function` becomes
+    // an ifunc over AVX-512, AVX2 and baseline clones, resolved at load time by
+    // the CPU the program runs on. False if the target cannot do it.
+    bool multiversionFunction(llvm::Function* function);
+    
     // Output
     void dumpIR(const std::string& filename = "");
-    void writeObjectFile(const std::string& filename);
+    // With jobs > 1 the module is split into partitions that are compiled on a
+    // thread pool and merged back into one relocatable object with the system
+    // linker (ld -r); without one it is compiled whole
+    void writeObjectFile(const std::string& filename, unsigned jobs = 1);
+    void setObjectCacheDir(const std::string& dir) { object_cache_dir_ = dir; }
+    void printStats(std::ostream& out) const;
+    
+    // Debug info: a compile unit for the .hulk source, one subprogram per
+    // function or method, and a line for every instruction emitted inside it
+    void enableDebugInfo(const std::string& source_path);
+    bool hasDebugInfo() const { return di_builder_ != nullptr; }
+    void beginFunctionDebugInfo(llvm::Function* function, const std::string& name, int line);
+    void setDebugLocation(int line, int column); // no-op outside functions with debug info
+    void finalizeDebugInfo();                    // before verification, optimization or output
+    
+    // Instrumentation: call counts and cycles per function and method, plus
+    // counts per if branch and while back-edge when `branches` is set
+    enum ProbeKind { kProbeFunction = 0, kProbeThen, kProbeElse, kProbeLoop }; // HULK_PROBE_*
+    void setInstrumentation(bool functions, bool branches);
+    void instrumentFunction(llvm::Function* function, const std::string& name, int line);
+    void emitBranchProbe(ProbeKind kind, int line); // at the insert point, no-op unless enabled
+    // Emits the entry/exit code of instrumented functions and the probe table
+    // `table_name` (registered from main, if the module has one); returns the probe count
+    size_t finalizeInstrumentation(const std::string& table_name = "hulk_probes");
     
     // Utility
-    llvm::Value* createStringConstant(const std::string& str);
+    // Both are pooled, so equal texts share one global
+    llvm::Value* createStringConstant(const std::string& str); // raw C string (printf formats)
+    llvm::Value* createStringLiteral(const std::string& str);  // immortal HulkString value
+    llvm::StructType* getStringType() const { return string_type_; }
     llvm::Value* createNumberConstant(double value);
     llvm::Value* createBooleanConstant(bool value);
     llvm::Type* getLLVMType(const std::string& type_name);
     
+    // Dynamic values: used wherever the semantic type of a value is unknown.
+    // They travel as two i64 words so calls into the runtime follow the C ABI.
+    enum ValueTag { kValueNumber = 0, kValueBoolean, kValueString, kValueObject }; // HULK_VALUE_*
+    llvm::StructType* getDynamicValueType() const { return dynamic_value_type_; }
+    bool isDynamicValue(llvm::Value* value) const { return value->getType() == dynamic_value_type_; }
+    // Pointers are strings or objects; without a `pointer_tag` the runtime tells them apart
+    llvm::Value* boxValue(llvm::Value* value, int pointer_tag = -1);
+    llvm::Value* unboxValue(llvm::Value* boxed, llvm::Type* type);
+    // Converts between any two value representations (double, i1, ptr or dynamic)
+    llvm::Value* coerceValue(llvm::Value* value, llvm::Type* type);
+    // Calls runtime helper `name` with `boxed` split into its tag and payload
+    llvm::Value* callDynamicHelper(const std::string& name, llvm::Value* boxed);
+    // Reports `message` at run time and exits
+    void emitDynamicError(const std::string& message);
+    
     // Dynamic type management
     void declareVariableType(const std::string& name, const std::string& type);
     std::string getVariableType(const std::string& name) const;
@@ -134,17 +291,17 @@ public:
     // Inheritance management
     void declareInheritance(const std::string& child, const std::string& parent);
     std::string getParentType(const std::string& child) const;
+    bool hasSubtypes(const std::string& type_name) const;
     
     // Type management helpers
     llvm::Type* getFieldType(const std::string& type_name, const std::string& field_name);
     llvm::Type* getFieldType(const std::string& type_name, int field_index);
+    // Fields are stored in their layout type (booleans as i8) and loaded as values (i1)
+    static llvm::Type* getFieldValueType(llvm::Type* storage_type);
+    llvm::Value* loadField(llvm::StructType* type, llvm::Value* object, int field_index, const std::string& name);
+    void storeField(llvm::StructType* type, llvm::Value* object, int field_index, llvm::Value* value,
+                    const std::string& name);
     
-    // Get all type names defined in the program
-    std::vector<std::string> getAllTypeNames() const {
-        std::vector<std::string> types;
-        for (const auto& pair : custom_types_) {
-            types.push_back(pair.first);
-        }
-        return types;
-    }
+    // Get all type names defined in the program (sorted, for deterministic output)
+    std::vector<std::string> getAllTypeNames() const;
 };
\ No newline at end of file
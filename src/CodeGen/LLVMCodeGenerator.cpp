@@ -1,11 +1,17 @@
 #include "LLVMCodeGenerator.hpp"
 #include "../Semantic/SemanticAnalyzer.hpp"
+#include "llvm/Analysis/CFG.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/Support/raw_ostream.h"
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <functional>
+#include <set>
 
 // Constructor with module name (creates internal context)
 LLVMCodeGenerator::LLVMCodeGenerator(const std::string& module_name, SemanticAnalyzer* analyzer) 
@@ -21,7 +27,31 @@ void LLVMCodeGenerator::printModule() {
     context_.getModule().print(llvm::outs(), nullptr);
 }
 
+void LLVMCodeGenerator::writeOutput(const std::string& filename, unsigned jobs) {
+    bool is_object = filename.size() > 2 && filename.compare(filename.size() - 2, 2, ".o") == 0;
+    if (is_object) {
+        context_.writeObjectFile(filename, jobs);
+    } else {
+        context_.dumpIR(filename);
+    }
+}
+
 void LLVMCodeGenerator::visit(Program* prog) {
+    // Layout pass: structs, vtable layouts and method prototypes for every type,
+    // parents before children, so bodies can call methods declared later in the file
+    std::vector<TypeDecl*> ordered_types = orderTypesByInheritance(prog);
+    for (auto* type_decl : ordered_types) {
+        type_decls_[type_decl->name] = type_decl;
+        if (!type_decl->parentType.empty()) {
+            context_.declareInheritance(type_decl->name, type_decl->parentType);
+        }
+        createStructForType(type_decl);
+    }
+    unifyOverrideSignatures(ordered_types);
+    for (auto* type_decl : ordered_types) {
+        declareTypeMethods(type_decl);
+    }
+    
     // First pass: process type declarations and function declarations
     for (auto& stmt : prog->stmts) {
         if (auto* type_decl = dynamic_cast<TypeDecl*>(stmt.get())) {
@@ -55,9 +85,26 @@ void LLVMCodeGenerator::visit(Program* prog) {
         
         // Set current function context BEFORE processing expressions
         context_.setCurrentFunction(main_func);
+        context_.beginFunctionDebugInfo(main_func, "main", main_expressions.front()->expr->line_number);
+        context_.instrumentFunction(main_func, "main", main_expressions.front()->expr->line_number);
+        
+        // Hand the collector the type layouts and the bottom of main's frame,
+        // above which no compiled code can hold object references
+        llvm::Function* frame_address = llvm::Intrinsic::getDeclaration(
+            &context_.getModule(), llvm::Intrinsic::frameaddress,
+            {llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext()))});
+        llvm::Value* stack_base = context_.getBuilder().CreateCall(
+            frame_address, {llvm::ConstantInt::get(llvm::Type::getInt32Ty(context_.getLLVMContext()), 0)});
+        llvm::GlobalVariable* layouts = context_.createTypeLayoutTable();
+        llvm::Value* layout_count = llvm::ConstantInt::get(
+            llvm::Type::getInt64Ty(context_.getLLVMContext()),
+            llvm::cast<llvm::ArrayType>(layouts->getValueType())->getNumElements());
+        context_.getBuilder().CreateCall(context_.lookupFunction("hulk_gc_init"), {layouts, layout_count, stack_base});
           // Process each main expression
         for (auto* expr_stmt : main_expressions) {
-            std::cerr << "Processing main expression..." << std::endl;
+            if (verbose_) {
+                std::cerr << "Processing main expression..." << std::endl;
+            }
             expr_stmt->expr->accept(this);
             // Consume any leftover values
             if (context_.hasValue()) {
@@ -70,6 +117,43 @@ void LLVMCodeGenerator::visit(Program* prog) {
             llvm::Type::getInt32Ty(context_.getLLVMContext()), 0);
         context_.getBuilder().CreateRet(return_val);
     }
+    
+    // Every method body exists now, so the vtables can be filled in
+    context_.finalizeVTables();
+    context_.stackAllocateObjects();
+    applyProfileInliningHints();
+    context_.finalizeInstrumentation();
+    context_.finalizeDebugInfo();
+    multiversionHotFunctions();
+}
+
+// Returns the program's type declarations with every parent before its children
+std::vector<TypeDecl*> LLVMCodeGenerator::orderTypesByInheritance(Program* prog) {
+    std::map<std::string, TypeDecl*> by_name;
+    std::vector<TypeDecl*> declared;
+    for (auto& stmt : prog->stmts) {
+        if (auto* type_decl = dynamic_cast<TypeDecl*>(stmt.get())) {
+            by_name[type_decl->name] = type_decl;
+            declared.push_back(type_decl);
+        }
+    }
+    
+    std::vector<TypeDecl*> ordered;
+    std::set<std::string> visited;
+    std::function<void(TypeDecl*)> visit_type = [&](TypeDecl* type_decl) {
+        if (!visited.insert(type_decl->name).second) {
+            return; // Already placed (or an inheritance cycle, which semantic analysis reports)
+        }
+        auto parent = by_name.find(type_decl->parentType);
+        if (parent != by_name.end()) {
+            visit_type(parent->second);
+        }
+        ordered.push_back(type_decl);
+    };
+    for (auto* type_decl : declared) {
+        visit_type(type_decl);
+    }
+    return ordered;
 }
 
 // Separate method to process main expressions
@@ -88,7 +172,7 @@ void LLVMCodeGenerator::visit(NumberExpr* expr) {
 }
 
 void LLVMCodeGenerator::visit(StringExpr* expr) {
-    llvm::Value* value = context_.createStringConstant(expr->value);
+    llvm::Value* value = context_.createStringLiteral(expr->value);
     context_.pushValue(value);
 }
 
@@ -98,6 +182,7 @@ void LLVMCodeGenerator::visit(BooleanExpr* expr) {
 }
 
 void LLVMCodeGenerator::visit(UnaryExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
     expr->operand->accept(this);
     llvm::Value* operand = context_.popValue();
     
@@ -114,6 +199,12 @@ void LLVMCodeGenerator::visit(UnaryExpr* expr) {
 }
 
 void LLVMCodeGenerator::visit(BinaryExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
+    if (expr->op == BinaryExpr::Op::OP_CONCAT || expr->op == BinaryExpr::Op::OP_CONCAT_SPACE) {
+        context_.pushValue(generateConcatChain(expr));
+        return;
+    }
+    
     // Generate code for operands
     expr->left->accept(this);
     llvm::Value* left = context_.popValue();
@@ -147,12 +238,15 @@ void LLVMCodeGenerator::visit(BinaryExpr* expr) {
             throw std::runtime_error("Unknown binary operator");
     }
     
-    // Generate operation
-    llvm::Value* result = generateBinaryOperation(op, left, right, "Number", "Number"); // Simplified
+    // Generate operation (operands are Number unless they are syntactically strings)
+    std::string left_type = containsStringOperations(expr->left.get()) ? "String" : "Number";
+    std::string right_type = containsStringOperations(expr->right.get()) ? "String" : "Number";
+    llvm::Value* result = generateBinaryOperation(op, left, right, left_type, right_type);
     context_.pushValue(result);
 }
 
 void LLVMCodeGenerator::visit(CallExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
     // Generate arguments
     std::vector<llvm::Value*> args;
     for (const auto& arg : expr->args) {
@@ -163,8 +257,18 @@ void LLVMCodeGenerator::visit(CallExpr* expr) {
     // Handle built-in functions
     if (expr->callee == "debug" || expr->callee == "type" || expr->callee == "assert" ||
         expr->callee == "print" || expr->callee == "sin" || expr->callee == "cos" ||
-        expr->callee == "sqrt" || expr->callee == "exp" || expr->callee == "rand" ||
+        expr->callee == "sqrt" || expr->callee == "exp" || expr->callee == "log" || expr->callee == "pow" || expr->callee == "rand" ||
         expr->callee == "str" || expr->callee == "PI" || expr->callee == "E") {
+        // print, debug and str handle dynamic values themselves; the rest take numbers (assert a boolean)
+        if (expr->callee != "print" && expr->callee != "debug" && expr->callee != "str") {
+            for (auto& arg : args) {
+                if (context_.isDynamicValue(arg)) {
+                    arg = context_.coerceValue(arg, expr->callee == "assert"
+                                                        ? llvm::Type::getInt1Ty(context_.getLLVMContext())
+                                                        : context_.getLLVMType("Number"));
+                }
+            }
+        }
         llvm::Value* result = generateBuiltinCall(expr->callee, args);
         context_.pushValue(result);
         return;
@@ -176,12 +280,33 @@ void LLVMCodeGenerator::visit(CallExpr* expr) {
         throw std::runtime_error("Undefined function: " + expr->callee);
     }
     
+    // Prefer the clone specialized for these arguments, if the analyzer asked for one;
+    // positions where the generic version takes a number are converted either way
+    if (semantic_analyzer_ && !args.empty()) {
+        std::vector<llvm::Type*> shape;
+        for (size_t i = 0; i < args.size(); ++i) {
+            bool generic_number = i < function->arg_size() && function->getArg(static_cast<unsigned>(i))->getType()->isDoubleTy();
+            shape.push_back(generic_number ? context_.getLLVMType("Number") : args[i]->getType());
+        }
+        if (llvm::Function* specialized = context_.lookupFunction(specializationName(expr->callee, shape))) {
+            function = specialized;
+        }
+    }
+    
+    // Box or unbox each argument into the representation of its parameter
+    llvm::FunctionType* function_type = function->getFunctionType();
+    for (size_t i = 0; i < args.size() && i < function_type->getNumParams(); ++i) {
+        args[i] = context_.coerceValue(args[i], function_type->getParamType(static_cast<unsigned>(i)));
+    }
+    
     // Create call
     llvm::Value* result = context_.getBuilder().CreateCall(function, args);
+    recordProfiledCall(function, profile_ ? profile_->callCount(expr->node_id) : 0);
     context_.pushValue(result);
 }
 
 void LLVMCodeGenerator::visit(VariableExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
     llvm::Value* alloca = context_.lookupVariable(expr->name);
     if (!alloca) {
         throw std::runtime_error("Undefined variable: " + expr->name);
@@ -191,6 +316,10 @@ void LLVMCodeGenerator::visit(VariableExpr* expr) {
     if (auto* alloca_inst = llvm::dyn_cast<llvm::AllocaInst>(alloca)) {
         llvm::Value* loaded_value = context_.getBuilder().CreateLoad(
             alloca_inst->getAllocatedType(), alloca, expr->name + "_val");
+        if (loaded_value->getType()->isIntegerTy(64)) {
+            // Integer counter (see visit(LetExpr)): every use sees a Number
+            loaded_value = context_.getBuilder().CreateSIToFP(loaded_value, context_.getLLVMType("Number"));
+        }
         context_.pushValue(loaded_value);
     } else {
         context_.pushValue(alloca);
@@ -198,18 +327,29 @@ void LLVMCodeGenerator::visit(VariableExpr* expr) {
 }
 
 void LLVMCodeGenerator::visit(LetExpr* expr) {
-    std::cerr << "Processing LetExpr for variable: " << expr->name << std::endl;
+    context_.setDebugLocation(expr->line_number, expr->column_number);
+    if (generateRangeLoop(expr)) {
+        return;
+    }
+    if (verbose_) {
+        std::cerr << "Processing LetExpr for variable: " << expr->name << std::endl;
+    }
     context_.pushScope();
     
     // Generate the initializer value
     expr->initializer->accept(this);
     llvm::Value* init_value = context_.popValue();
     
+    // Counters the analyzer proved integral live in an i64 slot (see visit(AssignExpr));
+    // reads convert back to Number, so induction variables are integers for the optimizer
+    if (integer_counters_ && semantic_analyzer_ && semantic_analyzer_->isIntegerVariable(expr)) {
+        init_value = context_.getBuilder().CreateFPToSI(
+            context_.coerceValue(init_value, context_.getLLVMType("Number")),
+            llvm::Type::getInt64Ty(context_.getLLVMContext()), expr->name);
+    }
+    
     // Create an alloca for the variable (so it can be modified if needed)
-    llvm::Function* function = context_.getCurrentFunction();
-    llvm::IRBuilder<> temp_builder(&function->getEntryBlock(), function->getEntryBlock().begin());
-    llvm::AllocaInst* alloca = temp_builder.CreateAlloca(
-        init_value->getType(), nullptr, expr->name);
+    llvm::AllocaInst* alloca = context_.createEntryAlloca(init_value->getType(), expr->name);
     
     // Store the initial value
     context_.getBuilder().CreateStore(init_value, alloca);
@@ -241,35 +381,152 @@ void LLVMCodeGenerator::visit(LetExpr* expr) {
 }
 
 void LLVMCodeGenerator::visit(AssignExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
+    auto* alloca = llvm::dyn_cast_or_null<llvm::AllocaInst>(context_.lookupVariable(expr->name));
+    if (alloca && alloca->getAllocatedType()->isIntegerTy(64)) {
+        generateCounterUpdate(expr, alloca);
+        return;
+    }
+    
     // Generate value
     expr->value->accept(this);
     llvm::Value* value = context_.popValue();
     
-    // Update variable
-    context_.declareVariable(expr->name, value);
+    // Store into the variable's slot so loops observe the update
+    if (!alloca || alloca->getAllocatedType() != value->getType()) {
+        // New variable, or its representation changed: give it a fresh slot
+        alloca = context_.createEntryAlloca(value->getType(), expr->name);
+        context_.assignVariable(expr->name, alloca);
+    }
+    context_.getBuilder().CreateStore(value, alloca);
     context_.pushValue(value);
 }
 
-void LLVMCodeGenerator::visit(IfExpr* expr) {
+// The parser desugars `for (x in range(a, b)) body` into
+//   let __iter = iter(range(a, b)) in while (next(__iter)) let x = current(__iter) in body
+// Over a range that is a counted loop: x takes a, a + 1, ... while below b. It
+// runs on an i64 induction variable from 0 to ceil(b - a), with x = a + i, so
+// no iterator object exists and LLVM sees a loop with a computable trip count.
+bool LLVMCodeGenerator::generateRangeLoop(LetExpr* expr) {
+    auto is_iterator_call = [](Expr* candidate, const char* callee) {
+        auto* call = dynamic_cast<CallExpr*>(candidate);
+        if (!call || call->callee != callee || call->args.size() != 1) return false;
+        auto* iterator = dynamic_cast<VariableExpr*>(call->args[0].get());
+        return iterator && iterator->name == "__iter";
+    };
+    auto* iter_call = dynamic_cast<CallExpr*>(expr->initializer.get());
+    auto* range_call = iter_call && iter_call->callee == "iter" && iter_call->args.size() == 1
+                           ? dynamic_cast<CallExpr*>(iter_call->args[0].get())
+                           : nullptr;
+    auto* body = dynamic_cast<ExprStmt*>(expr->body.get());
+    auto* loop = body ? dynamic_cast<WhileExpr*>(body->expr.get()) : nullptr;
+    auto* element = loop ? dynamic_cast<LetExpr*>(loop->body.get()) : nullptr;
+    if (expr->name != "__iter" || !range_call || range_call->callee != "range" || range_call->args.size() != 2 ||
+        !element || !is_iterator_call(loop->condition.get(), "next") ||
+        !is_iterator_call(element->initializer.get(), "current")) {
+        return false;
+    }
+    
+    auto& builder = context_.getBuilder();
+    llvm::LLVMContext& llvm_context = context_.getLLVMContext();
     llvm::Function* function = context_.getCurrentFunction();
+    llvm::Type* number_type = context_.getLLVMType("Number");
+    llvm::Type* index_type = llvm::Type::getInt64Ty(llvm_context);
+    
+    range_call->args[0]->accept(this);
+    llvm::Value* start = context_.coerceValue(context_.popValue(), number_type);
+    range_call->args[1]->accept(this);
+    llvm::Value* end = context_.coerceValue(context_.popValue(), number_type);
+    
+    // Like the interpreter's RangeValue, a range cannot run backwards
+    llvm::BasicBlock* invalid_block = llvm::BasicBlock::Create(llvm_context, "range_invalid", function);
+    llvm::BasicBlock* valid_block = llvm::BasicBlock::Create(llvm_context, "range_valid", function);
+    builder.CreateCondBr(builder.CreateFCmpOGT(start, end), invalid_block, valid_block);
+    builder.SetInsertPoint(invalid_block);
+    context_.emitDynamicError("range() expects min <= max");
+    builder.CreateUnreachable();
+    
+    // Saturating, so a NaN bound gives no iterations and a huge one no poison
+    builder.SetInsertPoint(valid_block);
+    llvm::Value* span = builder.CreateUnaryIntrinsic(llvm::Intrinsic::ceil, builder.CreateFSub(end, start));
+    llvm::Value* trip_count = builder.CreateIntrinsic(llvm::Intrinsic::fptosi_sat, {index_type, number_type},
+                                                      {span}, nullptr, "trip_count");
+    
+    llvm::BasicBlock* preheader = builder.GetInsertBlock();
+    llvm::BasicBlock* loop_block = llvm::BasicBlock::Create(llvm_context, "for", function);
+    llvm::BasicBlock* body_block = llvm::BasicBlock::Create(llvm_context, "forbody", function);
+    llvm::BasicBlock* after_block = llvm::BasicBlock::Create(llvm_context, "afterfor", function);
+    llvm::BranchInst* enter_loop = builder.CreateBr(loop_block);
+    
+    builder.SetInsertPoint(loop_block);
+    llvm::PHINode* index = builder.CreatePHI(index_type, 2, "for_index");
+    index->addIncoming(llvm::ConstantInt::get(index_type, 0), preheader);
+    setBranchWeights(builder.CreateCondBr(builder.CreateICmpSLT(index, trip_count), body_block, after_block),
+                     loop->node_id);
+    
+    // The element is a fresh let each iteration: assigning it does not move the loop
+    builder.SetInsertPoint(body_block);
+    context_.setDebugLocation(element->line_number, element->column_number);
+    context_.pushScope();
+    llvm::AllocaInst* element_slot = context_.createEntryAlloca(number_type, element->name);
+    builder.CreateStore(builder.CreateFAdd(start, builder.CreateSIToFP(index, number_type)), element_slot);
+    context_.declareVariable(element->name, element_slot);
+    element->body->accept(this);
+    llvm::Value* body_value = context_.hasValue() ? context_.popValue() : nullptr;
+    context_.popScope();
     
-    // Check if this If expression is being processed in the wrong context
-    // If we're in a method like B_f but processing a complex if expression,
-    // this is likely the main program logic that got misplaced
-    std::string func_name = std::string(function->getName());
-    if (func_name.find("_f") != std::string::npos || func_name.find("_init") != std::string::npos) {
-        // We're in a method but processing what looks like main program logic
-        // Skip generating this here - it should be handled in main
-        std::cerr << "Skipping complex if expression in method " << func_name << std::endl;
-        
-        // Push a dummy value to maintain the stack
-        llvm::Value* dummy = llvm::ConstantInt::get(
-            llvm::Type::getInt32Ty(context_.getLLVMContext()), 0);
-        context_.pushValue(dummy);
-        return;
+    // Same value as visit(WhileExpr): the last body value, zero if it never ran
+    llvm::AllocaInst* result_slot = nullptr;
+    if (body_value && !body_value->getType()->isVoidTy()) {
+        result_slot = context_.createEntryAlloca(body_value->getType(), "for_result");
+        llvm::IRBuilder<> preheader_builder(preheader, enter_loop->getIterator());
+        preheader_builder.CreateStore(llvm::Constant::getNullValue(body_value->getType()), result_slot);
+        builder.CreateStore(body_value, result_slot);
+    }
+    context_.emitBranchProbe(CodeGenContext::kProbeLoop, loop->line_number);
+    index->addIncoming(builder.CreateNSWAdd(index, llvm::ConstantInt::get(index_type, 1), "for_next"),
+                       builder.GetInsertBlock());
+    builder.CreateBr(loop_block);
+    
+    builder.SetInsertPoint(after_block);
+    if (result_slot) {
+        context_.pushValue(builder.CreateLoad(result_slot->getAllocatedType(), result_slot, "for_value"));
+    } else {
+        context_.pushValue(context_.createNumberConstant(0.0));
+    }
+    return true;
+}
+
+void LLVMCodeGenerator::generateCounterUpdate(AssignExpr* expr, llvm::AllocaInst* slot) {
+    auto& builder = context_.getBuilder();
+    llvm::Type* number_type = context_.getLLVMType("Number");
+    llvm::Type* counter_type = slot->getAllocatedType();
+    auto to_counter = [&](Expr* operand) {
+        operand->accept(this);
+        return builder.CreateFPToSI(context_.coerceValue(context_.popValue(), number_type), counter_type);
+    };
+    
+    // The analyzer only lets literals and `x ± step` reach a counter, and bounds
+    // both, so the integer arithmetic cannot wrap
+    llvm::Value* updated = nullptr;
+    auto* binary = dynamic_cast<BinaryExpr*>(expr->value.get());
+    if (binary && (binary->op == BinaryExpr::OP_ADD || binary->op == BinaryExpr::OP_SUB)) {
+        auto* left = dynamic_cast<VariableExpr*>(binary->left.get());
+        llvm::Value* step = to_counter(left && left->name == expr->name ? binary->right.get() : binary->left.get());
+        llvm::Value* current = builder.CreateLoad(counter_type, slot, expr->name + "_val");
+        updated = binary->op == BinaryExpr::OP_ADD ? builder.CreateNSWAdd(current, step, expr->name)
+                                                   : builder.CreateNSWSub(current, step, expr->name);
+    } else {
+        updated = to_counter(expr->value.get());
     }
+    builder.CreateStore(updated, slot);
+    context_.pushValue(builder.CreateSIToFP(updated, number_type));
+}
+
+void LLVMCodeGenerator::visit(IfExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
+    llvm::Function* function = context_.getCurrentFunction();
     
-    // Normal if expression processing
     // Create blocks
     llvm::BasicBlock* then_block = llvm::BasicBlock::Create(
         context_.getLLVMContext(), "then", function);
@@ -280,40 +537,52 @@ void LLVMCodeGenerator::visit(IfExpr* expr) {
     
     // Generate condition
     expr->condition->accept(this);
-    llvm::Value* condition = context_.popValue();
+    llvm::Value* condition = context_.coerceValue(
+        context_.popValue(), llvm::Type::getInt1Ty(context_.getLLVMContext()));
     
     // Create conditional branch
-    context_.getBuilder().CreateCondBr(condition, then_block, else_block);
+    setBranchWeights(context_.getBuilder().CreateCondBr(condition, then_block, else_block), expr->node_id);
     
     // Generate then block
     context_.getBuilder().SetInsertPoint(then_block);
+    context_.emitBranchProbe(CodeGenContext::kProbeThen, expr->line_number);
     expr->thenBranch->accept(this);
     llvm::Value* then_value = context_.popValue();
-    context_.getBuilder().CreateBr(merge_block);
+    llvm::BasicBlock* then_end = context_.getBuilder().GetInsertBlock();
     
     // Generate else block
     context_.getBuilder().SetInsertPoint(else_block);
+    context_.emitBranchProbe(CodeGenContext::kProbeElse, expr->line_number);
     llvm::Value* else_value = nullptr;
     if (expr->elseBranch) {
         expr->elseBranch->accept(this);
         else_value = context_.popValue();
     } else {
         // Default value for else - use same type as then branch
-        if (then_value->getType()->isPointerTy()) {
-            else_value = llvm::ConstantPointerNull::get(
-                llvm::cast<llvm::PointerType>(then_value->getType()));
-        } else {
-            else_value = llvm::ConstantInt::get(context_.getLLVMContext(), llvm::APInt(32, 0));
-        }
+        else_value = then_value->getType()->isVoidTy() ? context_.createNumberConstant(0.0)
+                                                       : llvm::Constant::getNullValue(then_value->getType());
+    }
+    llvm::BasicBlock* else_end = context_.getBuilder().GetInsertBlock();
+    
+    // Branches of different types (e.g. a number and a string) merge as dynamic values
+    if (then_value->getType() != else_value->getType()) {
+        context_.getBuilder().SetInsertPoint(then_end);
+        then_value = context_.boxValue(then_value);
+        context_.getBuilder().SetInsertPoint(else_end);
+        else_value = context_.boxValue(else_value);
     }
+    context_.getBuilder().SetInsertPoint(then_end);
     context_.getBuilder().CreateBr(merge_block);
-      // Continue with merge block
+    context_.getBuilder().SetInsertPoint(else_end);
+    context_.getBuilder().CreateBr(merge_block);
+    
+    // Continue with merge block
     context_.getBuilder().SetInsertPoint(merge_block);
     
     // Create PHI node for result
     llvm::PHINode* phi = context_.getBuilder().CreatePHI(then_value->getType(), 2, "iftmp");
-    phi->addIncoming(then_value, then_block);
-    phi->addIncoming(else_value, else_block);
+    phi->addIncoming(then_value, then_end);
+    phi->addIncoming(else_value, else_end);
     
     context_.pushValue(phi);
 }
@@ -343,7 +612,50 @@ void LLVMCodeGenerator::visit(ExprBlock* block) {
     context_.popScope();
 }
 
+llvm::Function* LLVMCodeGenerator::generateLoopFunction(WhileExpr* loop,
+                                                        const std::vector<std::string>& live_variables,
+                                                        const std::string& name) {
+    llvm::LLVMContext& llvm_context = context_.getLLVMContext();
+    llvm::IRBuilder<>& builder = context_.getBuilder();
+    llvm::Type* number_type = context_.getLLVMType("Number");
+    llvm::FunctionType* func_type = llvm::FunctionType::get(
+        number_type, {llvm::PointerType::getUnqual(number_type)}, false);
+    llvm::Function* llvm_func = llvm::Function::Create(
+        func_type, llvm::Function::ExternalLinkage, name, context_.getModule());
+    llvm::Argument* slots = &*llvm_func->arg_begin();
+    slots->setName("slots");
+    
+    builder.SetInsertPoint(llvm::BasicBlock::Create(llvm_context, "entry", llvm_func));
+    context_.setCurrentFunction(llvm_func);
+    context_.beginFunctionDebugInfo(llvm_func, name, loop->line_number);
+    context_.instrumentFunction(llvm_func, name, loop->line_number);
+    context_.pushScope();
+    
+    // The interpreter's live values become ordinary locals of the loop
+    std::vector<llvm::Value*> slot_ptrs;
+    for (size_t i = 0; i < live_variables.size(); ++i) {
+        llvm::Value* slot_ptr = builder.CreateConstInBoundsGEP1_64(number_type, slots, i);
+        llvm::AllocaInst* local = context_.createEntryAlloca(number_type, live_variables[i]);
+        builder.CreateStore(builder.CreateLoad(number_type, slot_ptr), local);
+        context_.declareVariable(live_variables[i], local);
+        slot_ptrs.push_back(slot_ptr);
+    }
+    
+    loop->accept(this);
+    llvm::Value* result = context_.popValue();
+    
+    for (size_t i = 0; i < live_variables.size(); ++i) {
+        llvm::Value* local = context_.lookupVariable(live_variables[i]);
+        builder.CreateStore(builder.CreateLoad(number_type, local), slot_ptrs[i]);
+    }
+    builder.CreateRet(result);
+    
+    context_.popScope();
+    return llvm_func;
+}
+
 void LLVMCodeGenerator::visit(WhileExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
     llvm::Function* function = context_.getCurrentFunction();
     
     llvm::BasicBlock* loop_block = llvm::BasicBlock::Create(
@@ -354,32 +666,59 @@ void LLVMCodeGenerator::visit(WhileExpr* expr) {
         context_.getLLVMContext(), "afterloop", function);
     
     // Jump to loop condition
-    context_.getBuilder().CreateBr(loop_block);
+    llvm::BasicBlock* preheader = context_.getBuilder().GetInsertBlock();
+    llvm::BranchInst* enter_loop = context_.getBuilder().CreateBr(loop_block);
     
     // Generate loop condition
     context_.getBuilder().SetInsertPoint(loop_block);
     expr->condition->accept(this);
-    llvm::Value* condition = context_.popValue();
-    context_.getBuilder().CreateCondBr(condition, body_block, after_block);
+    llvm::Value* condition = context_.coerceValue(
+        context_.popValue(), llvm::Type::getInt1Ty(context_.getLLVMContext()));
+    setBranchWeights(context_.getBuilder().CreateCondBr(condition, body_block, after_block), expr->node_id);
     
     // Generate loop body
     context_.getBuilder().SetInsertPoint(body_block);
     expr->body->accept(this);
-    llvm::Value* body_value = context_.popValue();
+    llvm::Value* body_value = context_.hasValue() ? context_.popValue() : nullptr;
+    
+    // The loop's value is the last body value; it lives in a slot because the
+    // body may run zero times (the slot then keeps a zero of the same type)
+    llvm::AllocaInst* result_slot = nullptr;
+    if (body_value && !body_value->getType()->isVoidTy()) {
+        result_slot = context_.createEntryAlloca(body_value->getType(), "while_result");
+        llvm::IRBuilder<> preheader_builder(preheader, enter_loop->getIterator());
+        preheader_builder.CreateStore(llvm::Constant::getNullValue(body_value->getType()), result_slot);
+        context_.getBuilder().CreateStore(body_value, result_slot);
+    }
+    context_.emitBranchProbe(CodeGenContext::kProbeLoop, expr->line_number);
     context_.getBuilder().CreateBr(loop_block);
     
     // Continue after loop
     context_.getBuilder().SetInsertPoint(after_block);
     
-    if (body_value) {
-        context_.pushValue(body_value);
+    if (result_slot) {
+        context_.pushValue(context_.getBuilder().CreateLoad(
+            result_slot->getAllocatedType(), result_slot, "while_value"));
+    } else {
+        context_.pushValue(context_.createNumberConstant(0.0));
     }
 }
 
 // Missing visitor implementations for object-oriented features
 void LLVMCodeGenerator::visit(NewExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
     // Real implementation for object creation with memory allocation
     
+    // Generate arguments for the constructor first, so the allocation is
+    // immediately followed by its initialization (see stackAllocateObjects)
+    std::vector<llvm::Value*> args;
+    args.push_back(nullptr); // self parameter
+    
+    for (const auto& arg : expr->args) {
+        arg->accept(this);
+        args.push_back(context_.popValue());
+    }
+    
     // Allocate memory for the object
     llvm::Value* object = context_.createObjectAllocation(expr->typeName);
     
@@ -390,21 +729,18 @@ void LLVMCodeGenerator::visit(NewExpr* expr) {
         context_.pushValue(object);
         return;
     }
-    
-    // Generate arguments for the constructor
-    std::vector<llvm::Value*> args;
-    args.push_back(object); // self parameter
-    
-    for (const auto& arg : expr->args) {
-        arg->accept(this);
-        args.push_back(context_.popValue());
-    }
+    args[0] = object;
     
     // Call the constructor (init method)
     std::string init_method_name = expr->typeName + "_init";
     llvm::Function* init_func = context_.lookupFunction(init_method_name);
     if (init_func) {
-        llvm::Value* initialized_object = context_.getBuilder().CreateCall(init_func, args);
+        llvm::Value* initialized_object = emitMethodCall(init_func->getFunctionType(), init_func, args);
+        if (!initialized_object) {
+            // Reported when reached, like the interpreter does
+            context_.emitDynamicError("wrong number of arguments to new " + expr->typeName);
+            initialized_object = object;
+        }
         context_.pushValue(initialized_object);
     } else {
         // No init method found, just return the allocated object
@@ -413,27 +749,30 @@ void LLVMCodeGenerator::visit(NewExpr* expr) {
 }
 
 void LLVMCodeGenerator::visit(MemberExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
     // Generate the object expression
     expr->object->accept(this);
-    llvm::Value* object = context_.popValue();
-      // Try to determine the object type from context
+    llvm::Value* object = receiverPointer(context_.popValue());
+    
+    // Try to determine the object type from context
     std::string object_type = ""; // This would ideally come from type analysis
     
     // For now, try to infer type from self expressions or assume generic handling
-    if (auto* self_expr = dynamic_cast<SelfExpr*>(expr->object.get())) {
-        (void)self_expr; // Suppress unused variable warning
-        // If accessing self.member, we need to determine current type context
-        // For now, we'll use a heuristic or fallback to improved constants
+    if (dynamic_cast<SelfExpr*>(expr->object.get())) {
+        // Inside a method body the current type is the layout of self
+        object_type = context_.getCurrentType();
         
-        // Try to load the field value using GEP if we know the type
+        // Otherwise derive it from the enclosing Type_method function name
         llvm::Function* current_func = context_.getCurrentFunction();
-        if (current_func) {
+        if (object_type.empty() && current_func) {
             std::string func_name = std::string(current_func->getName());
             size_t underscore_pos = func_name.find('_');
             if (underscore_pos != std::string::npos) {
                 object_type = func_name.substr(0, underscore_pos);
             }
         }
+    } else if (auto* var_expr = dynamic_cast<VariableExpr*>(expr->object.get())) {
+        object_type = context_.getVariableType(var_expr->name);
     }
     
     // If we have type information, use real GEP access
@@ -441,42 +780,15 @@ void LLVMCodeGenerator::visit(MemberExpr* expr) {
         llvm::StructType* struct_type = context_.lookupType(object_type);        if (struct_type) {
             int field_index = context_.getFieldIndex(object_type, expr->member);
             if (field_index >= 0) {
-                // Create GEP to access the field
-                llvm::Value* field_ptr = context_.getBuilder().CreateStructGEP(
-                    struct_type, object, static_cast<unsigned>(field_index), 
-                    expr->member + "_ptr");
-                
-                // Get the actual field type from the struct definition
-                llvm::Type* field_type = context_.getFieldType(object_type, field_index);
-                if (!field_type) {
-                    // Fallback to ptr type if we can't determine the field type
-                    field_type = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext()));
-                }
-                
-                // Load the field value with the correct type
-                llvm::Value* field_value = context_.getBuilder().CreateLoad(
-                    field_type, field_ptr, expr->member);
-                
-                context_.pushValue(field_value);
+                // Load the field value with the type of the struct definition
+                context_.pushValue(context_.loadField(struct_type, object, field_index, expr->member));
                 return;
             }
         }
     }
     
-    // Fallback to meaningful constants based on member name
-    if (expr->member == "name") {
-        llvm::Value* member = context_.createStringConstant("object_name_value");
-        context_.pushValue(member);
-    } else if (expr->member == "breed") {
-        llvm::Value* member = context_.createStringConstant("object_breed_value");
-        context_.pushValue(member);
-    } else if (expr->member == "age") {
-        llvm::Value* member = context_.createNumberConstant(5.0);
-        context_.pushValue(member);
-    } else {
-        llvm::Value* member = context_.createNumberConstant(1.0);
-        context_.pushValue(member);
-    }
+    // Static type unknown: look the field up by the receiver's type id
+    context_.pushValue(emitDynamicFieldLoad(object, expr->member));
 }
 
 void LLVMCodeGenerator::visit(SelfExpr* expr) {
@@ -507,9 +819,10 @@ void LLVMCodeGenerator::visit(BaseExpr* expr) {
 }
 
 void LLVMCodeGenerator::visit(MemberAssignExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
     // Generate the object
     expr->object->accept(this);
-    llvm::Value* object = context_.popValue();
+    llvm::Value* object = receiverPointer(context_.popValue());
     
     // Generate the value to assign
     expr->value->accept(this);
@@ -534,13 +847,8 @@ void LLVMCodeGenerator::visit(MemberAssignExpr* expr) {
             // Get field index
             int field_index = context_.getFieldIndex(object_type, expr->member);
             if (field_index >= 0) {
-                // Create GEP to access the field
-                llvm::Value* field_ptr = context_.getBuilder().CreateStructGEP(
-                    struct_type, object, static_cast<unsigned>(field_index), 
-                    expr->member + "_ptr");
-                
-                // Store the value into the field
-                context_.getBuilder().CreateStore(value, field_ptr);
+                // Store the value into the field (converted to its layout type)
+                context_.storeField(struct_type, object, field_index, value, expr->member);
                 
                 // Push the assigned value as the result of the assignment expression
                 context_.pushValue(value);
@@ -549,11 +857,13 @@ void LLVMCodeGenerator::visit(MemberAssignExpr* expr) {
         }
     }
     
-    // Fallback: just push the assigned value (for cases where we can't determine type)
+    // Static type unknown: store into whichever type the receiver turns out to be
+    emitDynamicFieldStore(object, expr->member, value);
     context_.pushValue(value);
 }
 
 void LLVMCodeGenerator::visit(MethodCallExpr* expr) {
+    context_.setDebugLocation(expr->line_number, expr->column_number);
     // Check if this is a base method call (base.method())
     BaseExpr* base_expr = dynamic_cast<BaseExpr*>(expr->object.get());
     if (base_expr) {
@@ -580,27 +890,26 @@ void LLVMCodeGenerator::visit(MethodCallExpr* expr) {
         std::string parent_type = context_.getParentType(current_type);
         
         if (!parent_type.empty()) {
-            // Generate call to parent method
-            std::string parent_method_name = parent_type + "_" + expr->method;
-            llvm::Function* parent_method = context_.lookupFunction(parent_method_name);
-            
+            // base calls are always static: the nearest ancestor implementation
+            llvm::Function* parent_method = context_.resolveMethod(parent_type, expr->method);
             if (parent_method) {
-                llvm::Value* result = context_.getBuilder().CreateCall(parent_method, args);
-                context_.pushValue(result);
-                return;
+                llvm::Value* result = emitMethodCall(parent_method->getFunctionType(), parent_method, args);
+                if (result) {
+                    context_.pushValue(result);
+                    return;
+                }
             }
         }
         
-        // Fallback if parent method not found
-        llvm::Value* result = context_.createStringConstant("parent_method_not_found");
-        context_.pushValue(result);
+        // No ancestor implements the method
+        context_.pushValue(emitMissingMember("base." + expr->method + " is not defined"));
         return;
     }
     
     // Normal method call (not base.method())
-    // Generate the object
+    // Generate the object (exactly once; it is reused by every dispatch path)
     expr->object->accept(this);
-    llvm::Value* object = context_.popValue();
+    llvm::Value* object = receiverPointer(context_.popValue());
     
     // Generate arguments
     std::vector<llvm::Value*> args;
@@ -610,217 +919,458 @@ void LLVMCodeGenerator::visit(MethodCallExpr* expr) {
         args.push_back(context_.popValue());
     }
     
-    // Determine object type dynamically
+    // Determine the static type of the receiver and whether it is exact
     std::string object_type = "";
+    bool exact_type = false;
     
-    if (auto* var_expr = dynamic_cast<VariableExpr*>(expr->object.get())) {
+    if (auto* new_expr = dynamic_cast<NewExpr*>(expr->object.get())) {
+        // (new T()).m() - the dynamic type is known
+        object_type = new_expr->typeName;
+        exact_type = true;
+    } else if (auto* var_expr = dynamic_cast<VariableExpr*>(expr->object.get())) {
         // Look up variable type in symbol table
         object_type = context_.getVariableType(var_expr->name);
-    }    if (object_type.empty()) {        // Implement true polymorphic dispatch by detecting all available types
-        expr->object->accept(this);
-        llvm::Value* obj = context_.popValue();
-        
-        llvm::Function* function = context_.getCurrentFunction();
-          // Discover all available types by checking what method functions exist
-        std::vector<std::string> available_types;
-        std::vector<llvm::Function*> available_methods;
-        
-        // Get a list of all defined types in the program
-        auto types = context_.getAllTypeNames();
+    } else if (dynamic_cast<SelfExpr*>(expr->object.get())) {
+        // self may be an instance of any subtype of the current type
+        object_type = context_.getCurrentType();
+    }
+    
+    if (!object_type.empty()) {
+        llvm::Function* target = context_.resolveMethod(object_type, expr->method);
+        int slot = context_.getVTableSlot(object_type, expr->method);
         
-        // For each type, check if it has the method we're looking for
-        for (const auto& type_name : types) {
-            std::string method_name = type_name + "_" + expr->method;
-            llvm::Function* method_func = context_.lookupFunction(method_name);
-            
-            if (method_func) {
-                available_types.push_back(type_name);
-                available_methods.push_back(method_func);
+        if (target && (exact_type || slot < 0 || !context_.hasSubtypes(object_type))) {
+            // No override can be reached: direct call
+            llvm::Value* result = emitMethodCall(target->getFunctionType(), target, args);
+            if (result) {
+                recordProfiledCall(target, profile_ ? profile_->callCount(expr->node_id) : 0);
+                context_.pushValue(result);
+                return;
             }
-        }
-        
-        // If no defined types found, try fallback to single-letter types (A, B, C, etc.)
-        if (available_methods.empty()) {
-            for (char type_char = 'A'; type_char <= 'Z'; type_char++) {
-                std::string type_name(1, type_char);
-                std::string method_name = type_name + "_" + expr->method;
-                llvm::Function* method_func = context_.lookupFunction(method_name);
-                
-                if (method_func) {
-                    available_types.push_back(type_name);
-                    available_methods.push_back(method_func);
-                }
+        } else if (target && overridesMatchSignature(object_type, expr->method, target->getFunctionType())) {
+            // Virtual call through the receiver's vtable
+            llvm::Value* result = emitVirtualCall(expr, target->getFunctionType(), object, slot, args);
+            if (result) {
+                context_.pushValue(result);
+                return;
             }
         }
-        
-        if (available_methods.empty()) {
-            // No methods found
-            llvm::Value* error_result = context_.createStringConstant("method_not_found");
-            context_.pushValue(error_result);
-            return;
+    }
+    
+    // Static type unknown: find every type that can answer this method
+    std::vector<std::string> available_types;
+    std::vector<llvm::Function*> available_methods;
+    for (const auto& type_name : context_.getAllTypeNames()) {
+        llvm::Function* method_func = context_.resolveMethod(type_name, expr->method);
+        if (method_func) {
+            available_types.push_back(type_name);
+            available_methods.push_back(method_func);
         }
-        
-        if (available_methods.size() == 1) {
-            // Only one method available, call it directly
-            llvm::Value* result = context_.getBuilder().CreateCall(available_methods[0], {obj});
-            context_.pushValue(result);
-            return;
+    }
+    
+    if (available_methods.empty()) {
+        context_.pushValue(emitMissingMember("no type defines method " + expr->method));
+        return;
+    }
+    
+    // If the method sits in the same vtable slot with the same signature for
+    // every candidate, a single indirect call covers them all
+    int shared_slot = context_.getVTableSlot(available_types[0], expr->method);
+    llvm::FunctionType* shared_type = available_methods[0]->getFunctionType();
+    bool uniform = shared_slot >= 0;
+    for (size_t i = 1; i < available_types.size() && uniform; ++i) {
+        uniform = context_.getVTableSlot(available_types[i], expr->method) == shared_slot &&
+                  available_methods[i]->getFunctionType() == shared_type;
+    }
+    
+    if (available_methods.size() == 1) {
+        llvm::Value* result = emitMethodCall(shared_type, available_methods[0], args);
+        if (result) {
+            recordProfiledCall(available_methods[0], profile_ ? profile_->callCount(expr->node_id) : 0);
         }
-        
-        // Multiple methods available, need to determine which one to call
-        // Since we don't have type information in the object, we'll use the creation logic
-        
-        // Look at the current code structure to determine which type was actually created
-        // For the specific case of typeA.hulk, we know:
-        // - if x > 0: create A
-        // - if x <= 0: create C (not B!)
-        
-        llvm::BasicBlock* type_check = llvm::BasicBlock::Create(context_.getLLVMContext(), "type_dispatch", function);
-        llvm::BasicBlock* merge_block = llvm::BasicBlock::Create(context_.getLLVMContext(), "dispatch_merge", function);
-        
-        std::vector<llvm::BasicBlock*> call_blocks;
-        std::vector<llvm::Value*> results;
-        
-        // Create call blocks for each available method
-        for (size_t i = 0; i < available_methods.size(); i++) {
-            llvm::BasicBlock* call_block = llvm::BasicBlock::Create(
-                context_.getLLVMContext(), "call_" + available_types[i], function);
-            call_blocks.push_back(call_block);
-            
-            context_.getBuilder().SetInsertPoint(call_block);
-            llvm::Value* result = context_.getBuilder().CreateCall(available_methods[i], {obj});
-            results.push_back(result);
-            context_.getBuilder().CreateBr(merge_block);
+        context_.pushValue(result ? result : emitMissingMember("wrong number of arguments to " + expr->method));
+        return;
+    }
+    if (uniform) {
+        llvm::Value* result = emitVirtualCall(expr, shared_type, object, shared_slot, args);
+        context_.pushValue(result ? result : emitMissingMember("wrong number of arguments to " + expr->method));
+        return;
+    }
+    
+    // With a profile, test the most frequent receiver types first
+    std::vector<size_t> dispatch_order(available_methods.size());
+    std::vector<uint64_t> type_counts(available_methods.size(), 0);
+    for (size_t i = 0; i < available_methods.size(); ++i) {
+        dispatch_order[i] = i;
+    }
+    if (profile_) {
+        for (const auto& entry : profile_->receiverHistogram(expr->node_id)) {
+            auto it = std::find(available_types.begin(), available_types.end(), entry.first);
+            if (it != available_types.end()) {
+                type_counts[it - available_types.begin()] = entry.second;
+            }
         }
-        
-        // Set up dispatch logic
-        context_.getBuilder().CreateBr(type_check);
-        context_.getBuilder().SetInsertPoint(type_check);
-          // For now, use a simple object-pointer-based dispatch
-        // In a real implementation, objects would have type metadata
-        llvm::Value* obj_int = context_.getBuilder().CreatePtrToInt(obj, 
-            llvm::Type::getInt64Ty(context_.getLLVMContext()));
-        
-        // Use object pointer modulo to determine which method to call
-        llvm::Value* type_index = context_.getBuilder().CreateURem(obj_int,
-            llvm::ConstantInt::get(llvm::Type::getInt64Ty(context_.getLLVMContext()), 
-                                   available_methods.size()));
-        
-        // Create switch to dispatch to appropriate method
-        llvm::SwitchInst* switch_inst = context_.getBuilder().CreateSwitch(
-            type_index, call_blocks[0], available_methods.size());
-        
-        for (size_t i = 0; i < available_methods.size(); i++) {
-            switch_inst->addCase(llvm::ConstantInt::get(
-                llvm::Type::getInt64Ty(context_.getLLVMContext()), i), call_blocks[i]);
+        std::stable_sort(dispatch_order.begin(), dispatch_order.end(),
+                         [&](size_t a, size_t b) { return type_counts[a] > type_counts[b]; });
+    }
+    
+    // Slots differ between unrelated types: switch on the type id in the object header
+    llvm::Function* function = context_.getCurrentFunction();
+    llvm::LLVMContext& llvm_context = context_.getLLVMContext();
+    llvm::BasicBlock* type_check = llvm::BasicBlock::Create(llvm_context, "type_dispatch", function);
+    llvm::BasicBlock* merge_block = llvm::BasicBlock::Create(llvm_context, "dispatch_merge", function);
+    llvm::BasicBlock* unknown_block = llvm::BasicBlock::Create(llvm_context, "dispatch_unknown", function);
+    
+    context_.getBuilder().CreateBr(type_check);
+    context_.getBuilder().SetInsertPoint(type_check);
+    llvm::Value* type_id = context_.loadTypeId(object);
+    llvm::SwitchInst* switch_inst = context_.getBuilder().CreateSwitch(
+        type_id, unknown_block, available_methods.size());
+    
+    // Candidates returning different types merge their results as dynamic values
+    llvm::Type* result_type = shared_type->getReturnType();
+    for (llvm::Function* method : available_methods) {
+        if (method->getFunctionType()->getReturnType() != result_type) {
+            result_type = context_.getDynamicValueType();
         }
-          // Set up merge block with PHI node
-        context_.getBuilder().SetInsertPoint(merge_block);
-        
-        if (results.size() > 1) {
-            llvm::PHINode* phi = context_.getBuilder().CreatePHI(results[0]->getType(), results.size(), "dispatch_result");
-            for (size_t i = 0; i < results.size(); i++) {
-                phi->addIncoming(results[i], call_blocks[i]);
-            }
-            context_.pushValue(phi);
-        } else {
-            context_.pushValue(results[0]);
+    }
+    std::vector<std::pair<llvm::Value*, llvm::BasicBlock*>> results;
+    std::vector<uint64_t> case_weights = {0}; // default (unknown type) first
+    for (size_t i : dispatch_order) {
+        llvm::BasicBlock* call_block = llvm::BasicBlock::Create(
+            llvm_context, "call_" + available_types[i], function);
+        context_.getBuilder().SetInsertPoint(call_block);
+        llvm::Value* result = emitMethodCall(available_methods[i]->getFunctionType(), available_methods[i], args);
+        if (!result) {
+            call_block->eraseFromParent();
+            continue;
         }
-        
+        if (result->getType() != result_type) {
+            result = context_.boxValue(result);
+        }
+        switch_inst->addCase(llvm::ConstantInt::get(
+            llvm::Type::getInt32Ty(llvm_context), context_.getTypeId(available_types[i])), call_block);
+        case_weights.push_back(type_counts[i]);
+        recordProfiledCall(available_methods[i], type_counts[i]);
+        results.push_back({result, context_.getBuilder().GetInsertBlock()});
+        context_.getBuilder().CreateBr(merge_block);
+    }
+    if (profile_ && profile_->callCount(expr->node_id) > 0) {
+        // Same +1 smoothing as setBranchWeights; the default block is unreachable
+        std::vector<uint32_t> weights;
+        for (uint64_t count : case_weights) {
+            weights.push_back(static_cast<uint32_t>(std::min<uint64_t>(count, UINT32_MAX - 1) + 1));
+        }
+        switch_inst->setMetadata(llvm::LLVMContext::MD_prof,
+                                 llvm::MDBuilder(llvm_context).createBranchWeights(weights));
+    }
+    
+    // An object whose type does not implement the method cannot reach this call
+    context_.getBuilder().SetInsertPoint(unknown_block);
+    context_.getBuilder().CreateUnreachable();
+    
+    // Set up merge block with PHI node
+    context_.getBuilder().SetInsertPoint(merge_block);
+    if (results.empty() || result_type->isVoidTy()) {
+        context_.pushValue(context_.createNumberConstant(0.0));
+        return;
+    }
+    llvm::PHINode* phi = context_.getBuilder().CreatePHI(result_type, results.size(), "dispatch_result");
+    for (const auto& incoming : results) {
+        phi->addIncoming(incoming.first, incoming.second);
+    }
+    context_.pushValue(phi);
+}
+
+// Attaches the interpreter's branch counts for an if/while condition to its branch
+void LLVMCodeGenerator::setBranchWeights(llvm::Instruction* terminator, int node_id) {
+    const ExecutionProfile::BranchCounts* counts = profile_ ? profile_->branch(node_id) : nullptr;
+    if (!counts) {
         return;
     }
     
-    // Look up method function dynamically
-    std::string full_method_name = object_type + "_" + expr->method;
-    llvm::Function* method_func = context_.lookupFunction(full_method_name);
+    // Scale into 32 bits and add one so that an unseen direction is unlikely, not impossible
+    uint64_t taken = counts->taken;
+    uint64_t not_taken = counts->notTaken;
+    uint64_t scale = std::max(taken, not_taken) / (UINT32_MAX - 1) + 1;
+    llvm::MDNode* weights = llvm::MDBuilder(context_.getLLVMContext()).createBranchWeights(
+        static_cast<uint32_t>(taken / scale + 1), static_cast<uint32_t>(not_taken / scale + 1));
+    terminator->setMetadata(llvm::LLVMContext::MD_prof, weights);
+}
+
+void LLVMCodeGenerator::recordProfiledCall(llvm::Function* callee, uint64_t count) {
+    if (profile_ && callee) {
+        profiled_call_counts_[callee] += count;
+    }
+}
+
+// Hot callees are marked inlinehint; callees whose call sites never ran are marked cold
+void LLVMCodeGenerator::applyProfileInliningHints() {
+    if (!profile_ || profiled_call_counts_.empty()) {
+        return;
+    }
+    uint64_t hottest = 0;
+    for (const auto& entry : profiled_call_counts_) {
+        hottest = std::max(hottest, entry.second);
+    }
+    for (const auto& entry : profiled_call_counts_) {
+        llvm::Function* callee = entry.first;
+        if (callee->isDeclaration() || callee->getName() == "main") {
+            continue;
+        }
+        if (entry.second == 0) {
+            callee->addFnAttr(llvm::Attribute::Cold);
+        } else if (entry.second * 10 >= hottest) {
+            callee->addFnAttr(llvm::Attribute::InlineHint);
+        }
+    }
+}
+
+void LLVMCodeGenerator::multiversionHotFunctions() {
+    if (!multiversion_) {
+        return;
+    }
+    uint64_t hottest = 0;
+    for (const auto& entry : profiled_call_counts_) {
+        hottest = std::max(hottest, entry.second);
+    }
     
-    if (method_func) {
-        llvm::Value* result = context_.getBuilder().CreateCall(method_func, args);
-        context_.pushValue(result);    } else {
-        // Method not found, try polymorphic dispatch
-        // Set up a full dynamic dispatch with all available implementations of this method
-        
-        // Re-generate the object code
-        expr->object->accept(this);
-        llvm::Value* obj = context_.popValue();
-        
-        // Get all types that implement this method
-        auto types = context_.getAllTypeNames();
-        std::vector<std::string> available_types;
-        std::vector<llvm::Function*> available_methods;
-        
-        // For each type, check if it has the method we're looking for
-        for (const auto& type_name : types) {
-            std::string method_name = type_name + "_" + expr->method;
-            llvm::Function* method_func = context_.lookupFunction(method_name);
-            
-            if (method_func) {
-                available_types.push_back(type_name);
-                available_methods.push_back(method_func);
-            }
+    // Only double(double...) functions: their loops are what wider vectors speed up
+    std::vector<llvm::Function*> candidates;
+    for (llvm::Function& function : context_.getModule()) {
+        if (function.isDeclaration() || function.getName() == "main" || !function.getReturnType()->isDoubleTy() ||
+            !std::all_of(function.arg_begin(), function.arg_end(),
+                         [](const llvm::Argument& arg) { return arg.getType()->isDoubleTy(); })) {
+            continue;
         }
-        
-        if (!available_methods.empty()) {
-            // Found methods, implement polymorphic dispatch
-            llvm::Function* function = context_.getCurrentFunction();
-            
-            llvm::BasicBlock* type_check = llvm::BasicBlock::Create(context_.getLLVMContext(), "dynamic_dispatch", function);
-            llvm::BasicBlock* merge_block = llvm::BasicBlock::Create(context_.getLLVMContext(), "dispatch_merge", function);
-            
-            std::vector<llvm::BasicBlock*> call_blocks;
-            std::vector<llvm::Value*> results;
-            
-            // Create call blocks for each available method
-            for (size_t i = 0; i < available_methods.size(); i++) {
-                llvm::BasicBlock* call_block = llvm::BasicBlock::Create(
-                    context_.getLLVMContext(), "call_" + available_types[i], function);
-                call_blocks.push_back(call_block);
-                
-                context_.getBuilder().SetInsertPoint(call_block);
-                llvm::Value* result = context_.getBuilder().CreateCall(available_methods[i], {obj});
-                results.push_back(result);
-                context_.getBuilder().CreateBr(merge_block);
-            }
-            
-            // Set up dispatch logic
-            context_.getBuilder().CreateBr(type_check);
-            context_.getBuilder().SetInsertPoint(type_check);
-            
-            // Use object pointer modulo to determine which method to call
-            llvm::Value* obj_int = context_.getBuilder().CreatePtrToInt(obj, 
-                llvm::Type::getInt64Ty(context_.getLLVMContext()));
-            
-            llvm::Value* type_index = context_.getBuilder().CreateURem(obj_int,
-                llvm::ConstantInt::get(llvm::Type::getInt64Ty(context_.getLLVMContext()), 
-                                       available_methods.size()));
-            
-            // Create switch to dispatch to appropriate method
-            llvm::SwitchInst* switch_inst = context_.getBuilder().CreateSwitch(
-                type_index, call_blocks[0], available_methods.size());
-            
-            for (size_t i = 0; i < available_methods.size(); i++) {
-                switch_inst->addCase(llvm::ConstantInt::get(
-                    llvm::Type::getInt64Ty(context_.getLLVMContext()), i), call_blocks[i]);
-            }
-            
-            // Set up merge block with PHI node
-            context_.getBuilder().SetInsertPoint(merge_block);
-            
-            if (results.size() > 1) {
-                llvm::PHINode* phi = context_.getBuilder().CreatePHI(results[0]->getType(), results.size(), "dispatch_result");
-                for (size_t i = 0; i < results.size(); i++) {
-                    phi->addIncoming(results[i], call_blocks[i]);
-                }
-                context_.pushValue(phi);
-            } else {
-                context_.pushValue(results[0]);
-            }
+        bool hot = false;
+        if (profile_) {
+            auto counts = profiled_call_counts_.find(&function);
+            hot = counts != profiled_call_counts_.end() && counts->second > 0 && counts->second * 10 >= hottest;
         } else {
-            // No methods found
-            llvm::Value* result = context_.createStringConstant("method_not_found");
-            context_.pushValue(result);
+            llvm::SmallVector<std::pair<const llvm::BasicBlock*, const llvm::BasicBlock*>, 4> back_edges;
+            llvm::FindFunctionBackedges(function, back_edges);
+            hot = !back_edges.empty();
+        }
+        if (hot) {
+            candidates.push_back(&function);
+        }
+    }
+    for (llvm::Function* function : candidates) {
+        if (!context_.multiversionFunction(function)) {
+            std::cerr << "Warning: --multiversion needs an x86-64 target, ignored" << std::endl;
+            return;
+        }
+    }
+}
+
+// Virtual call through a vtable slot. When the profile shows one receiver type
+// dominating the call site, that type is tested first and called directly, so
+// the common case can be inlined; other receivers still go through the vtable.
+llvm::Value* LLVMCodeGenerator::emitVirtualCall(MethodCallExpr* expr, llvm::FunctionType* func_type,
+                                                llvm::Value* object, int slot,
+                                                const std::vector<llvm::Value*>& args) {
+    llvm::Function* speculated = nullptr;
+    uint64_t hot_count = 0;
+    uint64_t total = profile_ ? profile_->callCount(expr->node_id) : 0;
+    std::string hot_type;
+    if (total > 0) {
+        auto histogram = profile_->receiverHistogram(expr->node_id);
+        if (!histogram.empty() && histogram[0].second * 10 >= total * 9) {
+            hot_type = histogram[0].first;
+            hot_count = histogram[0].second;
+            speculated = context_.resolveMethod(hot_type, expr->method);
+            if (speculated && (speculated->getFunctionType() != func_type ||
+                               context_.getVTableSlot(hot_type, expr->method) != slot ||
+                               context_.getTypeId(hot_type) <= 0)) {
+                speculated = nullptr;
+            }
+        }
+    }
+    
+    if (!speculated) {
+        return emitMethodCall(func_type, context_.loadVTableSlot(object, slot), args);
+    }
+    
+    llvm::LLVMContext& llvm_context = context_.getLLVMContext();
+    llvm::Function* function = context_.getCurrentFunction();
+    llvm::IRBuilder<>& builder = context_.getBuilder();
+    llvm::BasicBlock* direct_block = llvm::BasicBlock::Create(llvm_context, "devirt_" + hot_type, function);
+    llvm::BasicBlock* virtual_block = llvm::BasicBlock::Create(llvm_context, "devirt_fallback", function);
+    llvm::BasicBlock* merge_block = llvm::BasicBlock::Create(llvm_context, "devirt_merge", function);
+    
+    llvm::Value* is_hot = builder.CreateICmpEQ(
+        context_.loadTypeId(object),
+        llvm::ConstantInt::get(llvm::Type::getInt32Ty(llvm_context), context_.getTypeId(hot_type)),
+        "is_" + hot_type);
+    llvm::BranchInst* guard = builder.CreateCondBr(is_hot, direct_block, virtual_block);
+    guard->setMetadata(
+        llvm::LLVMContext::MD_prof,
+        llvm::MDBuilder(llvm_context).createBranchWeights(
+            static_cast<uint32_t>(std::min<uint64_t>(hot_count, UINT32_MAX - 1) + 1),
+            static_cast<uint32_t>(std::min<uint64_t>(total - hot_count, UINT32_MAX - 1) + 1)));
+    
+    builder.SetInsertPoint(direct_block);
+    llvm::Value* direct_result = emitMethodCall(func_type, speculated, args);
+    recordProfiledCall(speculated, hot_count);
+    llvm::BasicBlock* direct_end = builder.GetInsertBlock();
+    builder.CreateBr(merge_block);
+    
+    builder.SetInsertPoint(virtual_block);
+    llvm::Value* virtual_result = emitMethodCall(func_type, context_.loadVTableSlot(object, slot), args);
+    llvm::BasicBlock* virtual_end = builder.GetInsertBlock();
+    builder.CreateBr(merge_block);
+    
+    builder.SetInsertPoint(merge_block);
+    if (!direct_result || !virtual_result || func_type->getReturnType()->isVoidTy()) {
+        return direct_result && virtual_result ? direct_result : nullptr;
+    }
+    llvm::PHINode* phi = builder.CreatePHI(func_type->getReturnType(), 2, "devirt_result");
+    phi->addIncoming(direct_result, direct_end);
+    phi->addIncoming(virtual_result, virtual_end);
+    return phi;
+}
+
+// True when every implementation of `method` reachable from a receiver of
+// static type `type_name` can be called through `func_type`
+bool LLVMCodeGenerator::overridesMatchSignature(const std::string& type_name, const std::string& method,
+                                                llvm::FunctionType* func_type) {
+    for (const auto& candidate : context_.getAllTypeNames()) {
+        bool subtype = false;
+        for (std::string current = candidate; !current.empty() && !subtype; current = context_.getParentType(current)) {
+            subtype = current == type_name;
+        }
+        llvm::Function* implementation = subtype ? context_.resolveMethod(candidate, method) : nullptr;
+        if (implementation && implementation->getFunctionType() != func_type) {
+            return false;
         }
     }
+    return true;
+}
+
+// Emits a call, converting each argument to its parameter's representation;
+// returns nullptr when the argument count does not match
+llvm::Value* LLVMCodeGenerator::emitMethodCall(llvm::FunctionType* func_type, llvm::Value* callee,
+                                               const std::vector<llvm::Value*>& args) {
+    if (func_type->getNumParams() != args.size()) {
+        return nullptr;
+    }
+    std::vector<llvm::Value*> call_args(args.size());
+    for (unsigned i = 0; i < args.size(); ++i) {
+        call_args[i] = context_.coerceValue(args[i], func_type->getParamType(i));
+    }
+    return context_.getBuilder().CreateCall(func_type, callee, call_args);
+}
+
+// Receivers of member accesses and method calls are object pointers
+llvm::Value* LLVMCodeGenerator::receiverPointer(llvm::Value* object) {
+    if (object->getType()->isPointerTy()) {
+        return object;
+    }
+    return context_.coerceValue(object, llvm::PointerType::getUnqual(context_.getLLVMContext()));
+}
+
+// Reports a member no type provides (at run time, like the interpreter) and yields a dynamic 0
+llvm::Value* LLVMCodeGenerator::emitMissingMember(const std::string& message) {
+    context_.emitDynamicError(message);
+    return llvm::Constant::getNullValue(context_.getDynamicValueType());
+}
+
+// Field read on a receiver of unknown static type: switch on the type id over
+// every type that has the field. The result is boxed only if those fields differ in type.
+llvm::Value* LLVMCodeGenerator::emitDynamicFieldLoad(llvm::Value* object, const std::string& member) {
+    std::vector<std::string> owners;
+    llvm::Type* value_type = nullptr;
+    bool uniform = true;
+    for (const auto& type_name : context_.getAllTypeNames()) {
+        int field_index = context_.getFieldIndex(type_name, member);
+        llvm::StructType* struct_type = context_.lookupType(type_name);
+        if (field_index < 0 || !struct_type || context_.getTypeId(type_name) <= 0) {
+            continue;
+        }
+        llvm::Type* field_type = CodeGenContext::getFieldValueType(
+            struct_type->getElementType(static_cast<unsigned>(field_index)));
+        uniform = uniform && (!value_type || value_type == field_type);
+        value_type = field_type;
+        owners.push_back(type_name);
+    }
+    if (owners.empty()) {
+        return emitMissingMember("no type defines attribute " + member);
+    }
+    llvm::Type* result_type = uniform ? value_type : context_.getDynamicValueType();
+    
+    llvm::LLVMContext& llvm_context = context_.getLLVMContext();
+    llvm::IRBuilder<>& builder = context_.getBuilder();
+    llvm::Function* function = context_.getCurrentFunction();
+    llvm::BasicBlock* merge_block = llvm::BasicBlock::Create(llvm_context, "field_merge", function);
+    llvm::BasicBlock* unknown_block = llvm::BasicBlock::Create(llvm_context, "field_unknown", function);
+    llvm::SwitchInst* switch_inst = builder.CreateSwitch(context_.loadTypeId(object), unknown_block, owners.size());
+    
+    std::vector<std::pair<llvm::Value*, llvm::BasicBlock*>> results;
+    for (const auto& type_name : owners) {
+        llvm::BasicBlock* load_block = llvm::BasicBlock::Create(llvm_context, "field_" + type_name, function);
+        switch_inst->addCase(builder.getInt32(static_cast<uint32_t>(context_.getTypeId(type_name))), load_block);
+        builder.SetInsertPoint(load_block);
+        llvm::Value* value = context_.loadField(context_.lookupType(type_name), object,
+                                                context_.getFieldIndex(type_name, member), member);
+        if (value->getType() != result_type) {
+            value = context_.boxValue(value);
+        }
+        results.push_back({value, builder.GetInsertBlock()});
+        builder.CreateBr(merge_block);
+    }
+    
+    builder.SetInsertPoint(unknown_block);
+    context_.emitDynamicError("object has no attribute " + member);
+    builder.CreateUnreachable();
+    
+    builder.SetInsertPoint(merge_block);
+    llvm::PHINode* phi = builder.CreatePHI(result_type, results.size(), member + "_value");
+    for (const auto& incoming : results) {
+        phi->addIncoming(incoming.first, incoming.second);
+    }
+    return phi;
+}
+
+// Field write on a receiver of unknown static type: the counterpart of
+// emitDynamicFieldLoad, converting the value to each owner's field type
+void LLVMCodeGenerator::emitDynamicFieldStore(llvm::Value* object, const std::string& member, llvm::Value* value) {
+    std::vector<std::string> owners;
+    for (const auto& type_name : context_.getAllTypeNames()) {
+        if (context_.getFieldIndex(type_name, member) >= 0 && context_.lookupType(type_name) &&
+            context_.getTypeId(type_name) > 0) {
+            owners.push_back(type_name);
+        }
+    }
+    if (owners.empty()) {
+        context_.emitDynamicError("no type defines attribute " + member);
+        return;
+    }
+    
+    llvm::LLVMContext& llvm_context = context_.getLLVMContext();
+    llvm::IRBuilder<>& builder = context_.getBuilder();
+    llvm::Function* function = context_.getCurrentFunction();
+    llvm::BasicBlock* merge_block = llvm::BasicBlock::Create(llvm_context, "store_merge", function);
+    llvm::BasicBlock* unknown_block = llvm::BasicBlock::Create(llvm_context, "store_unknown", function);
+    llvm::SwitchInst* switch_inst = builder.CreateSwitch(context_.loadTypeId(object), unknown_block, owners.size());
+    
+    for (const auto& type_name : owners) {
+        llvm::BasicBlock* store_block = llvm::BasicBlock::Create(llvm_context, "store_" + type_name, function);
+        switch_inst->addCase(builder.getInt32(static_cast<uint32_t>(context_.getTypeId(type_name))), store_block);
+        builder.SetInsertPoint(store_block);
+        llvm::StructType* struct_type = context_.lookupType(type_name);
+        int field_index = context_.getFieldIndex(type_name, member);
+        llvm::Type* value_type = CodeGenContext::getFieldValueType(
+            struct_type->getElementType(static_cast<unsigned>(field_index)));
+        context_.storeField(struct_type, object, field_index, context_.coerceValue(value, value_type), member);
+        builder.CreateBr(merge_block);
+    }
+    
+    builder.SetInsertPoint(unknown_block);
+    context_.emitDynamicError("object has no attribute " + member);
+    builder.CreateUnreachable();
+    
+    builder.SetInsertPoint(merge_block);
 }
 
 // StmtVisitor implementations
@@ -831,30 +1381,79 @@ void LLVMCodeGenerator::visit(ExprStmt* stmt) {
 }
 
 void LLVMCodeGenerator::visit(FunctionDecl* func) {
-    // Create new scope for function parameters and local variables
-    context_.pushScope();
+    // Parameters and result the semantic analyzer proved to be numbers stay
+    // unboxed doubles; anything else travels as a dynamic value. Without an
+    // analyzer (the tiered JIT) every function is double(double...).
+    std::vector<llvm::Type*> param_types;
+    bool dynamic_params = false;
+    for (size_t i = 0; i < func->params.size(); ++i) {
+        llvm::Type* param_type = context_.getLLVMType("Number");
+        if (semantic_analyzer_ &&
+            semantic_analyzer_->getFunctionParameterType(func->name, i).getKind() != TypeInfo::Kind::Number) {
+            param_type = context_.getDynamicValueType();
+            dynamic_params = true;
+        }
+        param_types.push_back(param_type);
+    }
+    
+    llvm::Type* return_type = context_.getLLVMType("Number");
+    if (semantic_analyzer_ &&
+        (dynamic_params || semantic_analyzer_->getFunctionReturnType(func->name).getKind() != TypeInfo::Kind::Number)) {
+        return_type = context_.getDynamicValueType();
+    }
+    
+    // Register every version BEFORE generating bodies (to allow recursion and
+    // calls between the specialized clones)
+    std::vector<llvm::Function*> versions;
+    auto declare_version = [&](const std::string& name, const std::vector<llvm::Type*>& params, llvm::Type* result) {
+        llvm::Function* llvm_func = llvm::Function::Create(
+            llvm::FunctionType::get(result, params, false), llvm::Function::ExternalLinkage, name,
+            context_.getModule());
+        context_.declareFunction(name, llvm_func);
+        auto arg_it = llvm_func->arg_begin();
+        for (const auto& param : func->params) {
+            arg_it->setName(param);
+            ++arg_it;
+        }
+        versions.push_back(llvm_func);
+    };
+    declare_version(func->name, param_types, return_type);
     
-    // Create function type
-    std::vector<llvm::Type*> param_types;    for (const auto& param : func->params) {
-        (void)param; // Suppress unused variable warning
-        param_types.push_back(context_.getLLVMType("Number")); // Simplified type mapping
+    // One clone per argument shape the analyzer saw called, so callers passing
+    // numbers or booleans where the generic version boxes skip the boxing
+    if (semantic_analyzer_) {
+        for (const auto& specialization : semantic_analyzer_->getFunctionSpecializations(func->name)) {
+            std::vector<llvm::Type*> specialized_params;
+            for (const auto& type : specialization.parameter_types) {
+                specialized_params.push_back(getValueType(type));
+            }
+            TypeInfo::Kind result = specialization.return_type.getKind();
+            declare_version(specializationName(func->name, specialized_params), specialized_params,
+                            result == TypeInfo::Kind::Number || result == TypeInfo::Kind::Boolean
+                                ? getValueType(specialization.return_type)
+                                : context_.getDynamicValueType());
+        }
     }
     
-    llvm::Type* return_type = context_.getLLVMType("Number"); // Simplified
-    llvm::FunctionType* func_type = llvm::FunctionType::get(return_type, param_types, false);
-      // Create function
-    llvm::Function* llvm_func = llvm::Function::Create(
-        func_type, llvm::Function::ExternalLinkage, func->name, context_.getModule());
-    
-    // Register function BEFORE generating body (to allow recursion)
-    context_.declareFunction(func->name, llvm_func);
-    
-    // Set parameter names
-    auto arg_it = llvm_func->arg_begin();
-    for (const auto& param : func->params) {
-        arg_it->setName(param);
-        ++arg_it;
+    for (llvm::Function* llvm_func : versions) {
+        generateFunctionBody(func, llvm_func);
     }
+}
+
+std::string LLVMCodeGenerator::specializationName(const std::string& name,
+                                                  const std::vector<llvm::Type*>& param_types) {
+    std::string result = name;
+    for (llvm::Type* type : param_types) {
+        result += type->isDoubleTy() ? "$Number" : type->isIntegerTy(1) ? "$Boolean" : "$Any";
+    }
+    return result;
+}
+
+void LLVMCodeGenerator::generateFunctionBody(FunctionDecl* func, llvm::Function* llvm_func) {
+    // Create new scope for function parameters and local variables
+    context_.pushScope();
+    llvm::Type* return_type = llvm_func->getReturnType();
+    std::string name = llvm_func->getName().str();
     
     // Create entry basic block
     llvm::BasicBlock* entry = llvm::BasicBlock::Create(
@@ -863,19 +1462,35 @@ void LLVMCodeGenerator::visit(FunctionDecl* func) {
     
     // Set current function for return statements
     context_.setCurrentFunction(llvm_func);
+    context_.beginFunctionDebugInfo(llvm_func, name, func->line_number);
+    context_.instrumentFunction(llvm_func, name, func->line_number);
     
-    // Declare parameters as variables in the function scope
-    arg_it = llvm_func->arg_begin();
+    // Declare parameters as variables in the function scope (spilled so they can be assigned)
+    auto arg_it = llvm_func->arg_begin();
     for (const auto& param : func->params) {
-        context_.declareVariable(param, &*arg_it);
+        llvm::AllocaInst* slot = context_.createEntryAlloca(arg_it->getType(), param);
+        context_.getBuilder().CreateStore(&*arg_it, slot);
+        context_.declareVariable(param, slot);
         ++arg_it;
     }
-      // Generate function body
-    func->body->accept(this);
+      // Generate function body (block bodies are parsed as a nested Program;
+    // lower its statements in place, keeping the value of the last one)
+    if (auto* block = dynamic_cast<Program*>(func->body.get())) {
+        llvm::Value* last_value = nullptr;
+        for (auto& stmt : block->stmts) {
+            stmt->accept(this);
+            if (context_.peekValue()) {
+                last_value = context_.popValue();
+            }
+        }
+        context_.pushValue(last_value ? last_value : llvm::Constant::getNullValue(return_type));
+    } else {
+        func->body->accept(this);
+    }
       // Create return instruction only if no terminator exists
     llvm::BasicBlock* current_block = context_.getBuilder().GetInsertBlock();
     if (!current_block->getTerminator()) {
-        llvm::Value* return_value = context_.popValue();
+        llvm::Value* return_value = context_.coerceValue(context_.popValue(), return_type);
         context_.getBuilder().CreateRet(return_value);
     }
     
@@ -891,13 +1506,19 @@ void LLVMCodeGenerator::visit(TypeDecl* type) {
         context_.declareInheritance(type->name, type->parentType);
     }
     
-    // Track if type has init method
-    bool hasInitMethod = false;
-    
-    // Step 2: Create struct type definition
+    // Step 2: Create struct type definition and method prototypes
+    // (both are no-ops when the program pass already declared them)
     createStructForType(type);
-    
-    // Step 2: Process each method in the type declaration
+    declareTypeMethods(type);
+    
+    // Step 3: Generate the body of each method in the type declaration
+    if (llvm::Function* init_func = context_.lookupFunction(type->name + "_init")) {
+        bool declares_init = std::any_of(type->methods.begin(), type->methods.end(),
+                                         [](const auto& method) { return method.first == "init"; });
+        if (!declares_init && init_func->empty()) {
+            generateImplicitInit(type, init_func);
+        }
+    }
     for (size_t i = 0; i < type->methodBodies.size() && i < type->methods.size(); ++i) {
         if (type->methodBodies[i]) {
             const auto& method_info = type->methods[i];
@@ -906,74 +1527,24 @@ void LLVMCodeGenerator::visit(TypeDecl* type) {
             
             // Create a unique method name including the type
             std::string full_method_name = type->name + "_" + method_name;
+            llvm::Function* llvm_func = context_.lookupFunction(full_method_name);
+            if (!llvm_func || !llvm_func->empty()) {
+                continue; // Body already generated
+            }
+            llvm::Type* return_type = llvm_func->getReturnType();
             
             // Create new scope for method parameters
             context_.pushScope();
             
-            // Create function type for the method
-            std::vector<llvm::Type*> param_types;
-            // Add 'self' parameter as first parameter (pointer to the specific struct type)
-            llvm::StructType* struct_type = context_.lookupType(type->name);
-            if (struct_type) {
-                param_types.push_back(llvm::PointerType::getUnqual(struct_type));
-            } else {
-                // Fallback to generic pointer
-                param_types.push_back(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext())));
-            }              // Add declared parameters
-            for (const auto& param : method_params) {
-                // For init methods, infer parameter type from corresponding field (including inherited fields)
-                if (method_name == "init" && !method_params.empty()) {
-                    // Get the field type for this parameter position
-                    size_t param_index = &param - &method_params[0];
-                    
-                    // Get all fields (including inherited ones)
-                    std::vector<std::string> all_fields = context_.getTypeFields(type->name);
-                    std::vector<llvm::Type*> all_field_types;
-                    
-                    // Collect parent field types first
-                    if (!type->parentType.empty()) {
-                        llvm::StructType* parent_type = context_.lookupType(type->parentType);
-                        if (parent_type) {
-                            auto parent_field_types = parent_type->elements();
-                            for (auto parent_field_type : parent_field_types) {
-                                all_field_types.push_back(parent_field_type);
-                            }
-                        }
-                    }
-                    
-                    // Add current type fields
-                    for (const auto& attr : type->attributes) {
-                        llvm::Type* field_type = inferFieldType(attr.second);
-                        all_field_types.push_back(field_type);
-                    }
-                    
-                    // Use the appropriate field type for this parameter
-                    if (param_index < all_field_types.size()) {
-                        param_types.push_back(all_field_types[param_index]);
-                    } else {
-                        // Fallback to string for extra parameters
-                        param_types.push_back(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext())));
-                    }                } else {
-                    // For non-init methods, infer parameter type based on method name and parameter name
-                    llvm::Type* param_type = inferParameterType(method_name, param);
-                    param_types.push_back(param_type);
-                }
-            }
-            
-            // Determine return type based on method name and content
-            llvm::Type* return_type = getMethodReturnType(method_name, type->methodBodies[i]);
-            llvm::FunctionType* func_type = llvm::FunctionType::get(return_type, param_types, false);
-            
-            // Create function
-            llvm::Function* llvm_func = llvm::Function::Create(
-                func_type, llvm::Function::ExternalLinkage, full_method_name, context_.getModule());
-            
             // Create entry basic block
             llvm::BasicBlock* entry = llvm::BasicBlock::Create(
                 context_.getLLVMContext(), "entry", llvm_func);
             context_.getBuilder().SetInsertPoint(entry);
               // Set current function for return statements
             context_.setCurrentFunction(llvm_func);
+            int body_line = type->methodBodies[i]->line_number;
+            context_.beginFunctionDebugInfo(llvm_func, full_method_name, body_line > 0 ? body_line : type->line_number);
+            context_.instrumentFunction(llvm_func, full_method_name, body_line);
             
             // Set current context for base method calls
             auto self_arg = llvm_func->arg_begin();
@@ -987,13 +1558,16 @@ void LLVMCodeGenerator::visit(TypeDecl* type) {
             arg_it->setName("self");
             context_.declareVariable("self", &*arg_it);
             ++arg_it;
-              // Declare method parameters as variables
+            // Declare method parameters as variables (spilled so they can be assigned)
             for (const auto& param : method_params) {
                 arg_it->setName(param);
-                context_.declareVariable(param, &*arg_it);
+                llvm::AllocaInst* slot = context_.createEntryAlloca(arg_it->getType(), param);
+                context_.getBuilder().CreateStore(&*arg_it, slot);
+                context_.declareVariable(param, slot);
                 ++arg_it;
             }            // Special handling for init methods
             if (method_name == "init") {
+                generateConstructorPrologue(type, llvm_func);
                 if (method_params.empty()) {
                     // For parameterless init methods, process the AST body
                     type->methodBodies[i]->accept(this);
@@ -1076,6 +1650,8 @@ void LLVMCodeGenerator::visit(TypeDecl* type) {
                         } else if (return_type->isDoubleTy() && return_value->getType()->isPointerTy()) {
                             // Can't convert pointer to double easily, use 0.0
                             return_value = context_.createNumberConstant(0.0);
+                        } else {
+                            return_value = context_.coerceValue(return_value, return_type);
                         }
                     }
                     
@@ -1091,15 +1667,13 @@ void LLVMCodeGenerator::visit(TypeDecl* type) {
             context_.popScope();
         }
     }
-    
-    // Check if type has init method 
-    for (const auto& method_info : type->methods) {
-        if (method_info.first == "init") {
-            hasInitMethod = true;
-            break;
-        }
-    }    
-    // Generate default init method if none was declared
+}
+
+// Declares the implicit init of types that declare none and do not reuse an
+// inherited one: init(self, params...) over the type's constructor parameters,
+// typed by the arguments its `new` sites pass (see generateImplicitInit)
+void LLVMCodeGenerator::createDefaultInitIfNeeded(TypeDecl* type) {
+    bool hasInitMethod = false;
     for (const auto& method_info : type->methods) {
         if (method_info.first == "init") {
             hasInitMethod = true;
@@ -1107,11 +1681,11 @@ void LLVMCodeGenerator::visit(TypeDecl* type) {
         }
     }
     
-    if (!hasInitMethod) {
-        // Create default init method (parameterless)
+    // An inherited init may already have been created for this type
+    if (!hasInitMethod && !context_.lookupFunction(type->name + "_init")) {
         std::string init_name = type->name + "_init";
         
-        // Create function type: takes self pointer, returns self pointer
+        // Create function type: takes self pointer plus the constructor parameters, returns self pointer
         std::vector<llvm::Type*> param_types;
         llvm::StructType* struct_type = context_.lookupType(type->name);
         if (struct_type) {
@@ -1119,47 +1693,308 @@ void LLVMCodeGenerator::visit(TypeDecl* type) {
         } else {
             param_types.push_back(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext())));
         }
+        for (size_t i = 0; i < type->params.size(); ++i) {
+            param_types.push_back(semantic_analyzer_
+                                      ? getValueType(semantic_analyzer_->getConstructorParameterType(type->name, i))
+                                      : context_.getDynamicValueType());
+        }
         
         llvm::Type* return_type = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext()));
         llvm::FunctionType* func_type = llvm::FunctionType::get(return_type, param_types, false);
         
-        // Create function
+        // Create function; the body is generated with the type's methods
         llvm::Function* init_func = llvm::Function::Create(
             func_type, llvm::Function::ExternalLinkage, init_name, context_.getModule());
-        
-        // Create entry basic block
-        llvm::BasicBlock* entry = llvm::BasicBlock::Create(
-            context_.getLLVMContext(), "entry", init_func);
-        context_.getBuilder().SetInsertPoint(entry);
-        
-        // Get self parameter
         auto arg_it = init_func->arg_begin();
-        llvm::Value* self = &*arg_it;
-        
-        // If this type has a parent, call parent init
-        if (!type->parentType.empty()) {
-            std::string parent_init_name = type->parentType + "_init";
-            llvm::Function* parent_init = context_.lookupFunction(parent_init_name);
-            if (parent_init) {
-                context_.getBuilder().CreateCall(parent_init, {self});
-            }
+        arg_it->setName("self");
+        for (const auto& param : type->params) {
+            (++arg_it)->setName(param);
         }
         
-        // Return self
-        context_.getBuilder().CreateRet(self);
-        
         // Register the function
         context_.declareFunction(init_name, init_func);
     }
 }
 
+// Constructor parameters in scope in the implicit init of `type`: its own, or,
+// when it declares none, those of the parent constructor it forwards to
+std::vector<std::string> LLVMCodeGenerator::constructorParameterNames(TypeDecl* type) {
+    for (size_t i = 0; i < type->methods.size(); ++i) {
+        if (type->methods[i].first == "init") {
+            return type->methods[i].second;
+        }
+    }
+    if (!type->params.empty() || type->parentType.empty() || !type->parentArgs.empty()) {
+        return type->params;
+    }
+    auto parent = type_decls_.find(type->parentType);
+    return parent != type_decls_.end() ? constructorParameterNames(parent->second) : std::vector<std::string>();
+}
+
+// What every constructor of `type` does before its own init body: run the
+// parent's init, with the `inherits P(args)` arguments or else this init's own
+// leading ones, then store each attribute initializer. Constructor parameters
+// must already be in scope, and `self` is the first argument of `init_func`.
+void LLVMCodeGenerator::generateConstructorPrologue(TypeDecl* type, llvm::Function* init_func) {
+    llvm::Value* self = &*init_func->arg_begin();
+    if (!type->parentType.empty()) {
+        llvm::Function* parent_init = context_.lookupFunction(type->parentType + "_init");
+        if (parent_init) {
+            llvm::FunctionType* parent_init_type = parent_init->getFunctionType();
+            std::vector<llvm::Value*> parent_args = {self};
+            if (!type->parentArgs.empty()) {
+                for (auto& arg : type->parentArgs) {
+                    arg->accept(this);
+                    parent_args.push_back(context_.popValue());
+                }
+            } else {
+                for (unsigned p = 1; p < parent_init_type->getNumParams() && p < init_func->arg_size(); ++p) {
+                    parent_args.push_back(init_func->getArg(p));
+                }
+            }
+            if (parent_args.size() == parent_init_type->getNumParams()) {
+                for (unsigned p = 1; p < parent_args.size(); ++p) {
+                    parent_args[p] = context_.coerceValue(parent_args[p], parent_init_type->getParamType(p));
+                }
+                context_.getBuilder().CreateCall(parent_init, parent_args);
+            }
+        }
+    }
+    
+    llvm::StructType* struct_type = context_.lookupType(type->name);
+    if (!struct_type) {
+        return;
+    }
+    for (const auto& [attribute, initializer] : type->attributes) {
+        int field_index = context_.getFieldIndex(type->name, attribute);
+        if (!initializer || field_index < 0) {
+            continue;
+        }
+        initializer->accept(this);
+        llvm::Type* value_type = CodeGenContext::getFieldValueType(
+            struct_type->getElementType(static_cast<unsigned>(field_index)));
+        context_.storeField(struct_type, self, field_index,
+                            context_.coerceValue(context_.popValue(), value_type), attribute);
+    }
+}
+
+// Body of an init the type does not declare (see createDefaultInitIfNeeded and
+// createInheritedInitIfNeeded): the constructor prologue, then return self
+void LLVMCodeGenerator::generateImplicitInit(TypeDecl* type, llvm::Function* init_func) {
+    std::string init_name = type->name + "_init";
+    context_.pushScope();
+    llvm::BasicBlock* entry = llvm::BasicBlock::Create(context_.getLLVMContext(), "entry", init_func);
+    context_.getBuilder().SetInsertPoint(entry);
+    context_.setCurrentFunction(init_func);
+    context_.beginFunctionDebugInfo(init_func, init_name, type->line_number);
+    context_.instrumentFunction(init_func, init_name, type->line_number);
+    
+    llvm::Value* self = &*init_func->arg_begin();
+    context_.setCurrentSelf(self);
+    context_.setCurrentType(type->name);
+    context_.declareVariable("self", self);
+    
+    // Parameters are spilled like a method's, so initializers see them as variables
+    std::vector<std::string> params = constructorParameterNames(type);
+    for (size_t i = 0; i < params.size() && i + 1 < init_func->arg_size(); ++i) {
+        llvm::Argument* arg = init_func->getArg(static_cast<unsigned>(i + 1));
+        llvm::AllocaInst* slot = context_.createEntryAlloca(arg->getType(), params[i]);
+        context_.getBuilder().CreateStore(arg, slot);
+        context_.declareVariable(params[i], slot);
+    }
+    
+    generateConstructorPrologue(type, init_func);
+    context_.getBuilder().CreateRet(self);
+    
+    context_.setCurrentSelf(nullptr);
+    context_.setCurrentType("");
+    context_.popScope();
+}
+
+// Signature method i of a type would have on its own, from its parameters and body
+llvm::FunctionType* LLVMCodeGenerator::methodSignature(TypeDecl* type, size_t i) {
+    const auto& method_info = type->methods[i];
+    const std::string& method_name = method_info.first;
+    const auto& method_params = method_info.second;
+    
+    // Create function type for the method
+    std::vector<llvm::Type*> param_types;
+    // Add 'self' parameter as first parameter (pointer to the specific struct type)
+    llvm::StructType* struct_type = context_.lookupType(type->name);
+    if (struct_type) {
+        param_types.push_back(llvm::PointerType::getUnqual(struct_type));
+    } else {
+        // Fallback to generic pointer
+        param_types.push_back(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext())));
+    }
+    
+    // Add declared parameters
+    for (const auto& param : method_params) {
+        // For init methods, infer parameter type from corresponding field (including inherited fields)
+        if (method_name == "init" && !method_params.empty()) {
+            // Get the field type for this parameter position
+            size_t param_index = &param - &method_params[0];
+            
+            // Get all fields (including inherited ones, in declaration order)
+            const std::vector<std::string>& all_fields = context_.getTypeFields(type->name);
+            
+            // Use the value type of the corresponding field for this parameter
+            if (param_index < all_fields.size()) {
+                param_types.push_back(CodeGenContext::getFieldValueType(
+                    context_.getFieldType(type->name, all_fields[param_index])));
+            } else {
+                // Fallback to string for extra parameters
+                param_types.push_back(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext())));
+            }
+        } else {
+            // For non-init methods, use the argument types seen at the calls of
+            // this method name (dynamic if they disagree), else the name heuristics
+            std::optional<TypeInfo> seen;
+            if (semantic_analyzer_) {
+                seen = semantic_analyzer_->getMethodParameterType(method_name, &param - &method_params[0]);
+            }
+            llvm::Type* param_type = seen ? getValueType(*seen) : inferParameterType(method_name, param);
+            param_types.push_back(param_type);
+        }
+    }
+    
+    // Determine return type based on method name and content
+    llvm::Type* return_type = getMethodReturnType(type->name, method_name, type->methodBodies[i]);
+    return llvm::FunctionType::get(return_type, param_types, false);
+}
+
+// Type that first declares `method` among `type` and its ancestors: every
+// override of a method shares that type's vtable slot
+std::string LLVMCodeGenerator::methodRootType(const std::string& type_name, const std::string& method) {
+    std::string root;
+    for (std::string current = type_name; !current.empty(); current = context_.getParentType(current)) {
+        auto decl = type_decls_.find(current);
+        if (decl == type_decls_.end()) {
+            break;
+        }
+        for (const auto& method_info : decl->second->methods) {
+            if (method_info.first == method) {
+                root = current;
+            }
+        }
+    }
+    return root;
+}
+
+// Overrides are called through their base's vtable slot with the base's
+// signature, so each method and all its overrides get one signature: where
+// their own parameter or result types differ, that position is boxed
+// (%hulk.value). Overrides with another arity keep their own signature, and
+// calls that can reach them go through the type-id switch instead.
+void LLVMCodeGenerator::unifyOverrideSignatures(const std::vector<TypeDecl*>& ordered_types) {
+    std::map<std::string, std::vector<llvm::FunctionType*>> families;
+    for (auto* type : ordered_types) {
+        for (size_t i = 0; i < type->methodBodies.size() && i < type->methods.size(); ++i) {
+            const std::string& method_name = type->methods[i].first;
+            if (type->methodBodies[i] && method_name != "init") {
+                families[methodRootType(type->name, method_name) + "." + method_name].push_back(
+                    methodSignature(type, i));
+            }
+        }
+    }
+    
+    llvm::Type* boxed = context_.getDynamicValueType();
+    for (const auto& [key, signatures] : families) {
+        llvm::FunctionType* shared = signatures.front();
+        bool compatible = true;
+        for (llvm::FunctionType* signature : signatures) {
+            compatible = compatible && signature->getNumParams() == shared->getNumParams();
+        }
+        if (signatures.size() < 2 || !compatible) {
+            continue;
+        }
+        llvm::Type* return_type = shared->getReturnType();
+        std::vector<llvm::Type*> param_types(shared->param_begin(), shared->param_end());
+        for (llvm::FunctionType* signature : signatures) {
+            if (signature->getReturnType() != return_type) {
+                return_type = boxed;
+            }
+            // self (parameter 0) is an opaque pointer in every override
+            for (unsigned p = 1; p < param_types.size(); ++p) {
+                if (signature->getParamType(p) != param_types[p]) {
+                    param_types[p] = boxed;
+                }
+            }
+        }
+        override_signatures_[key] = llvm::FunctionType::get(return_type, param_types, false);
+    }
+}
+
+// Creates the (still empty) LLVM function for method i of a type
+llvm::Function* LLVMCodeGenerator::declareMethodPrototype(TypeDecl* type, size_t i) {
+    const std::string& method_name = type->methods[i].first;
+    std::string full_method_name = type->name + "_" + method_name;
+    
+    // Overrides use the signature shared with their base (see unifyOverrideSignatures)
+    auto shared = override_signatures_.find(methodRootType(type->name, method_name) + "." + method_name);
+    llvm::FunctionType* func_type = shared != override_signatures_.end() && method_name != "init"
+                                        ? shared->second
+                                        : methodSignature(type, i);
+    
+    // Create function
+    llvm::Function* llvm_func = llvm::Function::Create(
+        func_type, llvm::Function::ExternalLinkage, full_method_name, context_.getModule());
+    
+    context_.declareFunction(full_method_name, llvm_func);
+    return llvm_func;
+}
+
+// Declares prototypes for all methods of a type, plus its implicit init
+void LLVMCodeGenerator::declareTypeMethods(TypeDecl* type) {
+    for (size_t i = 0; i < type->methodBodies.size() && i < type->methods.size(); ++i) {
+        if (type->methodBodies[i] && !context_.lookupFunction(type->name + "_" + type->methods[i].first)) {
+            declareMethodPrototype(type, i);
+        }
+    }
+    
+    createInheritedInitIfNeeded(type);
+    createDefaultInitIfNeeded(type);
+    
+    if (llvm::StructType* struct_type = context_.lookupType(type->name)) {
+        for (const auto& method_info : type->methods) {
+            llvm::Function* method = context_.lookupFunction(type->name + "_" + method_info.first);
+            if (method && method_info.first != "init") {
+                context_.markSelfParameter(method, struct_type, false);
+            }
+        }
+        if (llvm::Function* init = context_.lookupFunction(type->name + "_init")) {
+            context_.markSelfParameter(init, struct_type, true);
+        }
+    }
+}
+
 // Helper to determine return type based on method name and content
-llvm::Type* LLVMCodeGenerator::getMethodReturnType(const std::string& method_name, const ExprPtr& method_body) {
+llvm::Type* LLVMCodeGenerator::getMethodReturnType(const std::string& type_name, const std::string& method_name,
+                                                  const ExprPtr& method_body) {
     // init methods should return a pointer to the object (self)
     if (method_name == "init") {
         return llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext()));
     }
     
+    // The result type the semantic analyzer inferred from the body, if any
+    if (semantic_analyzer_) {
+        TypeInfo result = semantic_analyzer_->getMethodReturnType(type_name, method_name);
+        if (!result.isUnknown()) {
+            return getValueType(result);
+        }
+        // A call result (another method, possibly overridden) is only known at run time
+        if (dynamic_cast<MethodCallExpr*>(method_body.get())) {
+            return context_.getDynamicValueType();
+        }
+    }
+    
+    // Getters (`=> self.field`) return the value type of the field
+    if (auto* member = dynamic_cast<MemberExpr*>(method_body.get())) {
+        if (dynamic_cast<SelfExpr*>(member->object.get()) && context_.getFieldIndex(type_name, member->member) >= 0) {
+            return CodeGenContext::getFieldValueType(context_.getFieldType(type_name, member->member));
+        }
+    }
+    
     // Methods that commonly return strings based on name patterns
     if (method_name == "speak" || method_name == "getInfo" || method_name == "toString" ||
         method_name == "drive" || method_name == "honk" || method_name == "turbo" ||
@@ -1187,6 +2022,27 @@ llvm::Value* LLVMCodeGenerator::generateBinaryOperation(const std::string& op,
                                                        const std::string& left_type, const std::string& right_type) {
     auto& builder = context_.getBuilder();
     
+    // Dynamic operands: equality compares tag and payload in the runtime; every
+    // other operator unboxes to the representation it works on
+    if (context_.isDynamicValue(left) || context_.isDynamicValue(right)) {
+        if (op == "==" || op == "!=") {
+            llvm::Value* boxed_left = context_.boxValue(left);
+            llvm::Value* boxed_right = context_.boxValue(right);
+            llvm::Value* equal = builder.CreateCall(context_.lookupFunction("hulk_value_equal"), {
+                builder.CreateExtractValue(boxed_left, 0), builder.CreateExtractValue(boxed_left, 1),
+                builder.CreateExtractValue(boxed_right, 0), builder.CreateExtractValue(boxed_right, 1)});
+            llvm::Value* zero = llvm::ConstantInt::get(equal->getType(), 0);
+            return op == "==" ? builder.CreateICmpNE(equal, zero, "eqtmp") : builder.CreateICmpEQ(equal, zero, "netmp");
+        }
+        if (op != "@" && op != "@@") {
+            llvm::Type* operand_type = (op == "&&" || op == "||" || op == "&" || op == "|")
+                                           ? llvm::Type::getInt1Ty(context_.getLLVMContext())
+                                           : context_.getLLVMType("Number");
+            left = context_.coerceValue(left, operand_type);
+            right = context_.coerceValue(right, operand_type);
+        }
+    }
+    
     // Arithmetic operations
     if (op == "+") {
         return builder.CreateFAdd(left, right, "addtmp");
@@ -1199,11 +2055,8 @@ llvm::Value* LLVMCodeGenerator::generateBinaryOperation(const std::string& op,
     } else if (op == "%") {
         return builder.CreateFRem(left, right, "modtmp");
     } else if (op == "^") {
-        // Use pow function
-        llvm::Function* pow_func = context_.lookupFunction("pow");
-        if (pow_func) {
-            return builder.CreateCall(pow_func, {left, right});
-        }
+        // llvm.pow, so the vectorizer can widen it
+        return builder.CreateBinaryIntrinsic(llvm::Intrinsic::pow, left, right, nullptr, "powtmp");
     }
     
     // Your enhanced operators
@@ -1221,27 +2074,62 @@ llvm::Value* LLVMCodeGenerator::generateBinaryOperation(const std::string& op,
         llvm::Value* adjusted = builder.CreateFAdd(mod_result, right);
         return builder.CreateSelect(is_negative, adjusted, mod_result, "enhmodtmp");
     } else if (op == "+++") {
-        // Triple plus: multiply by 3 if numbers, triple concatenate if strings
-        llvm::Value* three = llvm::ConstantFP::get(context_.getLLVMContext(), llvm::APFloat(3.0));
-        llvm::Value* left_times_three = builder.CreateFMul(left, three);
-        return builder.CreateFAdd(left_times_three, right, "tripletmp");    } else if (op == "@") {
-        // String concatenation - ensure both operands are strings
-        llvm::Function* concat_func = context_.lookupFunction("hulk_str_concat");
+        // Triple plus, as in the interpreter: twice the sum of two numbers,
+        // otherwise the concatenation of both operands three times
+        if (left->getType()->isDoubleTy() && right->getType()->isDoubleTy()) {
+            llvm::Value* sum = builder.CreateFAdd(left, right, "addtmp");
+            return builder.CreateFAdd(sum, sum, "tripletmp");
+        }
+        llvm::Function* concat_func = context_.lookupFunction("hulk_string_concat");
+        llvm::Value* left_str = ensureStringType(left, left_type);
+        llvm::Value* right_str = ensureStringType(right, right_type);
+        bool left_temp = isTemporaryString(left_str);
+        bool right_temp = isTemporaryString(right_str) && right_str != left_str;
+        llvm::Value* pair = builder.CreateCall(concat_func, {left_str, right_str});
+        if (left_temp) releaseString(left_str);
+        if (right_temp) releaseString(right_str);
+        llvm::Value* two_pairs = builder.CreateCall(concat_func, {pair, pair});
+        llvm::Value* result = builder.CreateCall(concat_func, {two_pairs, pair}, "tripletmp");
+        releaseString(pair);
+        releaseString(two_pairs);
+        return result;
+    } else if (op == "@" || op == "@@") {
+        // String concatenation (@@ inserts a space) - ensure both operands are strings
+        llvm::Function* concat_func = context_.lookupFunction(
+            op == "@" ? "hulk_string_concat" : "hulk_string_concat_space");
         if (concat_func) {
             // Convert operands to strings if needed
             llvm::Value* left_str = ensureStringType(left, left_type);
             llvm::Value* right_str = ensureStringType(right, right_type);
-            return builder.CreateCall(concat_func, {left_str, right_str});
+            bool left_temp = isTemporaryString(left_str);
+            bool right_temp = isTemporaryString(right_str) && right_str != left_str;
+            llvm::Value* result = builder.CreateCall(concat_func, {left_str, right_str});
+            
+            // Intermediate results of a concatenation chain die here
+            if (left_temp) releaseString(left_str);
+            if (right_temp) releaseString(right_str);
+            return result;
         }
-    } else if (op == "@@") {
-        // String concatenation with space - ensure both operands are strings
-        llvm::Function* concat_space_func = context_.lookupFunction("hulk_str_concat_space");
-        if (concat_space_func) {
-            // Convert operands to strings if needed
-            llvm::Value* left_str = ensureStringType(left, left_type);
-            llvm::Value* right_str = ensureStringType(right, right_type);
-            return builder.CreateCall(concat_space_func, {left_str, right_str});
+    }
+    
+    // String comparison: length check + memcmp in the runtime
+    else if ((op == "==" || op == "!=") && left->getType()->isPointerTy() && right->getType()->isPointerTy()) {
+        if (left_type == "String" || right_type == "String") {
+            llvm::Function* equal_func = context_.lookupFunction("hulk_string_equal");
+            llvm::Value* equal = builder.CreateCall(equal_func, {left, right});
+            llvm::Value* zero = llvm::ConstantInt::get(equal->getType(), 0);
+            return op == "==" ? builder.CreateICmpNE(equal, zero, "streqtmp")
+                              : builder.CreateICmpEQ(equal, zero, "strnetmp");
         }
+        // Objects compare by identity
+        return op == "==" ? builder.CreateICmpEQ(left, right, "eqtmp")
+                          : builder.CreateICmpNE(left, right, "netmp");
+    }
+    
+    // Booleans compare by value
+    else if ((op == "==" || op == "!=") && left->getType()->isIntegerTy(1) && right->getType()->isIntegerTy(1)) {
+        return op == "==" ? builder.CreateICmpEQ(left, right, "eqtmp")
+                          : builder.CreateICmpNE(left, right, "netmp");
     }
     
     // Comparison operations
@@ -1273,6 +2161,10 @@ llvm::Value* LLVMCodeGenerator::generateUnaryOperation(const std::string& op,
                                                       llvm::Value* operand, const std::string& operand_type) {
     (void)operand_type; // Suppress unused parameter warning
     auto& builder = context_.getBuilder();
+    if (context_.isDynamicValue(operand)) {
+        operand = context_.coerceValue(operand, op == "!" ? llvm::Type::getInt1Ty(context_.getLLVMContext())
+                                                          : context_.getLLVMType("Number"));
+    }
     
     if (op == "-") {
         llvm::Value* zero = llvm::ConstantFP::get(context_.getLLVMContext(), llvm::APFloat(0.0));
@@ -1287,29 +2179,38 @@ llvm::Value* LLVMCodeGenerator::generateUnaryOperation(const std::string& op,
 llvm::Value* LLVMCodeGenerator::generateBuiltinCall(const std::string& name, 
                                                     const std::vector<llvm::Value*>& args) {
     auto& builder = context_.getBuilder();
-      if (name == "print") {
+    if (name == "print") {
         if (!args.empty()) {
-            llvm::Function* puts_func = context_.lookupFunction("puts");
-            if (puts_func) {
-                llvm::Value* result = builder.CreateCall(puts_func, {args[0]});
-                return result;
+            // Pick the runtime printer from the argument's representation
+            llvm::Value* arg = args[0];
+            llvm::Type* arg_type = arg->getType();
+            if (arg_type->isDoubleTy()) {
+                builder.CreateCall(context_.lookupFunction("hulk_print_number"), {arg});
+            } else if (arg_type->isIntegerTy(1)) {
+                llvm::Value* as_int = builder.CreateZExt(arg, llvm::Type::getInt32Ty(context_.getLLVMContext()));
+                builder.CreateCall(context_.lookupFunction("hulk_print_boolean"), {as_int});
+            } else if (arg_type->isPointerTy()) {
+                bool temporary = isTemporaryString(arg);
+                builder.CreateCall(context_.lookupFunction("hulk_print_string"), {arg});
+                if (temporary) releaseString(arg);
+            } else if (context_.isDynamicValue(arg)) {
+                context_.callDynamicHelper("hulk_value_print", arg);
             }
+            builder.CreateCall(context_.lookupFunction("hulk_println"), {});
         }
-        // Return 0 if no args or puts not found
+        // print evaluates to 0, as puts-based printing did
         return llvm::ConstantInt::get(context_.getLLVMContext(), llvm::APInt(32, 0));
-    }else if (name == "debug") {
-        // For debug, we'll print the value and return it
+    } else if (name == "debug") {
+        // For debug, we'll print the value (of any representation) and return it
         if (!args.empty()) {
-            llvm::Function* printf_func = context_.lookupFunction("printf");
-            if (printf_func) {
-                llvm::Value* format = context_.createStringConstant("DEBUG: %g\n");
-                builder.CreateCall(printf_func, {format, args[0]});
-                return args[0]; // Return the original value
-            }
+            builder.CreateCall(context_.lookupFunction("hulk_print_string"), {context_.createStringLiteral("DEBUG: ")});
+            context_.callDynamicHelper("hulk_value_print", context_.boxValue(args[0]));
+            builder.CreateCall(context_.lookupFunction("hulk_println"), {});
+            return args[0]; // Return the original value
         }
     } else if (name == "type") {
         // Return type as string (simplified)
-        return context_.createStringConstant("Number"); // Simplified
+        return context_.createStringLiteral("Number"); // Simplified
     } else if (name == "assert") {
         // Simple assertion implementation
         if (args.size() >= 1) {
@@ -1335,9 +2236,27 @@ llvm::Value* LLVMCodeGenerator::generateBuiltinCall(const std::string& name,
             return context_.createBooleanConstant(true);
         }
     } else if (name == "sin" || name == "cos" || name == "sqrt" || name == "exp") {
-        llvm::Function* func = context_.lookupFunction(name);
-        if (func && !args.empty()) {
-            return builder.CreateCall(func, {args[0]});
+        // Intrinsics keep libm semantics (NaN outside the domain) but are known to
+        // LLVM: they constant-fold, and with a vector library they vectorize
+        if (!args.empty()) {
+            llvm::Intrinsic::ID id = name == "sin" ? llvm::Intrinsic::sin
+                                   : name == "cos" ? llvm::Intrinsic::cos
+                                   : name == "sqrt" ? llvm::Intrinsic::sqrt
+                                   : llvm::Intrinsic::exp;
+            return builder.CreateUnaryIntrinsic(id, args[0], nullptr, name + "tmp");
+        }
+    } else if (name == "pow") {
+        if (args.size() == 2) {
+            return builder.CreateBinaryIntrinsic(llvm::Intrinsic::pow, args[0], args[1], nullptr, "powtmp");
+        }
+    } else if (name == "log") {
+        // log(x) is the natural logarithm; log(base, x) = ln(x) / ln(base)
+        if (args.size() == 1) {
+            return builder.CreateUnaryIntrinsic(llvm::Intrinsic::log, args[0], nullptr, "logtmp");
+        } else if (args.size() == 2) {
+            llvm::Value* ln_base = builder.CreateUnaryIntrinsic(llvm::Intrinsic::log, args[0]);
+            llvm::Value* ln_x = builder.CreateUnaryIntrinsic(llvm::Intrinsic::log, args[1]);
+            return builder.CreateFDiv(ln_x, ln_base, "logtmp");
         }
     } else if (name == "rand") {
         llvm::Function* func = context_.lookupFunction("hulk_rand");
@@ -1356,32 +2275,15 @@ llvm::Value* LLVMCodeGenerator::generateBuiltinCall(const std::string& name,
             llvm::Value* arg = args[0];
             llvm::Type* arg_type = arg->getType();
             
-            if (arg_type->isDoubleTy()) {
-                // Convert double to string
-                llvm::Function* double_to_str_func = context_.lookupFunction("hulk_double_to_str");
-                if (double_to_str_func) {
-                    return builder.CreateCall(double_to_str_func, {arg});
-                }
-            } else if (arg_type->isIntegerTy(1)) {
-                // Convert boolean to string
-                llvm::Function* bool_to_str_func = context_.lookupFunction("hulk_bool_to_str");
-                if (bool_to_str_func) {
-                    return builder.CreateCall(bool_to_str_func, {arg});
-                }
-            } else if (arg_type->isIntegerTy()) {
-                // Convert integer to double first, then to string
-                llvm::Value* as_double = builder.CreateSIToFP(arg, llvm::Type::getDoubleTy(context_.getLLVMContext()));
-                llvm::Function* double_to_str_func = context_.lookupFunction("hulk_double_to_str");
-                if (double_to_str_func) {
-                    return builder.CreateCall(double_to_str_func, {as_double});
-                }
-            } else if (arg_type->isPointerTy()) {
+            if (arg_type->isPointerTy()) {
                 // Already a string, return as-is
                 return arg;
+            } else if (arg_type->isDoubleTy() || arg_type->isIntegerTy() || context_.isDynamicValue(arg)) {
+                return ensureStringType(arg, "");
             }
             
             // Fallback: return a placeholder string
-            return context_.createStringConstant("<?>");
+            return context_.createStringLiteral("<?>");
         }
     }
       // Return null if function not found or implemented
@@ -1399,78 +2301,188 @@ llvm::Value* LLVMCodeGenerator::ensureStringType(llvm::Value* value, const std::
         return value;
     }
     
+    if (context_.isDynamicValue(value)) {
+        return context_.callDynamicHelper("hulk_value_to_string", value);
+    }
+    
     // If it's a double, convert to string
     if (value->getType()->isDoubleTy()) {
-        llvm::Function* double_to_str_func = context_.lookupFunction("hulk_double_to_str");
-        if (double_to_str_func) {
-            return builder.CreateCall(double_to_str_func, {value});
-        }
+        return builder.CreateCall(context_.lookupFunction("hulk_str_number"), {value});
     }
     
     // If it's a boolean (i1), convert to string
     if (value->getType()->isIntegerTy(1)) {
-        llvm::Function* bool_to_str_func = context_.lookupFunction("hulk_bool_to_str");
-        if (bool_to_str_func) {
-            return builder.CreateCall(bool_to_str_func, {value});
-        }
+        llvm::Value* as_int = builder.CreateZExt(value, llvm::Type::getInt32Ty(context_.getLLVMContext()));
+        return builder.CreateCall(context_.lookupFunction("hulk_str_boolean"), {as_int});
     }
     
     // For other integer types, convert to double first, then to string
     if (value->getType()->isIntegerTy()) {
         llvm::Value* as_double = builder.CreateSIToFP(value, llvm::Type::getDoubleTy(context_.getLLVMContext()));
-        llvm::Function* double_to_str_func = context_.lookupFunction("hulk_double_to_str");
-        if (double_to_str_func) {
-            return builder.CreateCall(double_to_str_func, {as_double});
-        }
+        return builder.CreateCall(context_.lookupFunction("hulk_str_number"), {as_double});
     }
     
     // Fallback: return a placeholder string
-    return context_.createStringConstant("<?>");
+    return context_.createStringLiteral("<?>");
+}
+
+// Flattens nested @ / @@ in evaluation order; the flag tells whether @@ put a space before the operand
+void LLVMCodeGenerator::collectConcatOperands(Expr* expr, bool space_before,
+                                              std::vector<std::pair<Expr*, bool>>& operands) {
+    auto* binary = dynamic_cast<BinaryExpr*>(expr);
+    if (binary && (binary->op == BinaryExpr::Op::OP_CONCAT || binary->op == BinaryExpr::Op::OP_CONCAT_SPACE)) {
+        collectConcatOperands(binary->left.get(), space_before, operands);
+        collectConcatOperands(binary->right.get(), binary->op == BinaryExpr::Op::OP_CONCAT_SPACE, operands);
+        return;
+    }
+    operands.emplace_back(expr, space_before);
+}
+
+llvm::Value* LLVMCodeGenerator::generateConcatChain(BinaryExpr* expr) {
+    std::vector<std::pair<Expr*, bool>> operands;
+    collectConcatOperands(expr, false, operands);
+    
+    // Each part is either folded literal text (value == null) or a runtime string
+    struct Part {
+        std::string text;
+        llvm::Value* value = nullptr;
+        bool temporary = false;
+    };
+    std::vector<Part> parts;
+    auto append_text = [&](const std::string& text) {
+        if (parts.empty() || parts.back().value) parts.emplace_back();
+        parts.back().text += text;
+    };
+    for (const auto& [operand, space_before] : operands) {
+        if (space_before) append_text(" ");
+        if (auto* literal = dynamic_cast<StringExpr*>(operand)) {
+            append_text(literal->value);
+            continue;
+        }
+        operand->accept(this);
+        Part part;
+        part.value = ensureStringType(context_.popValue(), "String");
+        part.temporary = isTemporaryString(part.value) &&
+            std::none_of(parts.begin(), parts.end(), [&](const Part& p) { return p.value == part.value; });
+        parts.push_back(std::move(part));
+    }
+    
+    std::vector<llvm::Value*> values;
+    for (const auto& part : parts) {
+        values.push_back(part.value ? part.value : context_.createStringLiteral(part.text));
+    }
+    if (values.size() == 1) {
+        return values[0];
+    }
+    
+    auto& builder = context_.getBuilder();
+    llvm::Value* result;
+    if (values.size() == 2) {
+        result = builder.CreateCall(context_.lookupFunction("hulk_string_concat"), values);
+    } else {
+        // The parts go in a stack array so the runtime sizes the result once
+        llvm::Type* ptr_type = values[0]->getType();
+        llvm::AllocaInst* array = context_.createEntryAlloca(
+            llvm::ArrayType::get(ptr_type, values.size()), "concat_parts");
+        for (size_t i = 0; i < values.size(); ++i) {
+            builder.CreateStore(values[i], builder.CreateConstInBoundsGEP2_64(array->getAllocatedType(), array, 0, i));
+        }
+        llvm::Value* count = llvm::ConstantInt::get(llvm::Type::getInt64Ty(context_.getLLVMContext()), values.size());
+        result = builder.CreateCall(context_.lookupFunction("hulk_string_concat_n"), {array, count});
+    }
+    
+    // Intermediate results of the chain die here
+    for (const auto& part : parts) {
+        if (part.temporary) releaseString(part.value);
+    }
+    return result;
+}
+
+// A string is a temporary when it was just produced by a runtime call and nothing else uses it yet
+bool LLVMCodeGenerator::isTemporaryString(llvm::Value* value) {
+    auto* call = llvm::dyn_cast<llvm::CallInst>(value);
+    if (!call || !call->use_empty() || !call->getCalledFunction()) {
+        return false;
+    }
+    llvm::StringRef callee = call->getCalledFunction()->getName();
+    return callee == "hulk_string_concat" || callee == "hulk_string_concat_space" || callee == "hulk_string_concat_n" ||
+           callee == "hulk_str_number" || callee == "hulk_str_boolean" || callee == "hulk_value_to_string";
+}
+
+void LLVMCodeGenerator::releaseString(llvm::Value* value) {
+    context_.getBuilder().CreateCall(context_.lookupFunction("hulk_string_release"), {value});
 }
 
 // Helper function to create struct types for custom types
 void LLVMCodeGenerator::createStructForType(TypeDecl* type) {
-    std::vector<llvm::Type*> field_types;
+    if (context_.lookupType(type->name)) {
+        return; // Already laid out by the program pass
+    }
+    
+    // Every object starts with the header: { i32 type_id, ptr vtable }
+    std::vector<llvm::Type*> field_types = {
+        llvm::Type::getInt32Ty(context_.getLLVMContext()),
+        llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext()))};
     std::vector<std::string> field_names;
+    std::vector<int> field_slots;
     
-    // Collect fields from the type declaration with proper type inference
-    for (const auto& attr : type->attributes) {
-        llvm::Type* field_type = inferFieldType(attr.second);
-        field_types.push_back(field_type);
-        field_names.push_back(attr.first);
-    }      // Handle inheritance - if this type inherits from another, include parent fields first
+    // Handle inheritance - the parent's fields come first, in the parent's
+    // layout, so a subtype object can be used wherever the parent is expected
+    std::vector<std::string> vtable_layout;
     if (!type->parentType.empty()) {
         llvm::StructType* parent_type = context_.lookupType(type->parentType);
         if (parent_type) {
-            // Get parent field names and insert them first
-            std::vector<std::string> parent_fields = context_.getTypeFields(type->parentType);
-            
-            // Insert parent fields at the beginning
-            field_names.insert(field_names.begin(), parent_fields.begin(), parent_fields.end());
-            
-            // Insert parent field types at the beginning - use the actual parent field types
             auto parent_field_types = parent_type->elements();
-            for (size_t i = 0; i < parent_fields.size() && i < parent_field_types.size(); ++i) {
-                field_types.insert(field_types.begin() + i, parent_field_types[i]);
+            field_types.assign(parent_field_types.begin(), parent_field_types.end());
+            for (const auto& parent_field : context_.getTypeFields(type->parentType)) {
+                field_names.push_back(parent_field);
+                field_slots.push_back(context_.getFieldIndex(type->parentType, parent_field) -
+                                      static_cast<int>(CodeGenContext::kObjectHeaderFields));
             }
+            
+            // Inherited methods keep their slots so a subtype's vtable is a prefix-compatible extension
+            vtable_layout = context_.getVTableLayout(type->parentType);
         }
     }
     
+    // Own fields are typed by the semantic analysis and laid out by decreasing
+    // alignment (stable, so equal fields keep declaration order) to avoid padding
+    const llvm::DataLayout& data_layout = context_.getModule().getDataLayout();
+    std::vector<std::pair<llvm::Type*, size_t>> own_fields;
+    for (const auto& attr : type->attributes) {
+        own_fields.emplace_back(getFieldStorageType(type, attr.first, attr.second), field_names.size());
+        field_names.push_back(attr.first);
+        field_slots.push_back(-1);
+    }
+    std::stable_sort(own_fields.begin(), own_fields.end(), [&](const auto& a, const auto& b) {
+        return data_layout.getABITypeAlignment(a.first) > data_layout.getABITypeAlignment(b.first);
+    });
+    for (const auto& [field_type, name_index] : own_fields) {
+        field_slots[name_index] = static_cast<int>(field_types.size() - CodeGenContext::kObjectHeaderFields);
+        field_types.push_back(field_type);
+    }
+    
     // Create the struct type
     llvm::StructType* struct_type = llvm::StructType::create(
         context_.getLLVMContext(), field_types, type->name);
     
     // Register the type
-    context_.declareType(type->name, struct_type, field_names);
+    context_.declareType(type->name, struct_type, field_names, field_slots);
     
-    // Create automatic init method if type inherits but doesn't have explicit init
-    createInheritedInitIfNeeded(type);
+    // Overrides reuse the parent's slot; new methods get appended. init is never virtual.
+    for (const auto& method_info : type->methods) {
+        if (method_info.first == "init") {
+            continue;
+        }
+        if (std::find(vtable_layout.begin(), vtable_layout.end(), method_info.first) == vtable_layout.end()) {
+            vtable_layout.push_back(method_info.first);
+        }
+    }
+    context_.createVTable(type->name, vtable_layout);
 }
 
 // Helper function to generate init method body with real field assignments
 void LLVMCodeGenerator::generateInitMethodBody(TypeDecl* type, const std::vector<std::string>& method_params, llvm::Function* llvm_func) {
-    auto& builder = context_.getBuilder();
-    
     // Get the self parameter (first parameter)
     auto arg_it = llvm_func->arg_begin();
     llvm::Value* self = &*arg_it;
@@ -1484,54 +2496,26 @@ void LLVMCodeGenerator::generateInitMethodBody(TypeDecl* type, const std::vector
     }
     
     // Get field names for this type
-    std::vector<std::string> field_names = context_.getTypeFields(type->name);
+    const std::vector<std::string>& field_names = context_.getTypeFields(type->name);
     
     // Store each parameter into the corresponding field
     for (size_t i = 0; i < method_params.size() && i < field_names.size(); ++i) {
         llvm::Value* param_value = &*arg_it;
         ++arg_it;
         
-        // Create GEP to access the field
-        llvm::Value* field_ptr = builder.CreateStructGEP(
-            struct_type, self, static_cast<unsigned>(i), 
-            field_names[i] + "_ptr");
-        
         // Store the parameter value into the field
-        // Note: Type compatibility should be ensured by the caller
-        builder.CreateStore(param_value, field_ptr);
-    }
-      // Handle inheritance - call parent init if needed
-    if (!type->parentType.empty() && !method_params.empty()) {
-        // For inherited types, call parent init with appropriate parameters
-        std::string parent_init_name = type->parentType + "_init";
-        llvm::Function* parent_init = context_.lookupFunction(parent_init_name);
-        if (parent_init) {
-            // Determine how many parameters the parent init takes
-            size_t parent_param_count = parent_init->arg_size() - 1; // Exclude self
-            
-            std::vector<llvm::Value*> parent_args;
-            parent_args.push_back(self); // self parameter
-            
-            // Add the required number of parameters for parent init
-            auto param_it = llvm_func->arg_begin();
-            ++param_it; // Skip self
-            
-            // Pass the first parent_param_count parameters to parent init
-            for (size_t i = 0; i < parent_param_count && param_it != llvm_func->arg_end(); ++i) {
-                parent_args.push_back(&*param_it);
-                ++param_it;
-            }
-            
-            builder.CreateCall(parent_init, parent_args);
-        }
+        int field_index = context_.getFieldIndex(type->name, field_names[i]);
+        context_.storeField(struct_type, self, field_index, param_value, field_names[i]);
     }
 }
 
-// Helper function to create inherited init methods automatically
+// Helper function to create inherited init methods automatically: a type with
+// no init, no constructor parameters and no `inherits P(args)` takes its
+// parent's constructor arguments
 void LLVMCodeGenerator::createInheritedInitIfNeeded(TypeDecl* type) {
     // Check if this type inherits from another but doesn't have its own init
     std::string parent_type = context_.getParentType(type->name);
-    if (!parent_type.empty()) {
+    if (!parent_type.empty() && type->params.empty() && type->parentArgs.empty()) {
         bool has_own_init = false;
         for (const auto& method : type->methods) {
             if (method.first == "init") {
@@ -1540,11 +2524,13 @@ void LLVMCodeGenerator::createInheritedInitIfNeeded(TypeDecl* type) {
             }
         }
         
-        if (!has_own_init) {
-            // Create an init method that delegates to parent
-            std::string init_name = type->name + "_init";
-            
-            // Create function type for init (self + one parameter for name)
+        // The parent's init must already be declared (types are processed parents first)
+        std::string parent_init_name = parent_type + "_init";
+        llvm::Function* parent_init = context_.lookupFunction(parent_init_name);
+        std::string init_name = type->name + "_init";
+        
+        if (!has_own_init && parent_init && !context_.lookupFunction(init_name)) {
+            // Create an init method with the same parameters as the parent's
             std::vector<llvm::Type*> param_types;
             llvm::StructType* struct_type = context_.lookupType(type->name);
             if (struct_type) {
@@ -1552,35 +2538,19 @@ void LLVMCodeGenerator::createInheritedInitIfNeeded(TypeDecl* type) {
             } else {
                 param_types.push_back(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext())));
             }
-            param_types.push_back(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext()))); // name parameter
+            llvm::FunctionType* parent_init_type = parent_init->getFunctionType();
+            for (unsigned p = 1; p < parent_init_type->getNumParams(); ++p) {
+                param_types.push_back(parent_init_type->getParamType(p));
+            }
             
             llvm::Type* return_type = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context_.getLLVMContext()));
             llvm::FunctionType* func_type = llvm::FunctionType::get(return_type, param_types, false);
             
-            // Create function
+            // Create function; the body (forward to the parent, then the own
+            // attribute initializers) is generated with the type's methods
             llvm::Function* init_func = llvm::Function::Create(
                 func_type, llvm::Function::ExternalLinkage, init_name, context_.getModule());
-            
-            // Create entry basic block
-            llvm::BasicBlock* entry = llvm::BasicBlock::Create(
-                context_.getLLVMContext(), "entry", init_func);
-            context_.getBuilder().SetInsertPoint(entry);
-            
-            // Get parameters
-            auto arg_it = init_func->arg_begin();
-            llvm::Value* self = &*arg_it;
-            ++arg_it;
-            llvm::Value* name_param = &*arg_it;
-            
-            // Call parent init
-            std::string parent_init_name = parent_type + "_init";
-            llvm::Function* parent_init = context_.lookupFunction(parent_init_name);
-            if (parent_init) {
-                context_.getBuilder().CreateCall(parent_init, {self, name_param});
-            }
-            
-            // Return self
-            context_.getBuilder().CreateRet(self);
+            init_func->arg_begin()->setName("self");
             
             // Register the function
             context_.declareFunction(init_name, init_func);
@@ -1740,17 +2710,14 @@ void LLVMCodeGenerator::generateMainContent(Program* prog) {
     
     // then block
     builder.SetInsertPoint(then_block);
-    llvm::Function* malloc_func = context_.lookupFunction("malloc");
-    llvm::Value* size_a = llvm::ConstantInt::get(context_.getLLVMContext(), llvm::APInt(64, 8));
-    llvm::Value* obj_a = builder.CreateCall(malloc_func, {size_a});
+    llvm::Value* obj_a = context_.createObjectAllocation("A");
     llvm::Function* a_init = context_.lookupFunction("A_init");
     llvm::Value* init_a = builder.CreateCall(a_init, {obj_a});
     builder.CreateBr(merge_block);
     
     // else block  
     builder.SetInsertPoint(else_block);
-    llvm::Value* size_b = llvm::ConstantInt::get(context_.getLLVMContext(), llvm::APInt(64, 8));
-    llvm::Value* obj_b = builder.CreateCall(malloc_func, {size_b});
+    llvm::Value* obj_b = context_.createObjectAllocation("B");
     llvm::Function* b_init = context_.lookupFunction("B_init.2");
     if (!b_init) {
         b_init = context_.lookupFunction("B_init");
@@ -1783,6 +2750,29 @@ void LLVMCodeGenerator::generateMainContent(Program* prog) {
 }
 
 // Helper to infer field type from default value
+// Layout type of an attribute: the semantic analyzer's inferred type, or the
+// default-value heuristic when it has none. Booleans are stored as i8.
+llvm::Type* LLVMCodeGenerator::getFieldStorageType(TypeDecl* type, const std::string& field_name, Expr* default_value) {
+    llvm::LLVMContext& llvm_context = context_.getLLVMContext();
+    if (semantic_analyzer_) {
+        switch (semantic_analyzer_->getAttributeType(type->name, field_name).getKind()) {
+            case TypeInfo::Kind::Number:
+                return llvm::Type::getDoubleTy(llvm_context);
+            case TypeInfo::Kind::Boolean:
+                return llvm::Type::getInt8Ty(llvm_context);
+            case TypeInfo::Kind::String:
+            case TypeInfo::Kind::Object:
+                return llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(llvm_context));
+            default:
+                // Attributes no inference could pin down keep the boxed value
+                // they were initialized with
+                return context_.getDynamicValueType();
+        }
+    }
+    llvm::Type* field_type = inferFieldType(default_value);
+    return field_type->isIntegerTy(1) ? llvm::Type::getInt8Ty(llvm_context) : field_type;
+}
+
 llvm::Type* LLVMCodeGenerator::inferFieldType(Expr* default_value) {
     if (!default_value) {
         // No default value, assume pointer type (string)
@@ -1836,6 +2826,20 @@ bool LLVMCodeGenerator::containsStringOperations(Expr* expr) {
 }
 
 // Helper to infer parameter type based on method name and parameter name
+llvm::Type* LLVMCodeGenerator::getValueType(const TypeInfo& type) {
+    switch (type.getKind()) {
+        case TypeInfo::Kind::Number:
+            return llvm::Type::getDoubleTy(context_.getLLVMContext());
+        case TypeInfo::Kind::Boolean:
+            return llvm::Type::getInt1Ty(context_.getLLVMContext());
+        case TypeInfo::Kind::String:
+        case TypeInfo::Kind::Object:
+            return llvm::PointerType::getUnqual(context_.getLLVMContext());
+        default:
+            return context_.getDynamicValueType();
+    }
+}
+
 llvm::Type* LLVMCodeGenerator::inferParameterType(const std::string& method_name, const std::string& param_name) {
     // If we have semantic analyzer, try to get type information from it
     if (semantic_analyzer_) {
@@ -1,10 +1,12 @@
 #pragma once
 #include "../AST/ast.hpp"
+#include "../Profile/execution_profile.hpp"
 #include "CodeGenContext.hpp"
 #include "llvm/IR/Value.h"
 
-// Forward declaration to avoid circular includes
+// Forward declarations to avoid circular includes
 class SemanticAnalyzer;
+class TypeInfo;
 
 /**
  * @brief LLVM IR code generator using the visitor pattern
@@ -21,6 +23,15 @@ private:
     // Reference to semantic analyzer for type information
     class SemanticAnalyzer* semantic_analyzer_;
     
+    // Interpreter profile (--profile-use), null when compiling without one
+    const ExecutionProfile* profile_ = nullptr;
+    bool integer_counters_ = true;
+    bool multiversion_ = false;
+    bool verbose_ = false;
+    std::map<llvm::Function*, uint64_t> profiled_call_counts_; // direct calls seen per callee
+    std::map<std::string, TypeDecl*> type_decls_; // declarations by name, filled by the layout pass
+    std::map<std::string, llvm::FunctionType*> override_signatures_; // "Root.method" -> signature of every override
+    
     // Helper methods for built-in operations
     llvm::Value* generateBinaryOperation(const std::string& op, 
                                         llvm::Value* left, llvm::Value* right,
@@ -36,6 +47,15 @@ private:
     // Helper to ensure a value is converted to string type for concatenation
     llvm::Value* ensureStringType(llvm::Value* value, const std::string& type_hint);
     
+    // Concatenation chains (a @ b @@ c ...): literal runs are folded at compile
+    // time and the rest is joined by one n-ary runtime call
+    void collectConcatOperands(Expr* expr, bool space_before, std::vector<std::pair<Expr*, bool>>& operands);
+    llvm::Value* generateConcatChain(BinaryExpr* expr);
+    
+    // Helpers for runtime string refcounting of unnamed intermediate strings
+    bool isTemporaryString(llvm::Value* value);
+    void releaseString(llvm::Value* value);
+    
     // Helper to create struct types for custom types
     void createStructForType(TypeDecl* type);
     
@@ -44,11 +64,54 @@ private:
     
     // Helper to create inherited init methods automatically
     void createInheritedInitIfNeeded(TypeDecl* type);
+    
+    // Helper to declare the init of types without one, over their constructor parameters
+    void createDefaultInitIfNeeded(TypeDecl* type);
+    
+    // Helpers to generate constructor bodies: the parent init call and the
+    // attribute initializer stores every init starts with, and the whole body
+    // of inits the type does not declare
+    std::vector<std::string> constructorParameterNames(TypeDecl* type);
+    void generateConstructorPrologue(TypeDecl* type, llvm::Function* init_func);
+    void generateImplicitInit(TypeDecl* type, llvm::Function* init_func);
+    
+    // Helpers to declare method prototypes before any body is generated
+    llvm::FunctionType* methodSignature(TypeDecl* type, size_t method_index);
+    std::string methodRootType(const std::string& type_name, const std::string& method);
+    void unifyOverrideSignatures(const std::vector<TypeDecl*>& ordered_types);
+    llvm::Function* declareMethodPrototype(TypeDecl* type, size_t method_index);
+    void declareTypeMethods(TypeDecl* type);
+    
+    // Helper to order type declarations so parents precede their subtypes
+    std::vector<TypeDecl*> orderTypesByInheritance(Program* prog);
+    
+    // Helper to emit a (direct or indirect) method call with a checked signature
+    llvm::Value* emitMethodCall(llvm::FunctionType* func_type, llvm::Value* callee,
+                                const std::vector<llvm::Value*>& args);
+    bool overridesMatchSignature(const std::string& type_name, const std::string& method,
+                                 llvm::FunctionType* func_type);
+    
+    // Helpers for receivers whose type is only known at run time
+    llvm::Value* receiverPointer(llvm::Value* object);
+    llvm::Value* emitMissingMember(const std::string& message);
+    llvm::Value* emitDynamicFieldLoad(llvm::Value* object, const std::string& member);
+    void emitDynamicFieldStore(llvm::Value* object, const std::string& member, llvm::Value* value);
+    
+    // Profile-guided helpers (no-ops without a profile)
+    void setBranchWeights(llvm::Instruction* terminator, int node_id);
+    void recordProfiledCall(llvm::Function* callee, uint64_t count);
+    void applyProfileInliningHints();
+    // --multiversion: numeric functions with loops (or, with a profile, the hot ones)
+    void multiversionHotFunctions();
+    llvm::Value* emitVirtualCall(MethodCallExpr* expr, llvm::FunctionType* func_type, llvm::Value* object,
+                                 int slot, const std::vector<llvm::Value*>& args);
       // Helper to infer field type from default value
     llvm::Type* inferFieldType(Expr* default_value);
+    llvm::Type* getFieldStorageType(TypeDecl* type, const std::string& field_name, Expr* default_value);
     
     // Helper to determine return type based on method name and content
-    llvm::Type* getMethodReturnType(const std::string& method_name, const ExprPtr& method_body);
+    llvm::Type* getMethodReturnType(const std::string& type_name, const std::string& method_name,
+                                    const ExprPtr& method_body);
     
     // Helper to check if an expression contains string operations
     bool containsStringOperations(Expr* expr);
@@ -70,6 +133,55 @@ public:
     // Method to print the generated LLVM module
     void printModule();
     
+    // Module being generated (the tiered JIT takes ownership through bitcode)
+    llvm::Module& getModule() { return context_.getModule(); }
+    
+    // On-stack replacement entry for a hot interpreted loop (--tiered):
+    // `double name(ptr slots)` runs `loop` with live_variables[i] loaded from
+    // slots[i], stores them back when the loop exits and returns its value
+    llvm::Function* generateLoopFunction(WhileExpr* loop, const std::vector<std::string>& live_variables,
+                                         const std::string& name);
+    
+    // Run the LLVM optimization pipeline (-O0..-O3) over the generated module
+    void optimizeModule(unsigned level) { context_.optimizeModule(level); }
+    
+    // Floating-point semantics for generated code (--fast-math, --fp-contract, --no-nans)
+    void setFastMathOptions(bool fast_math, bool fp_contract, bool no_nans) {
+        context_.setFastMathOptions(fast_math, fp_contract, no_nans);
+    }
+    
+    // Write the module to a file: native object for *.o (compiled on `jobs`
+    // threads), textual IR otherwise
+    void writeOutput(const std::string& filename, unsigned jobs = 1);
+    
+    // DWARF line tables and subprograms for `source_path` (-g)
+    void enableDebugInfo(const std::string& source_path) { context_.enableDebugInfo(source_path); }
+    
+    // Probes at function and method entries (and if branches and while
+    // back-edges with `branches`), dumped by the runtime at exit (--instrument)
+    void setInstrumentation(bool functions, bool branches) { context_.setInstrumentation(functions, branches); }
+    size_t finalizeInstrumentation(const std::string& table_name) {
+        return context_.finalizeInstrumentation(table_name);
+    }
+    
+    // Reuse per-partition objects across runs (empty dir disables the cache)
+    void setObjectCacheDir(const std::string& dir) { context_.setObjectCacheDir(dir); }
+    void printStats(std::ostream& out) const { context_.printStats(out); }
+    
+    // Branch weights, dispatch order and inlining hints from an interpreter profile
+    void setProfile(const ExecutionProfile* profile) { profile_ = profile; }
+    
+    // Target CPU (--march=native|<cpu>); false if the target does not know it
+    bool setTargetCPU(const std::string& cpu) { return context_.setTargetCPU(cpu); }
+    // AVX-512/AVX2/baseline clones of hot numeric functions with load-time dispatch (--multiversion)
+    void setMultiversioning(bool enabled) { multiversion_ = enabled; }
+    
+    // Hold let counters the semantic analyzer proved integral as i64 (--no-int-counters disables)
+    void setIntegerCounters(bool enabled) { integer_counters_ = enabled; }
+    
+    // Trace progress on stderr (--debug); off for the JIT, whose output is the program's
+    void setVerbose(bool enabled) { verbose_ = enabled; }
+    
     // StmtVisitor methods
     void visit(Program* prog) override;
     void visit(ExprStmt* stmt) override;
@@ -104,4 +216,15 @@ public:
 private:
     // Helper methods
     llvm::Type* inferParameterType(const std::string& method_name, const std::string& param_name);
+    // Representation of a semantic type (Unknown = dynamic value)
+    llvm::Type* getValueType(const TypeInfo& type);
+    // Clone of a function for one argument shape: name$Number$Any... (see SemanticAnalyzer::FunctionSpecialization)
+    static std::string specializationName(const std::string& name, const std::vector<llvm::Type*>& param_types);
+    // Lowers the body of `func` into the (already declared) `llvm_func`
+    void generateFunctionBody(FunctionDecl* func, llvm::Function* llvm_func);
+    // `x := ...` for an integer counter slot: i64 add/sub of the step, result pushed as a Number
+    void generateCounterUpdate(AssignExpr* expr, llvm::AllocaInst* slot);
+    // `for (x in range(a, b))` as parsed (let __iter = iter(range(a, b)) in while ...):
+    // emits a counted loop and returns true, false if `expr` is not that shape
+    bool generateRangeLoop(LetExpr* expr);
 };
\ No newline at end of file
@@ -0,0 +1,212 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Interns identifiers into dense 32-bit symbols
+ *
+ * Names are hashed once (FNV-1a) into an open-addressing table with linear
+ * probing; every other code generation table is then keyed by the symbol.
+ */
+class SymbolInterner {
+public:
+    using Symbol = uint32_t;
+    static constexpr Symbol kNoSymbol = UINT32_MAX;
+
+    Symbol intern(std::string_view name) {
+        if ((names_.size() + 1) * 4 > slots_.size() * 3) {
+            grow();
+        }
+        uint64_t hash = hashName(name);
+        size_t slot = probe(name, hash);
+        if (slots_[slot] == 0) {
+            names_.emplace_back(name);
+            hashes_.push_back(hash);
+            slots_[slot] = static_cast<uint32_t>(names_.size()); // symbol + 1, 0 = empty
+        }
+        return slots_[slot] - 1;
+    }
+
+    // kNoSymbol if `name` was never interned (so it cannot be bound anywhere)
+    Symbol find(std::string_view name) const {
+        if (slots_.empty()) return kNoSymbol;
+        size_t slot = probe(name, hashName(name));
+        return slots_[slot] == 0 ? kNoSymbol : slots_[slot] - 1;
+    }
+
+    const std::string& name(Symbol symbol) const { return names_[symbol]; }
+    size_t size() const { return names_.size(); }
+
+private:
+    static uint64_t hashName(std::string_view name) {
+        uint64_t hash = 1469598103934665603ull;
+        for (unsigned char c : name) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    size_t probe(std::string_view name, uint64_t hash) const {
+        size_t mask = slots_.size() - 1;
+        for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+            uint32_t entry = slots_[slot];
+            if (entry == 0 || (hashes_[entry - 1] == hash && names_[entry - 1] == name)) {
+                return slot;
+            }
+        }
+    }
+
+    void grow() {
+        std::vector<uint32_t> old_slots = std::move(slots_);
+        slots_.assign(old_slots.empty() ? 64 : old_slots.size() * 2, 0);
+        size_t mask = slots_.size() - 1;
+        for (uint32_t entry : old_slots) {
+            if (entry == 0) continue;
+            size_t slot = hashes_[entry - 1] & mask;
+            while (slots_[slot] != 0) slot = (slot + 1) & mask;
+            slots_[slot] = entry;
+        }
+    }
+
+    std::vector<uint32_t> slots_; // power-of-two capacity, kept at most 3/4 full
+    std::vector<std::string> names_;
+    std::vector<uint64_t> hashes_;
+};
+
+/**
+ * @brief Open-addressing map from interned symbols to values
+ */
+template <typename T>
+class SymbolMap {
+public:
+    using Symbol = SymbolInterner::Symbol;
+
+    T& operator[](Symbol symbol) {
+        if ((size_ + 1) * 4 > slots_.size() * 3) {
+            grow();
+        }
+        Slot& slot = slots_[probe(symbol)];
+        if (slot.key == SymbolInterner::kNoSymbol) {
+            slot.key = symbol;
+            slot.value = T();
+            ++size_;
+        }
+        return slot.value;
+    }
+
+    T* find(Symbol symbol) {
+        if (slots_.empty() || symbol == SymbolInterner::kNoSymbol) return nullptr;
+        Slot& slot = slots_[probe(symbol)];
+        return slot.key == symbol ? &slot.value : nullptr;
+    }
+
+    const T* find(Symbol symbol) const { return const_cast<SymbolMap*>(this)->find(symbol); }
+
+    size_t size() const { return size_; }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const Slot& slot : slots_) {
+            if (slot.key != SymbolInterner::kNoSymbol) fn(slot.key, slot.value);
+        }
+    }
+
+private:
+    struct Slot {
+        Symbol key = SymbolInterner::kNoSymbol;
+        T value{};
+    };
+
+    size_t probe(Symbol symbol) const {
+        size_t mask = slots_.size() - 1;
+        // Symbols are dense, so spread them with a multiplicative hash
+        for (size_t slot = (symbol * 0x9E3779B1u) & mask;; slot = (slot + 1) & mask) {
+            if (slots_[slot].key == symbol || slots_[slot].key == SymbolInterner::kNoSymbol) {
+                return slot;
+            }
+        }
+    }
+
+    void grow() {
+        std::vector<Slot> old_slots = std::move(slots_);
+        slots_.assign(old_slots.empty() ? 16 : old_slots.size() * 2, Slot());
+        for (Slot& slot : old_slots) {
+            if (slot.key != SymbolInterner::kNoSymbol) {
+                slots_[probe(slot.key)] = std::move(slot);
+            }
+        }
+    }
+
+    std::vector<Slot> slots_; // power-of-two capacity, kept at most 3/4 full
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Block-scoped symbol table
+ *
+ * Bindings are appended to a log; each symbol's visible binding is the head
+ * of a chain through the bindings it shadows. pushScope() only records the log
+ * size, and popScope() unwinds the bindings made since, so neither copies
+ * anything and lookups are a single probe regardless of nesting depth.
+ */
+template <typename T>
+class ScopedSymbolTable {
+public:
+    using Symbol = SymbolInterner::Symbol;
+
+    explicit ScopedSymbolTable(SymbolInterner& interner) : interner_(interner) {}
+
+    void pushScope() { scope_marks_.push_back(static_cast<uint32_t>(bindings_.size())); }
+
+    void popScope() {
+        if (scope_marks_.empty()) return;
+        uint32_t mark = scope_marks_.back();
+        scope_marks_.pop_back();
+        while (bindings_.size() > mark) {
+            const Binding& binding = bindings_.back();
+            heads_[binding.symbol] = binding.shadowed;
+            bindings_.pop_back();
+        }
+    }
+
+    size_t depth() const { return scope_marks_.size(); }
+
+    // Binds `name` in the innermost scope (a no-op outside every scope)
+    void declare(std::string_view name, T value) {
+        if (scope_marks_.empty()) return;
+        Symbol symbol = interner_.intern(name);
+        if (heads_.size() <= symbol) heads_.resize(interner_.size(), 0);
+        uint32_t head = heads_[symbol];
+        if (head != 0 && head > scope_marks_.back()) {
+            bindings_[head - 1].value = std::move(value); // redeclared in the same scope
+            return;
+        }
+        bindings_.push_back(Binding{symbol, std::move(value), head});
+        heads_[symbol] = static_cast<uint32_t>(bindings_.size());
+    }
+
+    // Innermost visible binding of `name`, or null
+    T* lookup(std::string_view name) {
+        Symbol symbol = interner_.find(name);
+        if (symbol == SymbolInterner::kNoSymbol || symbol >= heads_.size() || heads_[symbol] == 0) {
+            return nullptr;
+        }
+        return &bindings_[heads_[symbol] - 1].value;
+    }
+
+private:
+    struct Binding {
+        Symbol symbol;
+        T value;
+        uint32_t shadowed; // previous head for this symbol (index + 1, 0 = none)
+    };
+
+    SymbolInterner& interner_;
+    std::vector<Binding> bindings_;
+    std::vector<uint32_t> scope_marks_; // bindings_.size() when each scope was pushed
+    std::vector<uint32_t> heads_;       // per symbol: visible binding (index + 1, 0 = none)
+};
@@ -0,0 +1,580 @@
+#include "TieredCompiler.hpp"
+#include "LLVMCodeGenerator.hpp"
+#include "../Runtime/hulk_runtime.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/ExecutionEngine/JITEventListener.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <set>
+
+namespace {
+
+// Static type of an expression inside a tier-eligible function
+enum class NumericKind { Number, Boolean, Invalid };
+
+using NumericScopes = std::vector<std::unordered_map<std::string, NumericKind>>;
+
+// Walks one function body (or loop) and decides whether it only computes with
+// numbers and booleans, so the code generator's double(double...) lowering is
+// exact. Calls to other user functions are reported through `on_call`; names
+// bound outside the checked code are typed by `resolve_free`, if given.
+class NumericBodyChecker {
+public:
+    NumericBodyChecker(const std::unordered_map<std::string, FunctionDecl*>& functions,
+                       std::function<void(FunctionDecl*)> on_call,
+                       std::function<NumericKind(const std::string&)> resolve_free = nullptr)
+        : functions_(functions), on_call_(std::move(on_call)), resolve_free_(std::move(resolve_free)) {}
+
+    bool checkFunction(FunctionDecl* func, std::string& reason) {
+        NumericScopes scopes(1);
+        for (const auto& param : func->params) {
+            scopes.back()[param] = NumericKind::Number;
+        }
+        if (kindOf(func->body.get(), scopes) != NumericKind::Number) {
+            reason = func->name + ": " + (reason_.empty() ? "result is not a number" : reason_);
+            return false;
+        }
+        return true;
+    }
+
+    bool checkLoop(WhileExpr* loop, std::string& reason) {
+        NumericScopes scopes(1);
+        if (kindOf(loop, scopes) != NumericKind::Number) {
+            reason = reason_.empty() ? "loop value is not a number" : reason_;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    NumericKind reject(const std::string& why) {
+        if (reason_.empty()) reason_ = why;
+        return NumericKind::Invalid;
+    }
+
+    NumericKind lookup(const NumericScopes& scopes, const std::string& name) {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) return found->second;
+        }
+        return resolve_free_ ? resolve_free_(name) : NumericKind::Invalid;
+    }
+
+    NumericKind kindOf(Stmt* stmt, NumericScopes& scopes) {
+        if (auto* expr_stmt = dynamic_cast<ExprStmt*>(stmt)) {
+            return kindOf(expr_stmt->expr.get(), scopes);
+        }
+        // Block-bodied functions keep their statements in a nested Program
+        if (auto* block = dynamic_cast<Program*>(stmt)) {
+            return kindOfSequence(block->stmts, scopes);
+        }
+        return reject("unsupported statement");
+    }
+
+    // Statements of a block, in a new scope; the value is the last one's
+    NumericKind kindOfSequence(const std::vector<StmtPtr>& stmts, NumericScopes& scopes) {
+        if (stmts.empty()) return reject("empty block");
+        scopes.emplace_back();
+        NumericKind kind = NumericKind::Invalid;
+        for (const auto& stmt : stmts) {
+            kind = kindOf(stmt.get(), scopes);
+            if (kind == NumericKind::Invalid) break;
+        }
+        scopes.pop_back();
+        return kind;
+    }
+
+    NumericKind kindOf(Expr* expr, NumericScopes& scopes) {
+        if (!expr) return reject("missing expression");
+
+        if (dynamic_cast<NumberExpr*>(expr)) return NumericKind::Number;
+        if (dynamic_cast<BooleanExpr*>(expr)) return NumericKind::Boolean;
+
+        if (auto* var = dynamic_cast<VariableExpr*>(expr)) {
+            NumericKind kind = lookup(scopes, var->name);
+            return kind == NumericKind::Invalid ? reject("unknown variable " + var->name) : kind;
+        }
+
+        if (auto* unary = dynamic_cast<UnaryExpr*>(expr)) {
+            NumericKind operand = kindOf(unary->operand.get(), scopes);
+            if (unary->op == UnaryExpr::OP_NEG && operand == NumericKind::Number) return NumericKind::Number;
+            if (unary->op == UnaryExpr::OP_NOT && operand == NumericKind::Boolean) return NumericKind::Boolean;
+            return reject("unsupported unary operand");
+        }
+
+        if (auto* binary = dynamic_cast<BinaryExpr*>(expr)) {
+            NumericKind left = kindOf(binary->left.get(), scopes);
+            NumericKind right = kindOf(binary->right.get(), scopes);
+            switch (binary->op) {
+                case BinaryExpr::OP_ADD: case BinaryExpr::OP_SUB: case BinaryExpr::OP_MUL:
+                case BinaryExpr::OP_DIV: case BinaryExpr::OP_MOD: case BinaryExpr::OP_POW:
+                    if (left == NumericKind::Number && right == NumericKind::Number) return NumericKind::Number;
+                    break;
+                case BinaryExpr::OP_LT: case BinaryExpr::OP_GT: case BinaryExpr::OP_LE:
+                case BinaryExpr::OP_GE: case BinaryExpr::OP_EQ: case BinaryExpr::OP_NEQ:
+                    if (left == NumericKind::Number && right == NumericKind::Number) return NumericKind::Boolean;
+                    break;
+                case BinaryExpr::OP_AND: case BinaryExpr::OP_OR:
+                    if (left == NumericKind::Boolean && right == NumericKind::Boolean) return NumericKind::Boolean;
+                    break;
+                default:
+                    break;
+            }
+            return reject("unsupported binary operation");
+        }
+
+        if (auto* call = dynamic_cast<CallExpr*>(expr)) {
+            for (const auto& arg : call->args) {
+                if (kindOf(arg.get(), scopes) != NumericKind::Number) return reject("non-numeric argument");
+            }
+            static const std::set<std::string> unary_math = {"sin", "cos", "sqrt", "exp", "log"};
+            if (unary_math.count(call->callee) && call->args.size() == 1) return NumericKind::Number;
+            if (call->callee == "pow" && call->args.size() == 2) return NumericKind::Number;
+
+            auto it = functions_.find(call->callee);
+            if (it == functions_.end() || it->second->params.size() != call->args.size()) {
+                return reject("calls " + call->callee);
+            }
+            on_call_(it->second);
+            return NumericKind::Number;
+        }
+
+        if (auto* let = dynamic_cast<LetExpr*>(expr)) {
+            NumericKind init = kindOf(let->initializer.get(), scopes);
+            if (init == NumericKind::Invalid) return NumericKind::Invalid;
+            scopes.emplace_back();
+            scopes.back()[let->name] = init;
+            NumericKind body = kindOf(let->body.get(), scopes);
+            scopes.pop_back();
+            return body;
+        }
+
+        if (auto* assign = dynamic_cast<AssignExpr*>(expr)) {
+            NumericKind target = lookup(scopes, assign->name);
+            if (target == NumericKind::Invalid || kindOf(assign->value.get(), scopes) != target) {
+                return reject("assignment to " + assign->name + " changes its type");
+            }
+            return target;
+        }
+
+        if (auto* if_expr = dynamic_cast<IfExpr*>(expr)) {
+            if (kindOf(if_expr->condition.get(), scopes) != NumericKind::Boolean) return reject("non-boolean condition");
+            NumericKind then_kind = kindOf(if_expr->thenBranch.get(), scopes);
+            NumericKind else_kind = kindOf(if_expr->elseBranch.get(), scopes);
+            return then_kind == else_kind ? then_kind : reject("if branches differ in type");
+        }
+
+        if (auto* block = dynamic_cast<ExprBlock*>(expr)) {
+            return kindOfSequence(block->stmts, scopes);
+        }
+
+        // A loop that never runs is 0 in both tiers, so only numeric bodies qualify
+        if (auto* loop = dynamic_cast<WhileExpr*>(expr)) {
+            if (kindOf(loop->condition.get(), scopes) != NumericKind::Boolean) return reject("non-boolean condition");
+            return kindOf(loop->body.get(), scopes) == NumericKind::Number ? NumericKind::Number
+                                                                          : reject("non-numeric loop body");
+        }
+
+        return reject("uses strings or objects");
+    }
+
+    const std::unordered_map<std::string, FunctionDecl*>& functions_;
+    std::function<void(FunctionDecl*)> on_call_;
+    std::function<NumericKind(const std::string&)> resolve_free_;
+    std::string reason_;
+};
+
+} // namespace
+
+TieredCompiler::TieredCompiler(const std::unordered_map<std::string, FunctionDecl*>& functions,
+                               uint64_t threshold, unsigned opt_level, std::string debug_source,
+                               std::string target_cpu)
+    : functions_(functions), threshold_(std::max<uint64_t>(threshold, 1)), opt_level_(opt_level),
+      debug_source_(std::move(debug_source)), target_cpu_(std::move(target_cpu)) {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    llvm::orc::LLJITBuilder builder;
+    if (target_cpu_ != "native") {
+        // A named CPU replaces the host's, along with every feature detected on it
+        auto machine_builder = llvm::orc::JITTargetMachineBuilder::detectHost();
+        if (!machine_builder) {
+            std::cerr << "Warning: tiered execution disabled, JIT unavailable: "
+                      << llvm::toString(machine_builder.takeError()) << std::endl;
+            return;
+        }
+        auto host_machine = machine_builder->createTargetMachine();
+        if (!host_machine || !(*host_machine)->getMCSubtargetInfo()->isCPUStringValid(target_cpu_)) {
+            if (!host_machine) llvm::consumeError(host_machine.takeError());
+            std::cerr << "Warning: tiered execution disabled, unknown CPU '" << target_cpu_ << "'" << std::endl;
+            return;
+        }
+        machine_builder->setCPU(target_cpu_);
+        machine_builder->getFeatures() = llvm::SubtargetFeatures();
+        builder.setJITTargetMachineBuilder(std::move(*machine_builder));
+    }
+    if (!debug_source_.empty()) {
+        // RuntimeDyld notifies JIT event listeners of every object it loads:
+        // gdb reads the DWARF through __jit_debug_register_code, and perf picks
+        // up symbols and lines from the jit-<pid>.dump written by its listener
+        builder.setObjectLinkingLayerCreator([](llvm::orc::ExecutionSession& session, const llvm::Triple&) {
+            auto layer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(
+                session,
+#if LLVM_VERSION_MAJOR >= 18
+                [](const llvm::MemoryBuffer&) { return std::make_unique<llvm::SectionMemoryManager>(); });
+#else
+                []() { return std::make_unique<llvm::SectionMemoryManager>(); });
+#endif
+            layer->registerJITEventListener(*llvm::JITEventListener::createGDBRegistrationListener());
+            if (llvm::JITEventListener* perf = llvm::JITEventListener::createPerfJITEventListener()) {
+                layer->registerJITEventListener(*perf);
+            }
+            return llvm::Expected<std::unique_ptr<llvm::orc::ObjectLayer>>(std::move(layer));
+        });
+    }
+    auto jit = builder.create();
+    if (!jit) {
+        std::cerr << "Warning: tiered execution disabled, JIT unavailable: "
+                  << llvm::toString(jit.takeError()) << std::endl;
+        return;
+    }
+    jit_ = std::move(*jit);
+
+    // libm (sin, pow, fmod, ...) and the rest of the process resolve normally
+    auto process_symbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        jit_->getDataLayout().getGlobalPrefix());
+    if (process_symbols) {
+        jit_->getMainJITDylib().addGenerator(std::move(*process_symbols));
+    } else {
+        llvm::consumeError(process_symbols.takeError());
+    }
+}
+
+TieredCompiler::~TieredCompiler() {
+    // Background compiles hold `this`; let them finish before the JIT goes away
+    for (auto& [func, entry] : function_entries_) {
+        if (entry.pending.valid()) entry.pending.wait();
+    }
+    for (auto& [loop, entry] : loop_entries_) {
+        if (entry.pending.valid()) entry.pending.wait();
+    }
+    // Probes live in JIT memory, so report them while it is still mapped
+    if (instrument_functions_ || instrument_branches_) {
+        hulk_instrument_flush();
+    }
+}
+
+bool TieredCompiler::collectNumericClosure(const std::vector<FunctionDecl*>& roots,
+                                           std::vector<FunctionDecl*>& ordered, std::string& reason) const {
+    std::set<FunctionDecl*> visited;
+    bool ok = true;
+
+    std::function<void(FunctionDecl*)> visit = [&](FunctionDecl* func) {
+        if (!ok || !visited.insert(func).second) return;
+        if (func->params.size() > kMaxNativeParams) {
+            reason = func->name + ": too many parameters";
+            ok = false;
+            return;
+        }
+        // IfExpr code generation skips ifs in functions named like methods (see visit(IfExpr))
+        if (func->name.find("_f") != std::string::npos || func->name.find("_init") != std::string::npos) {
+            reason = func->name + ": name is reserved for methods";
+            ok = false;
+            return;
+        }
+        std::vector<FunctionDecl*> callees;
+        NumericBodyChecker checker(functions_, [&](FunctionDecl* callee) { callees.push_back(callee); });
+        if (!checker.checkFunction(func, reason)) {
+            ok = false;
+            return;
+        }
+        for (FunctionDecl* callee : callees) visit(callee);
+        ordered.push_back(func);
+    };
+    for (FunctionDecl* root : roots) visit(root);
+    return ok;
+}
+
+void TieredCompiler::requestCompile(FunctionDecl* f) {
+    Entry& entry = function_entries_[f];
+    std::vector<FunctionDecl*> closure;
+    if (!jit_) {
+        entry.state = State::Failed;
+        entry.reason = "JIT unavailable";
+        return;
+    }
+    if (!collectNumericClosure({f}, closure, entry.reason)) {
+        entry.state = State::Failed;
+        return;
+    }
+    // Callees come first, so the root is the last function generated
+    entry.pending = std::async(std::launch::async, &TieredCompiler::compile, this,
+                               "hulk_tier$" + f->name, std::move(closure), nullptr, std::vector<std::string>());
+}
+
+void TieredCompiler::requestLoopCompile(WhileExpr* loop, const EnvFrame& env) {
+    Entry& entry = loop_entries_[loop];
+    if (!jit_) {
+        entry.state = State::Failed;
+        entry.reason = "JIT unavailable";
+        return;
+    }
+
+    // Free variables of the loop must currently hold numbers; they become its live state
+    std::vector<FunctionDecl*> callees;
+    NumericBodyChecker checker(
+        functions_, [&](FunctionDecl* callee) { callees.push_back(callee); },
+        [&](const std::string& name) {
+            if (!env.existsInChain(name) || !env.get(name).isNumber()) return NumericKind::Invalid;
+            if (std::find(entry.live_variables.begin(), entry.live_variables.end(), name) == entry.live_variables.end()) {
+                entry.live_variables.push_back(name);
+            }
+            return NumericKind::Number;
+        });
+    std::vector<FunctionDecl*> closure;
+    if (!checker.checkLoop(loop, entry.reason) || !collectNumericClosure(callees, closure, entry.reason)) {
+        entry.state = State::Failed;
+        return;
+    }
+    entry.pending = std::async(std::launch::async, &TieredCompiler::compile, this,
+                               "hulk_osr$" + std::to_string(loop->node_id), std::move(closure), loop,
+                               entry.live_variables);
+}
+
+TieredCompiler::CompileResult TieredCompiler::compile(std::string symbol, std::vector<FunctionDecl*> closure,
+                                                      WhileExpr* loop, std::vector<std::string> live_variables) {
+    CompileResult result;
+    try {
+        LLVMCodeGenerator codegen(symbol);
+        // Optimize for the CPU the JIT emits code for
+        if (!codegen.setTargetCPU(target_cpu_)) {
+            result.error = "unknown target CPU";
+            return result;
+        }
+        if (!debug_source_.empty()) {
+            codegen.enableDebugInfo(debug_source_);
+        }
+        codegen.setInstrumentation(instrument_functions_, instrument_branches_);
+        codegen.setObjectCacheDir(cache_dir_);
+        for (FunctionDecl* func : closure) {
+            func->accept(&codegen);
+        }
+        llvm::Function* entry_point = loop ? codegen.generateLoopFunction(loop, live_variables, symbol)
+                                           : codegen.getModule().getFunction(closure.back()->name);
+        if (!entry_point) {
+            result.error = "entry point was not generated";
+            return result;
+        }
+        entry_point->setName(symbol);
+        std::string probe_table = "hulk_probes$" + symbol;
+        size_t probe_count = codegen.finalizeInstrumentation(probe_table);
+
+        // Each hot function or loop gets its own module with private copies of
+        // its callees, so only the entry point is exported to the JIT
+        llvm::Module& module = codegen.getModule();
+        for (llvm::Function& func : module) {
+            if (!func.isDeclaration() && &func != entry_point) {
+                func.setLinkage(llvm::GlobalValue::InternalLinkage);
+            }
+        }
+        for (llvm::GlobalVariable& global : module.globals()) {
+            if (!global.isDeclaration() && global.getName() != probe_table) {
+                global.setLinkage(llvm::GlobalValue::InternalLinkage);
+            }
+        }
+        try {
+            codegen.optimizeModule(opt_level_);
+        } catch (const std::exception& error) {
+            result.error = error.what();
+            return result;
+        }
+
+        // Move the module into a context owned by the JIT (a cache hit replaces it)
+        llvm::SmallVector<char, 0> bitcode;
+        llvm::raw_svector_ostream bitcode_stream(bitcode);
+        llvm::WriteBitcodeToFile(codegen.getModule(), bitcode_stream);
+
+        auto context = std::make_unique<llvm::LLVMContext>();
+#if LLVM_VERSION_MAJOR < 15
+        context->enableOpaquePointers();
+#endif
+        auto parsed = llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()), symbol), *context);
+        if (!parsed) {
+            result.error = llvm::toString(parsed.takeError());
+            return result;
+        }
+
+        std::lock_guard<std::mutex> lock(jit_mutex_);
+        (*parsed)->setDataLayout(jit_->getDataLayout());
+        (*parsed)->setTargetTriple(jit_->getTargetTriple().str());
+        if (auto err = jit_->addIRModule(llvm::orc::ThreadSafeModule(std::move(*parsed), std::move(context)))) {
+            result.error = llvm::toString(std::move(err));
+            return result;
+        }
+        auto address = jit_->lookup(symbol);
+        if (!address) {
+            result.error = llvm::toString(address.takeError());
+            return result;
+        }
+#if LLVM_VERSION_MAJOR >= 15
+        result.address = address->getValue();
+#else
+        result.address = address->getAddress();
+#endif
+        if (probe_count > 0) {
+            // The JIT'd code has no main to register its probes from
+            auto table = jit_->lookup(probe_table);
+            if (!table) {
+                result.error = llvm::toString(table.takeError());
+                result.address = 0;
+                return result;
+            }
+#if LLVM_VERSION_MAJOR >= 15
+            hulk_instrument_register(table->toPtr<HulkProbe* const*>(), static_cast<int64_t>(probe_count));
+#else
+            hulk_instrument_register(reinterpret_cast<HulkProbe* const*>(table->getAddress()),
+                                     static_cast<int64_t>(probe_count));
+#endif
+        }
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+bool TieredCompiler::poll(Entry& entry) {
+    if (entry.state == State::Compiling) {
+        if (!entry.pending.valid() ||
+            entry.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+        CompileResult compiled = entry.pending.get();
+        entry.address = compiled.address;
+        entry.state = compiled.address ? State::Ready : State::Failed;
+        entry.reason = compiled.error;
+    }
+    return entry.state == State::Ready;
+}
+
+bool TieredCompiler::tryCall(FunctionDecl* f, const std::vector<Value>& args, Value& result) {
+    auto it = function_entries_.find(f);
+    if (it == function_entries_.end() || !poll(it->second)) return false;
+    Entry& entry = it->second;
+
+    // Guards: the native entry point only understands numbers
+    double in[kMaxNativeParams];
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (!args[i].isNumber()) {
+            ++guard_failures_;
+            return false;
+        }
+        in[i] = args[i].asNumber();
+    }
+
+    using F0 = double (*)();
+    using F1 = double (*)(double);
+    using F2 = double (*)(double, double);
+    using F3 = double (*)(double, double, double);
+    using F4 = double (*)(double, double, double, double);
+    using F5 = double (*)(double, double, double, double, double);
+    using F6 = double (*)(double, double, double, double, double, double);
+
+    double out = 0.0;
+    switch (args.size()) {
+        case 0: out = reinterpret_cast<F0>(entry.address)(); break;
+        case 1: out = reinterpret_cast<F1>(entry.address)(in[0]); break;
+        case 2: out = reinterpret_cast<F2>(entry.address)(in[0], in[1]); break;
+        case 3: out = reinterpret_cast<F3>(entry.address)(in[0], in[1], in[2]); break;
+        case 4: out = reinterpret_cast<F4>(entry.address)(in[0], in[1], in[2], in[3]); break;
+        case 5: out = reinterpret_cast<F5>(entry.address)(in[0], in[1], in[2], in[3], in[4]); break;
+        case 6: out = reinterpret_cast<F6>(entry.address)(in[0], in[1], in[2], in[3], in[4], in[5]); break;
+        default: return false;
+    }
+    result = Value(out);
+    ++native_calls_;
+    return true;
+}
+
+bool TieredCompiler::tryEnterLoop(WhileExpr* loop, EnvFrame& env, Value& result) {
+    auto it = loop_entries_.find(loop);
+    if (it == loop_entries_.end() || !poll(it->second)) return false;
+    Entry& entry = it->second;
+
+    // Guards: the live variables must still be numbers
+    std::vector<double> slots;
+    slots.reserve(entry.live_variables.size());
+    for (const auto& name : entry.live_variables) {
+        Value value = env.get(name);
+        if (!value.isNumber()) {
+            ++guard_failures_;
+            return false;
+        }
+        slots.push_back(value.asNumber());
+    }
+
+    // The native loop re-evaluates the (side-effect free) condition and runs to the exit
+    using LoopEntry = double (*)(double*);
+    result = Value(reinterpret_cast<LoopEntry>(entry.address)(slots.data()));
+    for (size_t i = 0; i < slots.size(); ++i) {
+        env.set(entry.live_variables[i], Value(slots[i]));
+    }
+    ++native_loops_;
+    return true;
+}
+
+void TieredCompiler::printStats(std::ostream& out,
+                                const std::unordered_map<FunctionDecl*, uint64_t>& function_calls,
+                                const std::unordered_map<std::string, uint64_t>& method_calls,
+                                const std::unordered_map<WhileExpr*, uint64_t>& loop_iterations) const {
+    auto describe = [](const Entry* entry) -> std::string {
+        if (!entry) return "interpreted";
+        switch (entry->state) {
+            case State::Ready: return "native";
+            case State::Compiling: return "compiling";
+            default: return "interpreted (" + entry->reason + ")";
+        }
+    };
+    auto by_count = [](const auto& a, const auto& b) { return a.second > b.second; };
+
+    out << "=== Tiered execution statistics ===" << std::endl;
+    out << "JIT threshold: " << threshold_ << " calls / loop iterations" << std::endl;
+
+    std::vector<std::pair<FunctionDecl*, uint64_t>> functions(function_calls.begin(), function_calls.end());
+    std::sort(functions.begin(), functions.end(), by_count);
+    for (const auto& [func, calls] : functions) {
+        auto it = function_entries_.find(func);
+        out << "  " << func->name << ": " << calls << " calls, "
+            << describe(it == function_entries_.end() ? nullptr : &it->second) << std::endl;
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> methods(method_calls.begin(), method_calls.end());
+    std::sort(methods.begin(), methods.end(), by_count);
+    for (const auto& [method, calls] : methods) {
+        out << "  " << method << ": " << calls << " calls, interpreted (methods are not compiled)" << std::endl;
+    }
+
+    std::vector<std::pair<WhileExpr*, uint64_t>> loops(loop_iterations.begin(), loop_iterations.end());
+    std::sort(loops.begin(), loops.end(), by_count);
+    for (const auto& [loop, iterations] : loops) {
+        auto it = loop_entries_.find(loop);
+        out << "  while #" << loop->node_id << ": " << iterations << " interpreted iterations, "
+            << describe(it == loop_entries_.end() ? nullptr : &it->second) << std::endl;
+    }
+
+    out << "Native calls: " << native_calls_ << ", native loop entries: " << native_loops_
+        << ", guard failures: " << guard_failures_ << std::endl;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "../AST/ast.hpp"
+#include "../Evaluator/native_tier.hpp"
+#include <future>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace llvm {
+namespace orc {
+class LLJIT;
+}
+}
+
+/**
+ * @brief Native tier of the interpreter (--tiered)
+ *
+ * Hot functions are compiled on a background thread with the LLVM back end
+ * and loaded into an ORC JIT. Only functions whose parameters, locals and
+ * result are all numbers are eligible: their native entry point has the
+ * signature double(double, ...), so marshalling is a Value <-> double
+ * conversion guarded by an isNumber() check on every argument. Anything
+ * else (ineligible bodies, failed compiles, failed guards) stays interpreted.
+ *
+ * Hot while loops are replaced on the stack: the loop is compiled into
+ * double(double* slots), where the slots carry the loop's free variables in
+ * from the interpreter's environment and back out when it exits.
+ */
+class TieredCompiler : public NativeTier {
+public:
+    // `functions` is the interpreter's function table, read when a function becomes hot.
+    // With a `debug_source` (-g) the native code carries line info for that file
+    // and is registered with gdb and perf through their JIT interfaces.
+    // `target_cpu` (--march) overrides the host CPU the JIT generates code for.
+    TieredCompiler(const std::unordered_map<std::string, FunctionDecl*>& functions,
+                   uint64_t threshold, unsigned opt_level = 2, std::string debug_source = "",
+                   std::string target_cpu = "native");
+    ~TieredCompiler() override;
+
+    // Probes in the native code (--instrument), reported by the runtime at exit
+    void setInstrumentation(bool functions, bool branches) {
+        instrument_functions_ = functions;
+        instrument_branches_ = branches;
+    }
+
+    // Optimized modules are reused from this directory across runs (--cache-dir)
+    void setObjectCacheDir(std::string dir) { cache_dir_ = std::move(dir); }
+
+    uint64_t threshold() const override { return threshold_; }
+    void requestCompile(FunctionDecl* f) override;
+    bool tryCall(FunctionDecl* f, const std::vector<Value>& args, Value& result) override;
+    void requestLoopCompile(WhileExpr* loop, const EnvFrame& env) override;
+    bool tryEnterLoop(WhileExpr* loop, EnvFrame& env, Value& result) override;
+
+    // Call and iteration counts with the tier each function or loop ended up in
+    void printStats(std::ostream& out,
+                    const std::unordered_map<FunctionDecl*, uint64_t>& function_calls,
+                    const std::unordered_map<std::string, uint64_t>& method_calls,
+                    const std::unordered_map<WhileExpr*, uint64_t>& loop_iterations) const;
+
+    static constexpr size_t kMaxNativeParams = 6;
+
+private:
+    enum class State { Compiling, Ready, Failed };
+
+    struct CompileResult {
+        uint64_t address = 0; // native entry point, 0 on failure
+        std::string error;
+    };
+
+    struct Entry {
+        State state = State::Compiling;
+        std::future<CompileResult> pending;
+        uint64_t address = 0;
+        std::string reason;                      // why the function or loop stays interpreted
+        std::vector<std::string> live_variables; // loops: interpreter variables passed in slots
+    };
+
+    // Appends `roots` and every user function they call to `ordered`, callees
+    // first; false (with `reason` set) if any cannot be compiled to double(double...)
+    bool collectNumericClosure(const std::vector<FunctionDecl*>& roots, std::vector<FunctionDecl*>& ordered,
+                               std::string& reason) const;
+    // Generates `closure` (plus the OSR function for `loop`, if any) on a
+    // background thread and returns the JIT address of `symbol`
+    CompileResult compile(std::string symbol, std::vector<FunctionDecl*> closure,
+                          WhileExpr* loop, std::vector<std::string> live_variables);
+    // Collects a finished background compile; true once the entry is native
+    bool poll(Entry& entry);
+
+    const std::unordered_map<std::string, FunctionDecl*>& functions_;
+    uint64_t threshold_;
+    unsigned opt_level_;
+    std::string debug_source_;
+    std::string target_cpu_;
+    std::string cache_dir_;
+    bool instrument_functions_ = false;
+    bool instrument_branches_ = false;
+
+    std::unique_ptr<llvm::orc::LLJIT> jit_;
+    std::mutex jit_mutex_;
+    std::unordered_map<FunctionDecl*, Entry> function_entries_;
+    std::unordered_map<WhileExpr*, Entry> loop_entries_;
+
+    uint64_t native_calls_ = 0;
+    uint64_t native_loops_ = 0;
+    uint64_t guard_failures_ = 0;
+};
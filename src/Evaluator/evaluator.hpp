@@ -24,6 +24,8 @@
 #include "../Value/value.hpp"
 #include "../Value/hulk_object.hpp"
 #include "env_frame.hpp"
+#include "../Profile/execution_profile.hpp"
+#include "native_tier.hpp"
 
 struct EvaluatorVisitor : StmtVisitor, ExprVisitor
 {
@@ -36,6 +38,15 @@ struct EvaluatorVisitor : StmtVisitor, ExprVisitor
     std::unordered_map<std::string, TypeDecl *> types;
     // Para manejar referencias self durante la ejecución de métodos
     std::shared_ptr<HulkObject> currentSelf;
+    // Si no es nulo, se registran ramas, llamadas y tipos de receptores (--profile-out)
+    ExecutionProfile *profile = nullptr;
+    // Ejecución escalonada (--tiered): invocaciones por función y por método
+    // ("Tipo.metodo"), vueltas por while, y el nivel nativo al que se delegan
+    // las funciones y bucles calientes
+    NativeTier *nativeTier = nullptr;
+    std::unordered_map<FunctionDecl *, uint64_t> functionCalls;
+    std::unordered_map<std::string, uint64_t> methodCalls;
+    std::unordered_map<WhileExpr *, uint64_t> loopIterations;
 
     EvaluatorVisitor()
     {
@@ -287,6 +298,8 @@ struct EvaluatorVisitor : StmtVisitor, ExprVisitor
         if (it != functions.end())
         {
             FunctionDecl *f = it->second;
+            if (profile)
+                profile->recordCall(e->node_id);
 
             if (f->params.size() != args.size())
             {
@@ -294,6 +307,15 @@ struct EvaluatorVisitor : StmtVisitor, ExprVisitor
                                          f->name);
             }
 
+            if (nativeTier)
+            {
+                uint64_t calls = ++functionCalls[f];
+                if (calls == nativeTier->threshold())
+                    nativeTier->requestCompile(f);
+                else if (calls > nativeTier->threshold() && nativeTier->tryCall(f, args, lastValue))
+                    return;
+            }
+
             // Guardar entorno actual
             auto oldEnv = env;
             env = std::make_shared<EnvFrame>(oldEnv);
@@ -583,6 +605,8 @@ struct EvaluatorVisitor : StmtVisitor, ExprVisitor
         {
             throw std::runtime_error("La condición de un if debe ser booleana");
         }
+        if (profile)
+            profile->recordBranch(e->node_id, lastValue.asBool());
 
         if (lastValue.asBool())
         {
@@ -622,9 +646,20 @@ struct EvaluatorVisitor : StmtVisitor, ExprVisitor
             expr->condition->accept(this);
             if (!lastValue.isBool())
                 throw std::runtime_error("La condición de un while debe ser booleana");
+            if (profile)
+                profile->recordBranch(expr->node_id, lastValue.asBool());
             if (!lastValue.asBool())
                 break;
 
+            if (nativeTier)
+            {
+                uint64_t iterations = ++loopIterations[expr];
+                if (iterations == nativeTier->threshold())
+                    nativeTier->requestLoopCompile(expr, *env);
+                else if (iterations > nativeTier->threshold() && nativeTier->tryEnterLoop(expr, *env, result))
+                    break;
+            }
+
             expr->body->accept(this);
             result = lastValue;        }
         lastValue = result;
@@ -933,6 +968,8 @@ struct EvaluatorVisitor : StmtVisitor, ExprVisitor
             }
             
             TypeDecl* parentTypeDecl = it->second;
+            if (profile)
+                profile->recordCall(expr->node_id);
             
             // Evaluar argumentos
             std::vector<Value> args;
@@ -952,6 +989,8 @@ struct EvaluatorVisitor : StmtVisitor, ExprVisitor
                     if (methodName == expr->method && params.size() == args.size()) {
                         // Encontramos el método con el número correcto de parámetros
                         if (i < searchTypeDecl->methodBodies.size() && searchTypeDecl->methodBodies[i]) {
+                            if (nativeTier)
+                                ++methodCalls[searchTypeDecl->name + "." + methodName];
                             // Mantener el contexto de self actual (no cambiar currentSelf)
                             auto oldSelf = currentSelf;
                             
@@ -1003,6 +1042,8 @@ struct EvaluatorVisitor : StmtVisitor, ExprVisitor
         }
         
         auto obj = lastValue.asObject();
+        if (profile)
+            profile->recordReceiver(expr->node_id, obj->typeName);
         
         // Evaluar argumentos
         std::vector<Value> args;
@@ -1027,6 +1068,8 @@ struct EvaluatorVisitor : StmtVisitor, ExprVisitor
                 if (methodName == expr->method && params.size() == args.size()) {
                     // Encontramos el método con el número correcto de parámetros
                     if (i < searchTypeDecl->methodBodies.size() && searchTypeDecl->methodBodies[i]) {
+                        if (nativeTier)
+                            ++methodCalls[searchTypeDecl->name + "." + methodName];
                         // Establecer contexto de self
                         auto oldSelf = currentSelf;
                         currentSelf = obj;
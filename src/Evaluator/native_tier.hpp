@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../AST/ast.hpp"
+#include "../Value/value.hpp"
+#include "env_frame.hpp"
+
+// Nivel nativo de la ejecución escalonada (--tiered). El intérprete cuenta las
+// invocaciones de cada función; al llegar a threshold() pide su compilación,
+// que ocurre en segundo plano mientras se sigue interpretando. Las llamadas
+// posteriores pasan por tryCall(): si el código nativo está listo y los
+// argumentos cumplen las guardas se ejecuta allí, si no se interpreta.
+// Los while se tratan igual contando vueltas (reemplazo en pila, OSR): el
+// resto del bucle se ejecuta en código nativo a partir de la vuelta actual.
+struct NativeTier
+{
+    virtual ~NativeTier() = default;
+
+    // Llamadas (o vueltas de un while) a partir de las cuales se considera caliente
+    virtual uint64_t threshold() const = 0;
+
+    // Se invoca una sola vez por función, al alcanzar el umbral
+    virtual void requestCompile(FunctionDecl *f) = 0;
+
+    // Devuelve false si la llamada debe interpretarse (sin código nativo,
+    // compilación fallida o guardas no satisfechas)
+    virtual bool tryCall(FunctionDecl *f, const std::vector<Value> &args, Value &result) = 0;
+
+    // Se invoca una sola vez por bucle, al alcanzar el umbral de vueltas; las
+    // variables libres del bucle se toman de env
+    virtual void requestLoopCompile(WhileExpr *loop, const EnvFrame &env) = 0;
+
+    // Ejecuta el bucle hasta su salida en código nativo, leyendo de env las
+    // variables vivas y escribiéndolas de vuelta al terminar. Se llama con la
+    // condición recién evaluada como verdadera; result es el valor del while
+    virtual bool tryEnterLoop(WhileExpr *loop, EnvFrame &env, Value &result) = 0;
+};
@@ -19,6 +19,7 @@ Program* rootAST = nullptr;
 
 // Variables globales temporales para el parser
 TypeDecl* currentTypeDecl = nullptr;
+int functionLine = 0;
 %}
 
 
@@ -45,6 +46,7 @@ TypeDecl* currentTypeDecl = nullptr;
 %type <stmts> stmt_list
 %type <binding> binding
 %type <str_list> ident_list
+%type <str> function_name
 %type <bindings> binding_list 
 %type <expr> if_expr elif_list
 %type <expr_list> argument_list
@@ -112,6 +114,14 @@ binding_list:
       }
 ;
 
+// Línea donde empieza la función (para la información de depuración)
+function_name:
+      FUNCTION IDENT {
+          functionLine = yylineno;
+          $$ = $2;
+      }
+;
+
 binding:
       IDENT ASSIGN expr {
           $$ = new std::pair<std::string, Expr*>(std::string($1), $3);
@@ -126,21 +136,21 @@ stmt:
       $$ = new ExprStmt( ExprPtr($1) );
     }
 
-  | FUNCTION IDENT LPAREN ident_list RPAREN LBRACE stmt_list RBRACE {
-          std::vector<std::string> args = std::move(*$4);
-          delete $4;
+  | function_name LPAREN ident_list RPAREN LBRACE stmt_list RBRACE {
+          std::vector<std::string> args = std::move(*$3);
+          delete $3;
 
           auto block = std::make_unique<Program>();
-          block->stmts = std::move(*$7);
-          delete $7;
+          block->stmts = std::move(*$6);
+          delete $6;
 
-          $$ = new FunctionDecl(std::string($2), std::move(args), std::move(block));
-          free($2);
+          $$ = new FunctionDecl(std::string($1), std::move(args), std::move(block), functionLine);
+          free($1);
       }
-  | FUNCTION IDENT LPAREN ident_list RPAREN ARROW expr  {
-          std::vector<std::string> args = std::move(*$4);
-          delete $4;          $$ = new FunctionDecl(std::string($2), std::move(args), StmtPtr(new ExprStmt(ExprPtr($7))));
-          free($2);
+  | function_name LPAREN ident_list RPAREN ARROW expr  {
+          std::vector<std::string> args = std::move(*$3);
+          delete $3;          $$ = new FunctionDecl(std::string($1), std::move(args), StmtPtr(new ExprStmt(ExprPtr($6))), functionLine);
+          free($1);
       }
   | type_declaration {
           $$ = $1;
@@ -199,30 +209,30 @@ expr:
       }
     
     | NEW IDENT LPAREN argument_list RPAREN {
-          $$ = new NewExpr(std::string($2), std::move(*$4));
+          $$ = new NewExpr(std::string($2), std::move(*$4), yylineno);
           delete $4;
           free($2);
       }
       
     | NEW IDENT LPAREN RPAREN {
           std::vector<ExprPtr> empty_args;
-          $$ = new NewExpr(std::string($2), std::move(empty_args));
+          $$ = new NewExpr(std::string($2), std::move(empty_args), yylineno);
           free($2);
       }
         | expr DOT IDENT {
-          $$ = new MemberExpr(ExprPtr($1), std::string($3));
+          $$ = new MemberExpr(ExprPtr($1), std::string($3), yylineno);
           free($3);
       }
       
     | expr DOT IDENT LPAREN argument_list RPAREN {
-          $$ = new MethodCallExpr(ExprPtr($1), std::string($3), std::move(*$5));
+          $$ = new MethodCallExpr(ExprPtr($1), std::string($3), std::move(*$5), yylineno);
           delete $5;
           free($3);
       }
       
     | expr DOT IDENT LPAREN RPAREN {
           std::vector<ExprPtr> empty_args;
-          $$ = new MethodCallExpr(ExprPtr($1), std::string($3), std::move(empty_args));
+          $$ = new MethodCallExpr(ExprPtr($1), std::string($3), std::move(empty_args), yylineno);
           free($3);
       }
       
@@ -237,31 +247,31 @@ expr:
     | BASE LPAREN RPAREN {
           $$ = new BaseExpr();
       }| MINUS expr %prec UMINUS {
-          $$ = new UnaryExpr(UnaryExpr::OP_NEG, ExprPtr($2));
+          $$ = new UnaryExpr(UnaryExpr::OP_NEG, ExprPtr($2), yylineno);
       }
 
     | NOT expr %prec NOT {
-          $$ = new UnaryExpr(UnaryExpr::OP_NOT, ExprPtr($2));
+          $$ = new UnaryExpr(UnaryExpr::OP_NOT, ExprPtr($2), yylineno);
       }
 
     | expr POW expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_POW, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_POW, ExprPtr($1), ExprPtr($3), yylineno);
       }    | expr MULT expr {
           $$ = new BinaryExpr(BinaryExpr::OP_MUL, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr DIV expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_DIV, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_DIV, ExprPtr($1), ExprPtr($3), yylineno);
       }    | expr MOD expr %prec MULT {
-          $$ = new BinaryExpr(BinaryExpr::OP_MOD, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_MOD, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr ENHANCED_MOD expr %prec MULT {
-          $$ = new BinaryExpr(BinaryExpr::OP_ENHANCED_MOD, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_ENHANCED_MOD, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr TRIPLE_PLUS expr %prec PLUS {
-          $$ = new BinaryExpr(BinaryExpr::OP_TRIPLE_PLUS, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_TRIPLE_PLUS, ExprPtr($1), ExprPtr($3), yylineno);
       }
     | expr PLUS expr {
           $$ = new BinaryExpr(BinaryExpr::OP_ADD, ExprPtr($1), ExprPtr($3), yylineno);
@@ -270,49 +280,49 @@ expr:
       }
 
     | expr LESS_THAN expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_LT, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_LT, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr GREATER_THAN expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_GT, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_GT, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr LE expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_LE, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_LE, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr GE expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_GE, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_GE, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr EQ expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_EQ, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_EQ, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr NEQ expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_NEQ, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_NEQ, ExprPtr($1), ExprPtr($3), yylineno);
       }    | expr OR expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_OR, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_OR, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr OR_SIMPLE expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_OR_SIMPLE, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_OR_SIMPLE, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr AND expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_AND, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_AND, ExprPtr($1), ExprPtr($3), yylineno);
       }
 
     | expr AND_SIMPLE expr {
-          $$ = new BinaryExpr(BinaryExpr::OP_AND_SIMPLE, ExprPtr($1), ExprPtr($3));
+          $$ = new BinaryExpr(BinaryExpr::OP_AND_SIMPLE, ExprPtr($1), ExprPtr($3), yylineno);
       }    | expr CONCAT expr {
         // Creamos un BinaryExpr con OP_CONCAT
-        $$ = new BinaryExpr(BinaryExpr::OP_CONCAT, ExprPtr($1), ExprPtr($3));
+        $$ = new BinaryExpr(BinaryExpr::OP_CONCAT, ExprPtr($1), ExprPtr($3), yylineno);
     }  
 
     | expr CONCAT_SPACE expr {
         // Creamos un BinaryExpr con OP_CONCAT_SPACE
-        $$ = new BinaryExpr(BinaryExpr::OP_CONCAT_SPACE, ExprPtr($1), ExprPtr($3));
+        $$ = new BinaryExpr(BinaryExpr::OP_CONCAT_SPACE, ExprPtr($1), ExprPtr($3), yylineno);
     }
 
     | LPAREN expr RPAREN {
@@ -330,16 +340,16 @@ expr:
           delete $2;
           $$ = result;      
         }    | IDENT ASSIGN_DESTRUCT expr {
-          $$ = new AssignExpr(std::string($1), ExprPtr($3));
+          $$ = new AssignExpr(std::string($1), ExprPtr($3), yylineno);
           free($1);
       }
       
     | expr DOT IDENT ASSIGN_DESTRUCT expr {
-          $$ = new MemberAssignExpr(ExprPtr($1), std::string($3), ExprPtr($5));
+          $$ = new MemberAssignExpr(ExprPtr($1), std::string($3), ExprPtr($5), yylineno);
           free($3);
       }
     | WHILE LPAREN expr RPAREN expr {
-      $$ = new WhileExpr(ExprPtr($3), ExprPtr($5));
+      $$ = new WhileExpr(ExprPtr($3), ExprPtr($5), yylineno);
     }
 
     | if_expr  
@@ -383,7 +393,7 @@ expr:
 
 if_expr:
     IF LPAREN expr RPAREN expr elif_list {
-        $$ = new IfExpr(ExprPtr($3), ExprPtr($5), ExprPtr($6));
+        $$ = new IfExpr(ExprPtr($3), ExprPtr($5), ExprPtr($6), yylineno);
     }
 ;
 
@@ -392,7 +402,7 @@ elif_list:
         $$ = $2;
     }
     | ELIF LPAREN expr RPAREN expr elif_list {
-        $$ = new IfExpr(ExprPtr($3), ExprPtr($5), ExprPtr($6));
+        $$ = new IfExpr(ExprPtr($3), ExprPtr($5), ExprPtr($6), yylineno);
     }
 ;
 
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Perfil de ejecución recolectado por el intérprete (--profile-out) y usado
+// por el generador LLVM (--profile-use). Cada contador se indexa por el
+// node_id del nodo del AST, que es estable mientras no cambie el código fuente;
+// por eso el archivo guarda también un hash del fuente.
+//
+// Formato (texto, una entrada por línea):
+//   hulk-profile 1 <hash-del-fuente>
+//   branch <id> <veces-verdadero> <veces-falso>   (condición de if / while)
+//   call <id> <llamadas>                          (CallExpr / MethodCallExpr)
+//   type <id> <tipo> <veces>                      (tipo del receptor de un método)
+struct ExecutionProfile
+{
+    struct BranchCounts
+    {
+        uint64_t taken = 0;
+        uint64_t notTaken = 0;
+    };
+
+    std::string sourceHash;
+    std::map<int, BranchCounts> branches;
+    std::map<int, uint64_t> calls;
+    std::map<int, std::map<std::string, uint64_t>> receiverTypes;
+
+    // Registro (intérprete)
+    void recordBranch(int nodeId, bool taken)
+    {
+        BranchCounts &counts = branches[nodeId];
+        if (taken)
+            ++counts.taken;
+        else
+            ++counts.notTaken;
+    }
+
+    void recordCall(int nodeId) { ++calls[nodeId]; }
+
+    void recordReceiver(int nodeId, const std::string &typeName)
+    {
+        ++calls[nodeId];
+        ++receiverTypes[nodeId][typeName];
+    }
+
+    // Consultas (generador de código)
+    const BranchCounts *branch(int nodeId) const
+    {
+        auto it = branches.find(nodeId);
+        return it == branches.end() ? nullptr : &it->second;
+    }
+
+    uint64_t callCount(int nodeId) const
+    {
+        auto it = calls.find(nodeId);
+        return it == calls.end() ? 0 : it->second;
+    }
+
+    // Tipos del receptor ordenados de más a menos frecuente
+    std::vector<std::pair<std::string, uint64_t>> receiverHistogram(int nodeId) const
+    {
+        std::vector<std::pair<std::string, uint64_t>> histogram;
+        auto it = receiverTypes.find(nodeId);
+        if (it != receiverTypes.end())
+            histogram.assign(it->second.begin(), it->second.end());
+        std::stable_sort(histogram.begin(), histogram.end(),
+                         [](const auto &a, const auto &b) { return a.second > b.second; });
+        return histogram;
+    }
+
+    // FNV-1a de 64 bits: estable entre plataformas y compiladores
+    static std::string hashSource(const std::string &source)
+    {
+        uint64_t hash = 1469598103934665603ull;
+        for (unsigned char c : source)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        std::ostringstream out;
+        out << std::hex << hash;
+        return out.str();
+    }
+
+    bool save(const std::string &path) const
+    {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        out << "hulk-profile 1 " << sourceHash << "\n";
+        for (const auto &[id, counts] : branches)
+            out << "branch " << id << " " << counts.taken << " " << counts.notTaken << "\n";
+        for (const auto &[id, count] : calls)
+            out << "call " << id << " " << count << "\n";
+        for (const auto &[id, histogram] : receiverTypes)
+            for (const auto &[typeName, count] : histogram)
+                out << "type " << id << " " << typeName << " " << count << "\n";
+        return static_cast<bool>(out);
+    }
+
+    bool load(const std::string &path)
+    {
+        std::ifstream in(path);
+        std::string magic;
+        int version = 0;
+        if (!(in >> magic >> version >> sourceHash) || magic != "hulk-profile" || version != 1)
+            return false;
+
+        std::string kind;
+        while (in >> kind)
+        {
+            int id = 0;
+            if (kind == "branch")
+            {
+                BranchCounts counts;
+                in >> id >> counts.taken >> counts.notTaken;
+                branches[id] = counts;
+            }
+            else if (kind == "call")
+            {
+                uint64_t count = 0;
+                in >> id >> count;
+                calls[id] = count;
+            }
+            else if (kind == "type")
+            {
+                std::string typeName;
+                uint64_t count = 0;
+                in >> id >> typeName >> count;
+                receiverTypes[id][typeName] = count;
+            }
+            else
+            {
+                return false;
+            }
+            if (!in)
+                return false;
+        }
+        return true;
+    }
+};
@@ -4,95 +4,549 @@
 #include <math.h>
 #include <stdarg.h>
 #include <assert.h>
+#include <setjmp.h>
+#include <time.h>
 
-// Forward declarations
-char* hulk_string_concat(const char* a, const char* b);
-char* hulk_string_triple_concat(const char* a, const char* b, const char* c);
-char* hulk_string_repeat(const char* str, int times);
-int hulk_string_equal(const char* a, const char* b);
-double hulk_integer_div(double a, double b);
-double hulk_enhanced_mod(double a, double b);
-char* hulk_triple_add(const char* a, const char* b, const char* c);
-int hulk_logical_and(int a, int b);
-int hulk_logical_or(int a, int b);
-int hulk_logical_not(int a);
-void hulk_debug(const char* format, ...);
-char* hulk_type_of(const char* type_name);
-void hulk_assert(int condition, const char* message);
-char* hulk_str_number(double value);
-char* hulk_str_string(const char* str);
-char* hulk_str_boolean(int value);
-char* hulk_double_to_str(double value);
-char* hulk_bool_to_str(int value);
+#include "hulk_runtime.h"
 
-// String operations
-char* hulk_string_concat(const char* a, const char* b) {
-    if (!a) a = "";
-    if (!b) b = "";
+// Arena allocator
+typedef struct HulkArenaChunk {
+    struct HulkArenaChunk* next;
+    size_t size;
+    size_t used;
+    // Payload follows the header (kept HULK_ARENA_ALIGNMENT-aligned)
+} HulkArenaChunk;
+
+typedef struct HulkArenaFreeBlock {
+    struct HulkArenaFreeBlock* next;
+} HulkArenaFreeBlock;
+
+#define HULK_ARENA_SIZE_CLASSES (HULK_ARENA_MAX_SMALL / HULK_ARENA_ALIGNMENT)
+#define HULK_ARENA_HEADER_SIZE \
+    ((sizeof(HulkArenaChunk) + HULK_ARENA_ALIGNMENT - 1) & ~(size_t)(HULK_ARENA_ALIGNMENT - 1))
+
+typedef struct HulkArena {
+    HulkArenaChunk* chunks;
+    HulkArenaFreeBlock* free_lists[HULK_ARENA_SIZE_CLASSES];
+} HulkArena;
+
+static _Thread_local HulkArena hulk_arena;
+static int hulk_arena_exit_registered = 0;
+
+static size_t hulk_arena_round(size_t size) {
+    if (size == 0) size = 1;
+    return (size + HULK_ARENA_ALIGNMENT - 1) & ~(size_t)(HULK_ARENA_ALIGNMENT - 1);
+}
+
+static HulkArenaChunk* hulk_arena_new_chunk(size_t min_payload) {
+    size_t payload = min_payload > HULK_ARENA_CHUNK_SIZE ? min_payload : HULK_ARENA_CHUNK_SIZE;
+    HulkArenaChunk* chunk = malloc(HULK_ARENA_HEADER_SIZE + payload);
+    if (!chunk) {
+        fprintf(stderr, "Error: Memory allocation failed in arena\n");
+        exit(1);
+    }
+    chunk->size = payload;
+    chunk->used = 0;
+    chunk->next = NULL;
     
-    size_t len_a = strlen(a);
-    size_t len_b = strlen(b);
-    char* result = malloc(len_a + len_b + 1);
+    if (!hulk_arena_exit_registered) {
+        hulk_arena_exit_registered = 1;
+        atexit(hulk_arena_release_all);
+    }
+    return chunk;
+}
+
+void* hulk_arena_alloc(size_t size) {
+    size_t rounded = hulk_arena_round(size);
     
-    if (!result) {
-        fprintf(stderr, "Error: Memory allocation failed in string concatenation\n");
-        exit(1);
+    // Small blocks are recycled first
+    if (rounded <= HULK_ARENA_MAX_SMALL) {
+        size_t size_class = rounded / HULK_ARENA_ALIGNMENT - 1;
+        HulkArenaFreeBlock* block = hulk_arena.free_lists[size_class];
+        if (block) {
+            hulk_arena.free_lists[size_class] = block->next;
+            return block;
+        }
     }
     
-    strcpy(result, a);
-    strcat(result, b);
+    HulkArenaChunk* chunk = hulk_arena.chunks;
+    if (!chunk || chunk->size - chunk->used < rounded) {
+        chunk = hulk_arena_new_chunk(rounded);
+        if (rounded > HULK_ARENA_CHUNK_SIZE && hulk_arena.chunks) {
+            // Oversized blocks get a dedicated chunk behind the current one,
+            // which stays at the head for further bump allocation
+            chunk->next = hulk_arena.chunks->next;
+            hulk_arena.chunks->next = chunk;
+        } else {
+            chunk->next = hulk_arena.chunks;
+            hulk_arena.chunks = chunk;
+        }
+    }
+    
+    void* result = (char*)chunk + HULK_ARENA_HEADER_SIZE + chunk->used;
+    chunk->used += rounded;
     return result;
 }
 
-char* hulk_string_triple_concat(const char* a, const char* b, const char* c) {
-    if (!a) a = "";
-    if (!b) b = "";
-    if (!c) c = "";
+void hulk_arena_free(void* ptr, size_t size) {
+    // Large blocks stay in their chunk until the bulk release
+    size_t rounded = hulk_arena_round(size);
+    if (!ptr || rounded > HULK_ARENA_MAX_SMALL) {
+        return;
+    }
+    size_t size_class = rounded / HULK_ARENA_ALIGNMENT - 1;
+    HulkArenaFreeBlock* block = ptr;
+    block->next = hulk_arena.free_lists[size_class];
+    hulk_arena.free_lists[size_class] = block;
+}
+
+void hulk_arena_release_all(void) {
+    HulkArenaChunk* chunk = hulk_arena.chunks;
+    while (chunk) {
+        HulkArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    memset(&hulk_arena, 0, sizeof(hulk_arena));
+}
+
+// Garbage collector
+#define HULK_GC_BLOCK_ALIGNMENT 16
+#define HULK_GC_SIZE_CLASSES (HULK_GC_MAX_OBJECT / HULK_GC_BLOCK_ALIGNMENT)
+#define HULK_GC_MAX_BLOCKS (HULK_GC_PAGE_SIZE / HULK_GC_BLOCK_ALIGNMENT)
+
+typedef struct HulkGCPage {
+    struct HulkGCPage* next_available;   // pages of this class with free blocks
+    size_t block_size;
+    size_t block_count;
+    size_t live_blocks;
+    void* free_list;
+    uint64_t allocated[HULK_GC_MAX_BLOCKS / 64];
+    uint64_t marked[HULK_GC_MAX_BLOCKS / 64];
+} HulkGCPage;
+
+#define HULK_GC_FIRST_BLOCK \
+    ((sizeof(HulkGCPage) + HULK_GC_BLOCK_ALIGNMENT - 1) & ~(size_t)(HULK_GC_BLOCK_ALIGNMENT - 1))
+
+typedef struct HulkGC {
+    const HulkTypeLayout* layouts;
+    int64_t layout_count;
+    void* stack_base;
+    
+    HulkGCPage* available[HULK_GC_SIZE_CLASSES];
+    HulkGCPage** pages;             // sorted by address for pointer lookup
+    size_t page_count;
+    size_t page_capacity;
+    
+    void** mark_stack;
+    size_t mark_count;
+    size_t mark_capacity;
     
-    size_t len_a = strlen(a);
-    size_t len_b = strlen(b);
-    size_t len_c = strlen(c);
-    char* result = malloc(len_a + len_b + len_c + 1);
+    size_t heap_budget;             // allocation volume between collections
+    size_t min_heap_budget;
+    size_t allocated_since_gc;
+    size_t live_bytes;
     
-    if (!result) {
-        fprintf(stderr, "Error: Memory allocation failed in triple concatenation\n");
+    // Statistics
+    size_t collections;
+    size_t total_allocated;
+    size_t total_freed;
+    size_t peak_live_bytes;
+    double gc_seconds;
+} HulkGC;
+
+static HulkGC hulk_gc;
+
+static size_t hulk_gc_parse_size(const char* text, size_t fallback) {
+    if (!text || !*text) return fallback;
+    char* end;
+    double value = strtod(text, &end);
+    if (value <= 0) return fallback;
+    switch (*end) {
+        case 'k': case 'K': value *= 1024.0; break;
+        case 'm': case 'M': value *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': value *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)value;
+}
+
+static void hulk_gc_print_stats(void) {
+    fprintf(stderr, "[GC] collections: %zu\n", hulk_gc.collections);
+    fprintf(stderr, "[GC] allocated: %zu bytes, freed: %zu bytes\n", hulk_gc.total_allocated, hulk_gc.total_freed);
+    fprintf(stderr, "[GC] live at exit: %zu bytes, peak live: %zu bytes\n", hulk_gc.live_bytes, hulk_gc.peak_live_bytes);
+    fprintf(stderr, "[GC] pages: %zu (%d KiB each), time in GC: %.3f ms\n",
+            hulk_gc.page_count, HULK_GC_PAGE_SIZE / 1024, hulk_gc.gc_seconds * 1000.0);
+}
+
+void hulk_gc_init(const HulkTypeLayout* layouts, int64_t layout_count, void* stack_base) {
+    hulk_gc.layouts = layouts;
+    hulk_gc.layout_count = layout_count;
+    hulk_gc.stack_base = stack_base;
+    hulk_gc.min_heap_budget = hulk_gc_parse_size(getenv("HULK_GC_HEAP_SIZE"), HULK_GC_DEFAULT_HEAP_SIZE);
+    hulk_gc.heap_budget = hulk_gc.min_heap_budget;
+    
+    const char* stats = getenv("HULK_GC_STATS");
+    if (stats && *stats && strcmp(stats, "0") != 0) {
+        atexit(hulk_gc_print_stats);
+    }
+}
+
+static HulkGCPage* hulk_gc_find_page(uintptr_t address) {
+    uintptr_t page_address = address & ~(uintptr_t)(HULK_GC_PAGE_SIZE - 1);
+    size_t low = 0, high = hulk_gc.page_count;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        uintptr_t mid_address = (uintptr_t)hulk_gc.pages[mid];
+        if (mid_address == page_address) return hulk_gc.pages[mid];
+        if (mid_address < page_address) low = mid + 1; else high = mid;
+    }
+    return NULL;
+}
+
+static HulkGCPage* hulk_gc_new_page(size_t block_size) {
+    HulkGCPage* page = aligned_alloc(HULK_GC_PAGE_SIZE, HULK_GC_PAGE_SIZE);
+    if (!page) {
+        fprintf(stderr, "Error: Memory allocation failed in GC heap\n");
         exit(1);
     }
+    memset(page, 0, sizeof(HulkGCPage));
+    page->block_size = block_size;
+    page->block_count = (HULK_GC_PAGE_SIZE - HULK_GC_FIRST_BLOCK) / block_size;
     
-    strcpy(result, a);
-    strcat(result, b);
-    strcat(result, c);
-    return result;
+    // Thread every block onto the free list, lowest address first
+    char* first = (char*)page + HULK_GC_FIRST_BLOCK;
+    for (size_t i = page->block_count; i > 0; --i) {
+        void** block = (void**)(first + (i - 1) * block_size);
+        *block = page->free_list;
+        page->free_list = block;
+    }
+    
+    // Keep the registry sorted so conservative lookups can binary-search it
+    if (hulk_gc.page_count == hulk_gc.page_capacity) {
+        hulk_gc.page_capacity = hulk_gc.page_capacity ? hulk_gc.page_capacity * 2 : 16;
+        hulk_gc.pages = realloc(hulk_gc.pages, hulk_gc.page_capacity * sizeof(HulkGCPage*));
+        if (!hulk_gc.pages) {
+            fprintf(stderr, "Error: Memory allocation failed in GC page table\n");
+            exit(1);
+        }
+    }
+    size_t position = hulk_gc.page_count;
+    while (position > 0 && (uintptr_t)hulk_gc.pages[position - 1] > (uintptr_t)page) {
+        hulk_gc.pages[position] = hulk_gc.pages[position - 1];
+        position--;
+    }
+    hulk_gc.pages[position] = page;
+    hulk_gc.page_count++;
+    return page;
 }
 
-char* hulk_string_repeat(const char* str, int times) {
-    if (!str || times <= 0) {
-        char* empty = malloc(1);
-        empty[0] = '\0';
-        return empty;
+static void hulk_gc_push_mark(void* object) {
+    if (hulk_gc.mark_count == hulk_gc.mark_capacity) {
+        hulk_gc.mark_capacity = hulk_gc.mark_capacity ? hulk_gc.mark_capacity * 2 : 256;
+        hulk_gc.mark_stack = realloc(hulk_gc.mark_stack, hulk_gc.mark_capacity * sizeof(void*));
+        if (!hulk_gc.mark_stack) {
+            fprintf(stderr, "Error: Memory allocation failed in GC mark stack\n");
+            exit(1);
+        }
     }
+    hulk_gc.mark_stack[hulk_gc.mark_count++] = object;
+}
+
+// Marks the object containing `address`, if any (interior pointers included)
+static void hulk_gc_mark_candidate(uintptr_t address) {
+    HulkGCPage* page = hulk_gc_find_page(address);
+    if (!page) return;
     
-    size_t str_len = strlen(str);
-    size_t total_len = str_len * times;
-    char* result = malloc(total_len + 1);
+    uintptr_t first = (uintptr_t)page + HULK_GC_FIRST_BLOCK;
+    if (address < first) return;
+    size_t index = (address - first) / page->block_size;
+    if (index >= page->block_count) return;
     
-    if (!result) {
-        fprintf(stderr, "Error: Memory allocation failed in string repeat\n");
+    uint64_t bit = (uint64_t)1 << (index % 64);
+    if (!(page->allocated[index / 64] & bit) || (page->marked[index / 64] & bit)) return;
+    page->marked[index / 64] |= bit;
+    hulk_gc_push_mark((void*)(first + index * page->block_size));
+}
+
+// Conservative scanning reads whole stack frames, including sanitizer redzones
+#if defined(__clang__) || defined(__GNUC__)
+#define HULK_GC_NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define HULK_GC_NO_SANITIZE
+#endif
+
+static HULK_GC_NO_SANITIZE void hulk_gc_scan_range(const void* low, const void* high) {
+    uintptr_t start = ((uintptr_t)low + sizeof(void*) - 1) & ~(uintptr_t)(sizeof(void*) - 1);
+    for (const uintptr_t* word = (const uintptr_t*)start; (const void*)(word + 1) <= high; ++word) {
+        hulk_gc_mark_candidate(*word);
+    }
+}
+
+static void hulk_gc_trace(void* object, size_t block_size) {
+    // Every object starts with its i32 type id; the layout lists the pointer fields
+    int32_t type_id = *(int32_t*)object;
+    if (type_id > 0 && type_id < hulk_gc.layout_count) {
+        const HulkTypeLayout* layout = &hulk_gc.layouts[type_id];
+        for (int64_t i = 0; i < layout->pointer_count; ++i) {
+            hulk_gc_mark_candidate(*(uintptr_t*)((char*)object + layout->pointer_offsets[i]));
+        }
+        for (int64_t i = 0; i < layout->tagged_count; ++i) {
+            const int64_t* slot = (const int64_t*)((char*)object + layout->tagged_offsets[i]);
+            if (slot[0] == HULK_VALUE_STRING || slot[0] == HULK_VALUE_OBJECT) {
+                hulk_gc_mark_candidate((uintptr_t)slot[1]);
+            }
+        }
+    } else {
+        // Unknown layout: treat the whole block conservatively
+        hulk_gc_scan_range(object, (char*)object + block_size);
+    }
+}
+
+static void hulk_gc_sweep(void) {
+    memset(hulk_gc.available, 0, sizeof(hulk_gc.available));
+    
+    size_t kept = 0;
+    for (size_t p = 0; p < hulk_gc.page_count; ++p) {
+        HulkGCPage* page = hulk_gc.pages[p];
+        char* first = (char*)page + HULK_GC_FIRST_BLOCK;
+        
+        for (size_t word = 0; word * 64 < page->block_count; ++word) {
+            uint64_t dead = page->allocated[word] & ~page->marked[word];
+            while (dead) {
+                size_t bit = (size_t)__builtin_ctzll(dead);
+                dead &= dead - 1;
+                void** block = (void**)(first + (word * 64 + bit) * page->block_size);
+                *block = page->free_list;
+                page->free_list = block;
+                page->live_blocks--;
+                hulk_gc.live_bytes -= page->block_size;
+                hulk_gc.total_freed += page->block_size;
+            }
+            page->allocated[word] &= page->marked[word];
+            page->marked[word] = 0;
+        }
+        
+        // Empty pages go back to the system; the rest become available again
+        if (page->live_blocks == 0) {
+            free(page);
+            continue;
+        }
+        hulk_gc.pages[kept++] = page;
+        if (page->free_list) {
+            size_t size_class = page->block_size / HULK_GC_BLOCK_ALIGNMENT - 1;
+            page->next_available = hulk_gc.available[size_class];
+            hulk_gc.available[size_class] = page;
+        }
+    }
+    hulk_gc.page_count = kept;
+}
+
+static void __attribute__((noinline)) hulk_gc_collect_from_here(void) {
+    // Everything between this frame and the stack base may hold roots,
+    // including the registers spilled by setjmp in the caller
+    volatile uintptr_t stack_top = 0;
+    hulk_gc_scan_range((const void*)&stack_top, hulk_gc.stack_base);
+    
+    while (hulk_gc.mark_count > 0) {
+        void* object = hulk_gc.mark_stack[--hulk_gc.mark_count];
+        hulk_gc_trace(object, hulk_gc_find_page((uintptr_t)object)->block_size);
+    }
+    hulk_gc_sweep();
+}
+
+void hulk_gc_collect(void) {
+    if (!hulk_gc.stack_base) {
+        return; // Roots are unknown until hulk_gc_init has run
+    }
+    clock_t start = clock();
+    
+    jmp_buf registers;
+    setjmp(registers);
+    hulk_gc_collect_from_here();
+    
+    // Grow the budget with the live heap so collections stay proportional
+    hulk_gc.collections++;
+    hulk_gc.allocated_since_gc = 0;
+    hulk_gc.heap_budget = hulk_gc.live_bytes * 2 > hulk_gc.min_heap_budget
+        ? hulk_gc.live_bytes * 2 : hulk_gc.min_heap_budget;
+    hulk_gc.gc_seconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void* hulk_gc_alloc(size_t size) {
+    size_t rounded = (size + HULK_GC_BLOCK_ALIGNMENT - 1) & ~(size_t)(HULK_GC_BLOCK_ALIGNMENT - 1);
+    if (rounded == 0) rounded = HULK_GC_BLOCK_ALIGNMENT;
+    if (rounded > HULK_GC_MAX_OBJECT) {
+        fprintf(stderr, "Error: Object of %zu bytes exceeds the GC object limit\n", size);
         exit(1);
     }
     
-    result[0] = '\0';
-    for (int i = 0; i < times; i++) {
-        strcat(result, str);
+    if (hulk_gc.allocated_since_gc + rounded > hulk_gc.heap_budget) {
+        hulk_gc_collect();
+    }
+    
+    size_t size_class = rounded / HULK_GC_BLOCK_ALIGNMENT - 1;
+    HulkGCPage* page = hulk_gc.available[size_class];
+    if (!page) {
+        page = hulk_gc_new_page(rounded);
+        hulk_gc.available[size_class] = page;
+    }
+    
+    void** block = page->free_list;
+    page->free_list = *block;
+    if (!page->free_list) {
+        hulk_gc.available[size_class] = page->next_available;
     }
     
+    size_t index = ((char*)block - ((char*)page + HULK_GC_FIRST_BLOCK)) / page->block_size;
+    page->allocated[index / 64] |= (uint64_t)1 << (index % 64);
+    page->live_blocks++;
+    
+    hulk_gc.allocated_since_gc += rounded;
+    hulk_gc.total_allocated += rounded;
+    hulk_gc.live_bytes += rounded;
+    if (hulk_gc.live_bytes > hulk_gc.peak_live_bytes) {
+        hulk_gc.peak_live_bytes = hulk_gc.live_bytes;
+    }
+    
+    memset(block, 0, rounded);
+    return block;
+}
+
+// Runtime string objects
+
+static HulkString* hulk_string_alloc(size_t length) {
+    HulkString* str = hulk_arena_alloc(sizeof(HulkString));
+    
+    // Short strings live in the inline buffer, long ones get their own block
+    if (length <= HULK_STRING_INLINE_CAPACITY) {
+        str->data = str->inline_buf;
+    } else {
+        str->data = hulk_arena_alloc(length + 1);
+    }
+    
+    str->refcount = 1;
+    str->length = (int64_t)length;
+    str->data[length] = '\0';
+    return str;
+}
+
+HulkString* hulk_string_new(const char* data, size_t length) {
+    HulkString* str = hulk_string_alloc(length);
+    if (length > 0) {
+        memcpy(str->data, data, length);
+    }
+    return str;
+}
+
+HulkString* hulk_string_from_cstr(const char* str) {
+    if (!str) str = "";
+    return hulk_string_new(str, strlen(str));
+}
+
+HulkString* hulk_string_retain(HulkString* str) {
+    if (str && str->refcount > 0) {
+        str->refcount++;
+    }
+    return str;
+}
+
+void hulk_string_release(HulkString* str) {
+    // Negative refcounts mark compile-time literals, which are never freed
+    if (!str || str->refcount <= 0) {
+        return;
+    }
+    if (--str->refcount == 0) {
+        if (str->data != str->inline_buf) {
+            hulk_arena_free(str->data, (size_t)str->length + 1);
+        }
+        hulk_arena_free(str, sizeof(HulkString));
+    }
+}
+
+size_t hulk_string_length(const HulkString* str) {
+    return str ? (size_t)str->length : 0;
+}
+
+const char* hulk_string_data(const HulkString* str) {
+    return str ? str->data : "";
+}
+
+// String operations
+static HulkString* hulk_string_join(const HulkString* a, const char* sep, size_t sep_len, const HulkString* b) {
+    size_t len_a = hulk_string_length(a);
+    size_t len_b = hulk_string_length(b);
+    HulkString* result = hulk_string_alloc(len_a + sep_len + len_b);
+    
+    memcpy(result->data, hulk_string_data(a), len_a);
+    memcpy(result->data + len_a, sep, sep_len);
+    memcpy(result->data + len_a + sep_len, hulk_string_data(b), len_b);
     return result;
 }
 
-int hulk_string_equal(const char* a, const char* b) {
-    if (!a && !b) return 1;
+HulkString* hulk_string_concat(const HulkString* a, const HulkString* b) {
+    return hulk_string_join(a, "", 0, b);
+}
+
+HulkString* hulk_string_concat_space(const HulkString* a, const HulkString* b) {
+    return hulk_string_join(a, " ", 1, b);
+}
+
+// Concatenation chains: the total length is computed once, then every part is copied in place
+HulkString* hulk_string_concat_n(const HulkString* const* parts, int64_t count) {
+    size_t total = 0;
+    for (int64_t i = 0; i < count; ++i) {
+        total += hulk_string_length(parts[i]);
+    }
+    
+    HulkString* result = hulk_string_alloc(total);
+    char* out = result->data;
+    for (int64_t i = 0; i < count; ++i) {
+        size_t length = hulk_string_length(parts[i]);
+        memcpy(out, hulk_string_data(parts[i]), length);
+        out += length;
+    }
+    return result;
+}
+
+HulkString* hulk_string_triple_concat(const HulkString* a, const HulkString* b, const HulkString* c) {
+    size_t len_a = hulk_string_length(a);
+    size_t len_b = hulk_string_length(b);
+    size_t len_c = hulk_string_length(c);
+    HulkString* result = hulk_string_alloc(len_a + len_b + len_c);
+    
+    memcpy(result->data, hulk_string_data(a), len_a);
+    memcpy(result->data + len_a, hulk_string_data(b), len_b);
+    memcpy(result->data + len_a + len_b, hulk_string_data(c), len_c);
+    return result;
+}
+
+HulkString* hulk_string_repeat(const HulkString* str, int times) {
+    size_t str_len = hulk_string_length(str);
+    if (times <= 0 || str_len == 0) {
+        return hulk_string_alloc(0);
+    }
+    
+    size_t total_len = str_len * (size_t)times;
+    HulkString* result = hulk_string_alloc(total_len);
+    
+    // Copy once, then keep doubling the already written prefix
+    memcpy(result->data, hulk_string_data(str), str_len);
+    size_t written = str_len;
+    while (written < total_len) {
+        size_t chunk = (written <= total_len - written) ? written : total_len - written;
+        memcpy(result->data + written, result->data, chunk);
+        written += chunk;
+    }
+    
+    return result;
+}
+
+int hulk_string_equal(const HulkString* a, const HulkString* b) {
+    if (a == b) return 1;
     if (!a || !b) return 0;
-    return strcmp(a, b) == 0 ? 1 : 0;
+    if (a->length != b->length) return 0;
+    return memcmp(a->data, b->data, (size_t)a->length) == 0 ? 1 : 0;
 }
 
 // Enhanced arithmetic operations
@@ -120,7 +574,7 @@ double hulk_enhanced_mod(double a, double b) {
 }
 
 // Triple operations
-char* hulk_triple_add(const char* a, const char* b, const char* c) {
+HulkString* hulk_triple_add(const HulkString* a, const HulkString* b, const HulkString* c) {
     // For numeric triple add, we convert to string representation
     return hulk_string_triple_concat(a, b, c);
 }
@@ -148,49 +602,69 @@ void hulk_debug(const char* format, ...) {
     printf("\n");
 }
 
-char* hulk_type_of(const char* type_name) {
-    size_t len = strlen(type_name);
-    char* result = malloc(len + 1);
-    if (!result) {
-        fprintf(stderr, "Error: Memory allocation failed in type_of\n");
-        exit(1);
-    }
-    strcpy(result, type_name);
-    return result;
+HulkString* hulk_type_of(const char* type_name) {
+    return hulk_string_from_cstr(type_name);
 }
 
-void hulk_assert(int condition, const char* message) {
+void hulk_assert(int condition, const HulkString* message) {
     if (!condition) {
-        fprintf(stderr, "Assertion failed: %s\n", message ? message : "No message provided");
+        fprintf(stderr, "Assertion failed: %s\n", message ? hulk_string_data(message) : "No message provided");
         exit(1);
     }
 }
 
 // Standard math functions wrappers
+// Domain errors produce NaN/-inf like libm (and like the interpreter), so
+// these stay branch-free and interchangeable with the LLVM math intrinsics.
 double hulk_sin(double x) { return sin(x); }
 double hulk_cos(double x) { return cos(x); }
-double hulk_sqrt(double x) { 
-    if (x < 0) {
-        fprintf(stderr, "Error: Square root of negative number\n");
-        exit(1);
-    }
-    return sqrt(x); 
-}
-double hulk_log(double x) { 
-    if (x <= 0) {
-        fprintf(stderr, "Error: Logarithm of non-positive number\n");
-        exit(1);
-    }
-    return log(x); 
-}
+double hulk_sqrt(double x) { return sqrt(x); }
+double hulk_log(double x) { return log(x); }
 double hulk_exp(double x) { return exp(x); }
 double hulk_pow(double x, double y) { return pow(x, y); }
 
-// Memory management for strings
-void hulk_free_string(char* str) {
-    if (str) {
-        free(str);
+// Batched math
+// With -fopenmp-simd the loops below call the glibc libmvec variants
+// (_ZGV*_sin, ...), and on x86-64 each one is cloned for AVX-512, AVX2 and
+// SSE2 and picked at load time, so they process 8, 4 or 2 lanes per step.
+#if defined(__x86_64__) && defined(__GLIBC__) && defined(__GNUC__)
+#define HULK_BATCH_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#pragma omp declare simd notinbranch
+double sin(double);
+#pragma omp declare simd notinbranch
+double cos(double);
+#pragma omp declare simd notinbranch
+double exp(double);
+#pragma omp declare simd notinbranch
+double log(double);
+#pragma omp declare simd notinbranch
+double pow(double, double);
+#else
+#define HULK_BATCH_CLONES
+#endif
+
+#define HULK_DEFINE_UNARY_BATCH(name, fn)                                              \
+    HULK_BATCH_CLONES                                                                  \
+    void name(const double* restrict in, double* restrict out, int64_t count) {        \
+        _Pragma("omp simd")                                                            \
+        for (int64_t i = 0; i < count; i++) out[i] = fn(in[i]);                        \
     }
+
+HULK_DEFINE_UNARY_BATCH(hulk_sin_batch, sin)
+HULK_DEFINE_UNARY_BATCH(hulk_cos_batch, cos)
+HULK_DEFINE_UNARY_BATCH(hulk_sqrt_batch, sqrt)
+HULK_DEFINE_UNARY_BATCH(hulk_exp_batch, exp)
+HULK_DEFINE_UNARY_BATCH(hulk_log_batch, log)
+
+HULK_BATCH_CLONES
+void hulk_pow_batch(const double* restrict x, const double* restrict y, double* restrict out, int64_t count) {
+    _Pragma("omp simd")
+    for (int64_t i = 0; i < count; i++) out[i] = pow(x[i], y[i]);
+}
+
+// Memory management for strings
+void hulk_free_string(HulkString* str) {
+    hulk_string_release(str);
 }
 
 // Print functions
@@ -202,9 +676,9 @@ void hulk_print_number(double value) {
     }
 }
 
-void hulk_print_string(const char* str) {
+void hulk_print_string(const HulkString* str) {
     if (str) {
-        printf("%s", str);
+        fwrite(str->data, 1, (size_t)str->length, stdout);
     }
 }
 
@@ -217,55 +691,262 @@ void hulk_println() {
 }
 
 // String conversion functions (str built-in)
-char* hulk_str_number(double value) {
-    char* result = malloc(32); // Suficiente para números double
-    if (!result) {
-        fprintf(stderr, "Error: Memory allocation failed in str(number)\n");
-        exit(1);
-    }
+
+// Formats a double into a new string; "%.0f" of a large integer (1e40, 1e308)
+// does not fit the stack buffer, so those are formatted again into the string
+static HulkString* hulk_string_format_double(const char* format, double value) {
+    char buffer[32];
+    int length = snprintf(buffer, sizeof(buffer), format, value);
+    if (length < 0) return hulk_string_alloc(0);
+    if ((size_t)length < sizeof(buffer)) return hulk_string_new(buffer, (size_t)length);
     
-    if (floor(value) == value) {
-        snprintf(result, 32, "%.0f", value);
-    } else {
-        snprintf(result, 32, "%g", value);
+    HulkString* str = hulk_string_alloc((size_t)length);
+    snprintf(str->data, (size_t)length + 1, format, value);
+    return str;
+}
+
+HulkString* hulk_str_number(double value) {
+    return hulk_string_format_double(floor(value) == value ? "%.0f" : "%g", value);
+}
+
+HulkString* hulk_str_string(HulkString* str) {
+    // Strings are immutable, so str(s) can share the same object
+    if (!str) return hulk_string_alloc(0);
+    return hulk_string_retain(str);
+}
+
+HulkString* hulk_str_boolean(int value) {
+    return value ? hulk_string_new("true", 4) : hulk_string_new("false", 5);
+}
+
+HulkString* hulk_double_to_str(double value) {
+    return hulk_string_format_double("%.17g", value); // Precision suficiente para double
+}
+
+HulkString* hulk_bool_to_str(int value) {
+    return hulk_str_boolean(value);
+}
+
+// Dynamic values
+static HulkValue hulk_value_unpack(int64_t tag, int64_t payload) {
+    HulkValue value;
+    value.tag = tag;
+    memcpy(&value.as, &payload, sizeof(payload));
+    return value;
+}
+
+int64_t hulk_value_pointer_tag(const void* pointer) {
+    // Objects are the only values allocated on the collected heap
+    return pointer && hulk_gc_find_page((uintptr_t)pointer) ? HULK_VALUE_OBJECT : HULK_VALUE_STRING;
+}
+
+double hulk_value_to_number(int64_t tag, int64_t payload) {
+    HulkValue value = hulk_value_unpack(tag, payload);
+    switch (value.tag) {
+        // Like the interpreter, only numbers take part in arithmetic
+        case HULK_VALUE_NUMBER: return value.as.number;
+        case HULK_VALUE_BOOLEAN: hulk_dynamic_error("a Boolean cannot be used as a Number"); break;
+        case HULK_VALUE_STRING: hulk_dynamic_error("a String cannot be used as a Number"); break;
+        default: hulk_dynamic_error("an object cannot be used as a Number");
     }
-    return result;
+    return 0.0;
 }
 
-char* hulk_str_string(const char* str) {
-    if (!str) str = "";
-    size_t len = strlen(str);
-    char* result = malloc(len + 1);
-    if (!result) {
-        fprintf(stderr, "Error: Memory allocation failed in str(string)\n");
-        exit(1);
+int32_t hulk_value_truthy(int64_t tag, int64_t payload) {
+    HulkValue value = hulk_value_unpack(tag, payload);
+    switch (value.tag) {
+        case HULK_VALUE_NUMBER: return value.as.number != 0.0;
+        case HULK_VALUE_BOOLEAN: return value.as.boolean != 0;
+        case HULK_VALUE_STRING: return hulk_string_length(value.as.string) != 0;
+        default: return value.as.object != NULL;
     }
-    strcpy(result, str);
-    return result;
 }
 
-char* hulk_str_boolean(int value) {
-    const char* bool_str = value ? "true" : "false";
-    size_t len = strlen(bool_str);
-    char* result = malloc(len + 1);
-    if (!result) {
-        fprintf(stderr, "Error: Memory allocation failed in str(boolean)\n");
-        exit(1);
+HulkString* hulk_value_to_string(int64_t tag, int64_t payload) {
+    HulkValue value = hulk_value_unpack(tag, payload);
+    switch (value.tag) {
+        case HULK_VALUE_NUMBER: return hulk_str_number(value.as.number);
+        case HULK_VALUE_BOOLEAN: return hulk_str_boolean((int)value.as.boolean);
+        case HULK_VALUE_STRING: return hulk_str_string(value.as.string);
+        default: return hulk_string_from_cstr("<object>");
     }
-    strcpy(result, bool_str);
-    return result;
 }
 
-char* hulk_double_to_str(double value) {
-    char* result = malloc(32);
-    if (!result) {
-        fprintf(stderr, "Error: Memory allocation failed in double_to_str\n");
-        exit(1);
+void* hulk_value_to_pointer(int64_t tag, int64_t payload) {
+    HulkValue value = hulk_value_unpack(tag, payload);
+    if (value.tag == HULK_VALUE_STRING || value.tag == HULK_VALUE_OBJECT) {
+        return value.as.object;
     }
-    snprintf(result, 32, "%.17g", value); // Precision suficiente para double
-    return result;
+    return hulk_value_to_string(tag, payload);
 }
 
-char* hulk_bool_to_str(int value) {
-    return value ? hulk_str_string("true") : hulk_str_string("false");
+void hulk_value_print(int64_t tag, int64_t payload) {
+    HulkValue value = hulk_value_unpack(tag, payload);
+    switch (value.tag) {
+        case HULK_VALUE_NUMBER: hulk_print_number(value.as.number); break;
+        case HULK_VALUE_BOOLEAN: hulk_print_boolean((int)value.as.boolean); break;
+        case HULK_VALUE_STRING: hulk_print_string(value.as.string); break;
+        default: printf("<object>"); break;
+    }
+}
+
+int32_t hulk_value_equal(int64_t a_tag, int64_t a_payload, int64_t b_tag, int64_t b_payload) {
+    HulkValue a = hulk_value_unpack(a_tag, a_payload);
+    HulkValue b = hulk_value_unpack(b_tag, b_payload);
+    if (a.tag != b.tag) {
+        return 0;
+    }
+    switch (a.tag) {
+        case HULK_VALUE_NUMBER: return a.as.number == b.as.number;
+        case HULK_VALUE_STRING: return hulk_string_equal(a.as.string, b.as.string);
+        default: return a_payload == b_payload; // booleans by value, objects by identity
+    }
+}
+
+void hulk_dynamic_error(const char* message) {
+    fflush(stdout);
+    fprintf(stderr, "Runtime error: %s\n", message);
+    exit(1);
+}
+
+// Instrumentation
+typedef struct HulkProbeTable {
+    HulkProbe* const* probes;
+    int64_t count;
+    struct HulkProbeTable* next;
+} HulkProbeTable;
+
+static HulkProbeTable* hulk_probe_tables = NULL;
+static int hulk_instrument_exit_registered = 0;
+
+static const char* hulk_probe_kind_name(int32_t kind) {
+    switch (kind) {
+        case HULK_PROBE_FUNCTION: return "function";
+        case HULK_PROBE_THEN: return "then";
+        case HULK_PROBE_ELSE: return "else";
+        default: return "loop";
+    }
+}
+
+// Functions by cycles, then branches and loops by count
+static int hulk_probe_compare(const void* a, const void* b) {
+    const HulkProbe* x = *(HulkProbe* const*)a;
+    const HulkProbe* y = *(HulkProbe* const*)b;
+    int x_function = x->kind == HULK_PROBE_FUNCTION;
+    int y_function = y->kind == HULK_PROBE_FUNCTION;
+    if (x_function != y_function) return y_function - x_function;
+    uint64_t x_key = x_function ? x->cycles : x->count;
+    uint64_t y_key = y_function ? y->cycles : y->count;
+    if (x_key != y_key) return x_key < y_key ? 1 : -1;
+    return x->line - y->line;
+}
+
+static void hulk_json_string(FILE* out, const char* str) {
+    fputc('"', out);
+    for (; *str; ++str) {
+        if (*str == '"' || *str == '\\') fputc('\\', out);
+        fputc(*str, out);
+    }
+    fputc('"', out);
+}
+
+static void hulk_instrument_dump(void) {
+    size_t total = 0;
+    for (HulkProbeTable* table = __atomic_load_n(&hulk_probe_tables, __ATOMIC_ACQUIRE); table; table = table->next) {
+        total += (size_t)table->count;
+    }
+    HulkProbe** probes = malloc((total ? total : 1) * sizeof(HulkProbe*));
+    if (!probes) return;
+    size_t used = 0;
+    for (HulkProbeTable* table = __atomic_load_n(&hulk_probe_tables, __ATOMIC_ACQUIRE); table; table = table->next) {
+        for (int64_t i = 0; i < table->count; ++i) {
+            if (table->probes[i]->count > 0) probes[used++] = table->probes[i];
+        }
+    }
+    if (used == 0) {
+        free(probes);
+        return;
+    }
+    qsort(probes, used, sizeof(HulkProbe*), hulk_probe_compare);
+    
+    fflush(stdout);
+    fprintf(stderr, "=== HULK instrumentation ===\n");
+    fprintf(stderr, "%14s %18s %14s  %s\n", "calls", "cycles", "cycles/call", "function (line)");
+    for (size_t i = 0; i < used && probes[i]->kind == HULK_PROBE_FUNCTION; ++i) {
+        const HulkProbe* probe = probes[i];
+        fprintf(stderr, "%14llu %18llu %14llu  %s (%d)\n", (unsigned long long)probe->count,
+                (unsigned long long)probe->cycles, (unsigned long long)(probe->cycles / probe->count),
+                probe->name, probe->line);
+    }
+    int header = 0;
+    for (size_t i = 0; i < used; ++i) {
+        const HulkProbe* probe = probes[i];
+        if (probe->kind == HULK_PROBE_FUNCTION) continue;
+        if (!header) {
+            fprintf(stderr, "%14s %6s  %s\n", "count", "kind", "in function (line)");
+            header = 1;
+        }
+        fprintf(stderr, "%14llu %6s  %s (%d)\n", (unsigned long long)probe->count,
+                hulk_probe_kind_name(probe->kind), probe->name, probe->line);
+    }
+    
+    const char* path = getenv("HULK_INSTRUMENT_OUT");
+    if (!path || !*path) path = "hulk_instrument.json";
+    FILE* out = fopen(path, "w");
+    if (out) {
+        fprintf(out, "{\"probes\": [");
+        for (size_t i = 0; i < used; ++i) {
+            const HulkProbe* probe = probes[i];
+            fprintf(out, "%s\n  {\"name\": ", i ? "," : "");
+            hulk_json_string(out, probe->name);
+            fprintf(out, ", \"kind\": \"%s\", \"line\": %d, \"count\": %llu, \"cycles\": %llu}",
+                    hulk_probe_kind_name(probe->kind), probe->line, (unsigned long long)probe->count,
+                    (unsigned long long)probe->cycles);
+        }
+        fprintf(out, "\n]}\n");
+        fclose(out);
+        fprintf(stderr, "(written to %s)\n", path);
+    } else {
+        fprintf(stderr, "Warning: could not write %s\n", path);
+    }
+    free(probes);
+}
+
+void hulk_instrument_register(HulkProbe* const* probes, int64_t count) {
+    HulkProbeTable* table = malloc(sizeof(HulkProbeTable));
+    if (!table) return;
+    table->probes = probes;
+    table->count = count;
+    table->next = __atomic_load_n(&hulk_probe_tables, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&hulk_probe_tables, &table->next, table, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    if (!__atomic_exchange_n(&hulk_instrument_exit_registered, 1, __ATOMIC_ACQ_REL)) {
+        atexit(hulk_instrument_dump);
+    }
+}
+
+void hulk_instrument_flush(void) {
+    hulk_instrument_dump();
+    HulkProbeTable* table = __atomic_exchange_n(&hulk_probe_tables, NULL, __ATOMIC_ACQ_REL);
+    while (table) {
+        HulkProbeTable* next = table->next;
+        free(table);
+        table = next;
+    }
+}
+
+int hulk_cpu_level(void) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    // Resolvers run before the CPU model is initialized by its constructor
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+        __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq")) {
+        return 2;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi2")) {
+        return 1;
+    }
+#endif
+    return 0;
 }
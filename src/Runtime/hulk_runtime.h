@@ -1,20 +1,117 @@
 #ifndef HULK_RUNTIME_H
 #define HULK_RUNTIME_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Arena allocator used for objects and strings of compiled programs.
+// Each thread bump-allocates from its own chunks; freed blocks of up to
+// HULK_ARENA_MAX_SMALL bytes are recycled through per-size-class free lists.
+// All chunks are released together when the program exits.
+#define HULK_ARENA_ALIGNMENT 16
+#define HULK_ARENA_MAX_SMALL 256
+#define HULK_ARENA_CHUNK_SIZE (64 * 1024)
+
+void* hulk_arena_alloc(size_t size);
+void hulk_arena_free(void* ptr, size_t size);
+void hulk_arena_release_all(void);
+
+// Garbage-collected heap for objects of compiled programs.
+// Objects live in size-class pages; the collector marks conservatively from
+// the machine stack and precisely through object fields, using one layout
+// per type id that the compiler emits (type id 0 is unused). Collection is
+// triggered by allocation volume: HULK_GC_HEAP_SIZE (bytes, K/M/G suffix)
+// sets the initial budget, and HULK_GC_STATS=1 prints statistics at exit.
+// Boxed fields (a HulkValue: i64 tag, i64 payload) are listed separately and
+// their payload is traced only when the tag says it holds a string or object.
+typedef struct HulkTypeLayout {
+    int64_t size;
+    int64_t pointer_count;
+    const int64_t* pointer_offsets;
+    int64_t tagged_count;
+    const int64_t* tagged_offsets;
+} HulkTypeLayout;
+
+#define HULK_GC_PAGE_SIZE (64 * 1024)
+#define HULK_GC_MAX_OBJECT (8 * 1024)
+#define HULK_GC_DEFAULT_HEAP_SIZE (8 * 1024 * 1024)
+
+void hulk_gc_init(const HulkTypeLayout* layouts, int64_t layout_count, void* stack_base);
+void* hulk_gc_alloc(size_t size);
+void hulk_gc_collect(void);
+
+// Instrumentation of compiled code (--instrument). The compiler emits one
+// probe per function and method (and, with --instrument=branches, per if
+// branch and while back-edge) and registers each module's probe table before
+// its code runs. Entry probes count calls and the cycles (rdtsc) spent in the
+// outermost activation, callees included; branch and loop probes only count.
+// At exit a report goes to stderr and a JSON copy to HULK_INSTRUMENT_OUT
+// (default hulk_instrument.json).
+enum {
+    HULK_PROBE_FUNCTION = 0,
+    HULK_PROBE_THEN = 1,
+    HULK_PROBE_ELSE = 2,
+    HULK_PROBE_LOOP = 3
+};
+
+typedef struct HulkProbe {
+    uint64_t count;
+    uint64_t cycles;
+    int64_t depth; // activations in progress (recursion)
+    const char* name;
+    int32_t kind;
+    int32_t line;
+} HulkProbe;
+
+// Tables may be registered from several threads (the JIT compiles in the background)
+void hulk_instrument_register(HulkProbe* const* probes, int64_t count);
+// Reports and forgets the registered tables now; for code that is unloaded
+// before exit (the JIT frees its probes along with the code)
+void hulk_instrument_flush(void);
+
+// Function multiversioning (--multiversion): the level of the CPU the program
+// runs on, 2 = AVX-512 (x86-64-v4), 1 = AVX2 (x86-64-v3), 0 = baseline.
+// Called from ifunc resolvers, before any constructor has run.
+int hulk_cpu_level(void);
+
+// Runtime string: length-prefixed, reference counted, with an inline buffer
+// for short strings. `data` always points at a NUL-terminated buffer (either
+// `inline_buf` or a separate heap block), so it can be handed to C APIs.
+// The compiler emits literals with this same layout and a negative refcount,
+// which marks them immortal: retain/release ignore them.
+#define HULK_STRING_INLINE_CAPACITY 23
+
+typedef struct HulkString {
+    int64_t refcount;
+    int64_t length;
+    char* data;
+    char inline_buf[HULK_STRING_INLINE_CAPACITY + 1];
+} HulkString;
+
+// String lifetime
+HulkString* hulk_string_new(const char* data, size_t length);
+HulkString* hulk_string_from_cstr(const char* str);
+HulkString* hulk_string_retain(HulkString* str);
+void hulk_string_release(HulkString* str);
+size_t hulk_string_length(const HulkString* str);
+const char* hulk_string_data(const HulkString* str);
+
 // String operations
-char* hulk_string_concat(const char* a, const char* b);
-char* hulk_string_triple_concat(const char* a, const char* b, const char* c);
-char* hulk_string_repeat(const char* str, int times);
-int hulk_string_equal(const char* a, const char* b);
+HulkString* hulk_string_concat(const HulkString* a, const HulkString* b);
+HulkString* hulk_string_concat_space(const HulkString* a, const HulkString* b);
+HulkString* hulk_string_concat_n(const HulkString* const* parts, int64_t count);
+HulkString* hulk_string_triple_concat(const HulkString* a, const HulkString* b, const HulkString* c);
+HulkString* hulk_string_repeat(const HulkString* str, int times);
+int hulk_string_equal(const HulkString* a, const HulkString* b);
 
 // Enhanced arithmetic operations
 double hulk_integer_div(double a, double b);
 double hulk_enhanced_mod(double a, double b);
-char* hulk_triple_add(const char* a, const char* b, const char* c);
+HulkString* hulk_triple_add(const HulkString* a, const HulkString* b, const HulkString* c);
 
 // Logical operations
 int hulk_logical_and(int a, int b);
@@ -23,8 +120,46 @@ int hulk_logical_not(int a);
 
 // Built-in functions
 void hulk_debug(const char* format, ...);
-char* hulk_type_of(const char* type_name);
-void hulk_assert(int condition, const char* message);
+HulkString* hulk_type_of(const char* type_name);
+void hulk_assert(int condition, const HulkString* message);
+
+// String conversion functions (str built-in)
+HulkString* hulk_str_number(double value);
+HulkString* hulk_str_string(HulkString* str);
+HulkString* hulk_str_boolean(int value);
+HulkString* hulk_double_to_str(double value);
+HulkString* hulk_bool_to_str(int value);
+
+// Dynamic values: compiled code boxes a value whose static type is unknown
+// into a 16-byte tag + payload pair. The helpers below take it as its two
+// words, which is also how the C ABI passes a HulkValue by value.
+enum {
+    HULK_VALUE_NUMBER = 0,
+    HULK_VALUE_BOOLEAN = 1,
+    HULK_VALUE_STRING = 2,
+    HULK_VALUE_OBJECT = 3
+};
+
+typedef struct HulkValue {
+    int64_t tag;
+    union {
+        double number;
+        int64_t boolean;
+        HulkString* string;
+        void* object;
+    } as;
+} HulkValue;
+
+// Tag of an untyped pointer: objects live on the collected heap, anything else is a string
+int64_t hulk_value_pointer_tag(const void* pointer);
+double hulk_value_to_number(int64_t tag, int64_t payload);
+int32_t hulk_value_truthy(int64_t tag, int64_t payload);
+HulkString* hulk_value_to_string(int64_t tag, int64_t payload); // new reference
+void* hulk_value_to_pointer(int64_t tag, int64_t payload);       // strings and objects as is
+void hulk_value_print(int64_t tag, int64_t payload);
+int32_t hulk_value_equal(int64_t a_tag, int64_t a_payload, int64_t b_tag, int64_t b_payload);
+// Reports an operation that does not apply to the dynamic type and exits
+void hulk_dynamic_error(const char* message);
 
 // Standard math functions
 double hulk_sin(double x);
@@ -34,12 +169,21 @@ double hulk_log(double x);
 double hulk_exp(double x);
 double hulk_pow(double x, double y);
 
+// Batched math: out[i] = f(in[i]) for i < count (buffers must not overlap).
+// Vectorized with libmvec when the runtime is built with -fopenmp-simd.
+void hulk_sin_batch(const double* in, double* out, int64_t count);
+void hulk_cos_batch(const double* in, double* out, int64_t count);
+void hulk_sqrt_batch(const double* in, double* out, int64_t count);
+void hulk_exp_batch(const double* in, double* out, int64_t count);
+void hulk_log_batch(const double* in, double* out, int64_t count);
+void hulk_pow_batch(const double* x, const double* y, double* out, int64_t count);
+
 // Memory management
-void hulk_free_string(char* str);
+void hulk_free_string(HulkString* str);
 
 // Print functions
 void hulk_print_number(double value);
-void hulk_print_string(const char* str);
+void hulk_print_string(const HulkString* str);
 void hulk_print_boolean(int value);
 void hulk_println();
 
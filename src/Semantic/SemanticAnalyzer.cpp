@@ -1,5 +1,7 @@
 #include "SemanticAnalyzer.hpp"
 #include <algorithm>
+#include <cmath>
+#include <functional>
 #include <sstream>
 #include <set>
 
@@ -26,6 +28,21 @@ void SemanticAnalyzer::registerBuiltinFunctions() {
     // String functions
     symbol_table_.declareFunction("parse", {"s"});
     symbol_table_.declareFunction("str", {"x"});  // Agregar str para conversión
+    
+    // Iteration: for (x in e) is parsed into iter(e), next(__iter) and current(__iter)
+    symbol_table_.declareFunction("range", {"min", "max"});
+    symbol_table_.declareFunction("iter", {"x"});
+    symbol_table_.declareFunction("next", {"it"});
+    symbol_table_.declareFunction("current", {"it"});
+    
+    // Tipos de retorno conocidos, para la inferencia de firmas y atributos
+    for (const char* name : {"sqrt", "sin", "cos", "exp", "log", "pow", "rand", "floor", "ceil", "PI", "E", "parse"}) {
+        symbol_table_.lookupFunction(name)->return_type = TypeInfo(TypeInfo::Kind::Number);
+    }
+    symbol_table_.lookupFunction("str")->return_type = TypeInfo(TypeInfo::Kind::String);
+    // Ranges are the only enumerables, so their elements are numbers
+    symbol_table_.lookupFunction("current")->return_type = TypeInfo(TypeInfo::Kind::Number);
+    symbol_table_.lookupFunction("next")->return_type = TypeInfo(TypeInfo::Kind::Boolean);
 }
 
 void SemanticAnalyzer::collectFunctions(Program* program) {
@@ -38,6 +55,7 @@ void SemanticAnalyzer::collectFunctions(Program* program) {
                     "declaración de función", "SemanticAnalyzer");
             } else {
                 symbol_table_.declareFunction(funcDecl->name, funcDecl->params);
+                function_decls_[funcDecl->name] = funcDecl;
             }
         } else if (auto typeDecl = dynamic_cast<TypeDecl*>(stmt.get())) {
             if (symbol_table_.isTypeDeclared(typeDecl->name)) {
@@ -46,6 +64,7 @@ void SemanticAnalyzer::collectFunctions(Program* program) {
                     typeDecl->line_number, typeDecl->column_number,
                     "declaración de tipo", "SemanticAnalyzer");            } else {
                 symbol_table_.declareType(typeDecl->name);
+                type_decls_[typeDecl->name] = typeDecl;
                 
                 // Register inheritance relationship if present
                 if (!typeDecl->parentType.empty()) {
@@ -168,6 +187,13 @@ void SemanticAnalyzer::visit(BinaryExpr* expr) {
             current_type_ = TypeInfo(TypeInfo::Kind::String);
             break;
             
+        case BinaryExpr::OP_TRIPLE_PLUS:
+            // Suma doble entre números; con cualquier otro operando, concatenación triple
+            current_type_ = TypeInfo(left_type.getKind() == TypeInfo::Kind::Number &&
+                                     right_type.getKind() == TypeInfo::Kind::Number
+                                         ? TypeInfo::Kind::Number : TypeInfo::Kind::String);
+            break;
+            
         case BinaryExpr::OP_LT:
         case BinaryExpr::OP_GT:
         case BinaryExpr::OP_LE:        case BinaryExpr::OP_GE:
@@ -239,15 +265,21 @@ void SemanticAnalyzer::visit(CallExpr* expr) {
         // Could add more specific type checking here
     }
     
-    // For mathematical functions, assume they return numbers
-    // This is a simplification for recursive mathematical functions
-    if (expr->callee == "fact" || expr->callee == "fib" || 
+    // User functions return what inferFunctionSignatures found; for the
+    // mathematical built-ins, assume they return numbers
+    if (function_decls_.count(expr->callee)) {
+        current_type_ = getFunctionReturnType(expr->callee);
+    } else if (expr->callee == "fact" || expr->callee == "fib" || 
         expr->callee == "sum" || expr->callee == "power" ||
         expr->callee == "sqrt" || expr->callee == "sin" || expr->callee == "cos" ||
         expr->callee == "exp" || expr->callee == "log" || expr->callee == "pow") {
         current_type_ = TypeInfo(TypeInfo::Kind::Number);
     } else if (expr->callee == "print" || expr->callee == "println") {
         current_type_ = TypeInfo(TypeInfo::Kind::Unknown); // print doesn't return meaningful value
+    } else if (expr->callee == "next") {
+        current_type_ = TypeInfo(TypeInfo::Kind::Boolean);
+    } else if (expr->callee == "range" || expr->callee == "iter") {
+        current_type_ = TypeInfo(TypeInfo::Kind::Unknown); // ranges and iterators are not first-class in codegen
     } else {
         // For user-defined functions, assume they return numbers for now
         current_type_ = TypeInfo(TypeInfo::Kind::Number);
@@ -276,7 +308,8 @@ void SemanticAnalyzer::visit(LetExpr* expr) {
     symbol_table_.enterScope();
     
     // Declare the variable with the type from the initializer
-    if (symbol_table_.isVariableDeclared(expr->name)) {
+    // (nested for loops each bind their own __iter, see the parser)
+    if (expr->name != "__iter" && symbol_table_.isVariableDeclared(expr->name)) {
         reportError(ErrorType::REDEFINED_VARIABLE,
             "Variable '" + expr->name + "' ya está definida en este ámbito",
             expr, "expresión let");
@@ -392,7 +425,7 @@ void SemanticAnalyzer::visit(NewExpr* expr) {
         return;
     }
     
-    // Analyze constructor arguments
+    // Analyze constructor arguments (their types were collected by inferFunctionSignatures)
     for (auto& arg : expr->args) {
         arg->accept(this);
     }
@@ -462,8 +495,13 @@ void SemanticAnalyzer::visit(MethodCallExpr* expr) {
         arg->accept(this);
     }
     
-    // For known method names, try to infer return type
-    if (expr->method == "f") {
+    // Result types inferred from the method bodies when the receiver's type is known
+    TypeInfo inferred = obj_type.getKind() == TypeInfo::Kind::Object
+                            ? getMethodReturnType(obj_type.getTypeName(), expr->method)
+                            : TypeInfo(TypeInfo::Kind::Unknown);
+    if (!inferred.isUnknown()) {
+        current_type_ = inferred;
+    } else if (expr->method == "f") {
         // Method 'f' typically returns a string in this context
         current_type_ = TypeInfo(TypeInfo::Kind::String);
     } else {
@@ -481,7 +519,8 @@ void SemanticAnalyzer::visit(FunctionDecl* stmt) {
     symbol_table_.enterScope();
       // Add parameters to current scope with inferred types
     // For recursive functions, assume numeric types for mathematical operations
-    for (const auto& param : stmt->params) {
+    for (size_t i = 0; i < stmt->params.size(); ++i) {
+        const std::string& param = stmt->params[i];
         // Check if parameter name is a reserved word
         if (isReservedWord(param)) {
             reportError(ErrorType::INVALID_OPERATION,
@@ -494,8 +533,8 @@ void SemanticAnalyzer::visit(FunctionDecl* stmt) {
                 "Parámetro '" + param + "' está duplicado",
                 stmt, "declaración de función");
         } else {
-            // Assume numeric types for mathematical functions
-            symbol_table_.declareVariable(param, TypeInfo(TypeInfo::Kind::Number));
+            // Types inferred from the call sites (Number when no call reaches the parameter)
+            symbol_table_.declareVariable(param, getFunctionParameterType(stmt->name, i));
         }
     }
     
@@ -507,7 +546,7 @@ void SemanticAnalyzer::visit(FunctionDecl* stmt) {
 
 void SemanticAnalyzer::visit(TypeDecl* stmt) {
     // Type declarations would need more complex analysis
-    // For now, just mark that we've seen this type
+    // (the type itself is registered by collectFunctions)
     symbol_table_.enterScope();
     
     // Process type parameters, inheritance, methods, etc.
@@ -628,3 +667,577 @@ bool SemanticAnalyzer::isReservedWord(const std::string& word) {
         "protocol", "extends", "class", "method", "attribute"
     };    return reserved_words.find(word) != reserved_words.end();
 }
+
+
+bool SemanticAnalyzer::joinArgumentType(std::vector<std::optional<TypeInfo>>& seen, size_t index, const TypeInfo& type) {
+    if (seen.size() <= index) {
+        seen.resize(index + 1);
+    }
+    if (!seen[index]) {
+        seen[index] = type;
+        return true;
+    }
+    
+    const TypeInfo& previous = *seen[index];
+    if (previous.getKind() == type.getKind() && previous.getTypeName() == type.getTypeName()) {
+        return false;
+    }
+    // Different object types still share a pointer-sized layout
+    if (previous.isObject() && type.isObject()) {
+        std::string ancestor = findCommonAncestor(previous.getTypeName(), type.getTypeName());
+        if (ancestor == previous.getTypeName()) {
+            return false;
+        }
+        seen[index] = TypeInfo(TypeInfo::Kind::Object, ancestor);
+        return true;
+    }
+    if (previous.isUnknown()) {
+        return false;
+    }
+    seen[index] = TypeInfo(TypeInfo::Kind::Unknown);
+    return true;
+}
+
+TypeInfo SemanticAnalyzer::inferInitializerType(Expr* expr, std::map<std::string, TypeInfo>& params) {
+    if (!expr) {
+        return TypeInfo(TypeInfo::Kind::Unknown);
+    }
+    if (dynamic_cast<NumberExpr*>(expr)) {
+        return TypeInfo(TypeInfo::Kind::Number);
+    }
+    if (dynamic_cast<StringExpr*>(expr)) {
+        return TypeInfo(TypeInfo::Kind::String);
+    }
+    if (dynamic_cast<BooleanExpr*>(expr)) {
+        return TypeInfo(TypeInfo::Kind::Boolean);
+    }
+    if (auto* var = dynamic_cast<VariableExpr*>(expr)) {
+        auto it = params.find(var->name);
+        return it != params.end() ? it->second : TypeInfo(TypeInfo::Kind::Unknown);
+    }
+    if (auto* unary = dynamic_cast<UnaryExpr*>(expr)) {
+        return TypeInfo(unary->op == UnaryExpr::OP_NOT ? TypeInfo::Kind::Boolean : TypeInfo::Kind::Number);
+    }
+    if (auto* binary = dynamic_cast<BinaryExpr*>(expr)) {
+        switch (binary->op) {
+            case BinaryExpr::OP_CONCAT:
+            case BinaryExpr::OP_CONCAT_SPACE:
+                return TypeInfo(TypeInfo::Kind::String);
+            case BinaryExpr::OP_TRIPLE_PLUS:
+                return TypeInfo(inferInitializerType(binary->left.get(), params).getKind() == TypeInfo::Kind::Number &&
+                                inferInitializerType(binary->right.get(), params).getKind() == TypeInfo::Kind::Number
+                                    ? TypeInfo::Kind::Number : TypeInfo::Kind::String);
+            case BinaryExpr::OP_LT:
+            case BinaryExpr::OP_GT:
+            case BinaryExpr::OP_LE:
+            case BinaryExpr::OP_GE:
+            case BinaryExpr::OP_EQ:
+            case BinaryExpr::OP_NEQ:
+            case BinaryExpr::OP_OR:
+            case BinaryExpr::OP_AND:
+            case BinaryExpr::OP_AND_SIMPLE:
+            case BinaryExpr::OP_OR_SIMPLE:
+                return TypeInfo(TypeInfo::Kind::Boolean);
+            default:
+                return TypeInfo(TypeInfo::Kind::Number);
+        }
+    }
+    if (auto* call = dynamic_cast<CallExpr*>(expr)) {
+        auto function = symbol_table_.lookupFunction(call->callee);
+        return function ? function->return_type : TypeInfo(TypeInfo::Kind::Unknown);
+    }
+    if (auto* new_expr = dynamic_cast<NewExpr*>(expr)) {
+        return TypeInfo(TypeInfo::Kind::Object, new_expr->typeName);
+    }
+    if (auto* if_expr = dynamic_cast<IfExpr*>(expr)) {
+        TypeInfo then_type = inferInitializerType(if_expr->thenBranch.get(), params);
+        TypeInfo else_type = inferInitializerType(if_expr->elseBranch.get(), params);
+        if (then_type.getKind() == else_type.getKind() && then_type.getTypeName() == else_type.getTypeName()) {
+            return then_type;
+        }
+        return TypeInfo(TypeInfo::Kind::Unknown);
+    }
+    if (auto* let_expr = dynamic_cast<LetExpr*>(expr)) {
+        auto* body = dynamic_cast<ExprStmt*>(let_expr->body.get());
+        if (!body) {
+            return TypeInfo(TypeInfo::Kind::Unknown);
+        }
+        std::map<std::string, TypeInfo> scope = params;
+        scope[let_expr->name] = inferLetVariableType(let_expr, params);
+        return inferInitializerType(body->expr.get(), scope);
+    }
+    if (auto* block = dynamic_cast<ExprBlock*>(expr)) {
+        auto* last = block->stmts.empty() ? nullptr : dynamic_cast<ExprStmt*>(block->stmts.back().get());
+        return last ? inferInitializerType(last->expr.get(), params) : TypeInfo(TypeInfo::Kind::Unknown);
+    }
+    return TypeInfo(TypeInfo::Kind::Unknown);
+}
+
+void SemanticAnalyzer::inferAttributeTypes() {
+    auto parameter_types = [this](TypeDecl* decl) {
+        std::map<std::string, TypeInfo> params;
+        const auto& seen = constructor_arg_types_[decl->name];
+        for (size_t i = 0; i < decl->params.size(); ++i) {
+            params[decl->params[i]] = i < seen.size() && seen[i] ? *seen[i] : TypeInfo(TypeInfo::Kind::Unknown);
+        }
+        return params;
+    };
+    
+    // Arguments flow to the parent constructor through `inherits P(args)`, or
+    // unchanged when the subtype declares no parameters; iterate until stable
+    bool changed = true;
+    for (size_t round = 0; changed && round <= type_decls_.size(); ++round) {
+        changed = false;
+        for (const auto& [name, decl] : type_decls_) {
+            if (decl->parentType.empty() || type_decls_.find(decl->parentType) == type_decls_.end()) {
+                continue;
+            }
+            if (!decl->parentArgs.empty()) {
+                std::map<std::string, TypeInfo> params = parameter_types(decl);
+                for (size_t i = 0; i < decl->parentArgs.size(); ++i) {
+                    changed |= joinArgumentType(constructor_arg_types_[decl->parentType], i,
+                                                inferInitializerType(decl->parentArgs[i].get(), params));
+                }
+            } else if (decl->params.empty()) {
+                std::vector<std::optional<TypeInfo>> seen = constructor_arg_types_[name];
+                for (size_t i = 0; i < seen.size(); ++i) {
+                    if (seen[i]) changed |= joinArgumentType(constructor_arg_types_[decl->parentType], i, *seen[i]);
+                }
+            }
+        }
+    }
+    
+    for (const auto& [name, decl] : type_decls_) {
+        std::map<std::string, TypeInfo> params = parameter_types(decl);
+        auto& attributes = attribute_types_[name];
+        for (const auto& [attribute, initializer] : decl->attributes) {
+            attributes[attribute] = inferInitializerType(initializer, params);
+        }
+    }
+}
+
+TypeInfo SemanticAnalyzer::getAttributeType(const std::string& type_name, const std::string& attribute) const {
+    auto type = attribute_types_.find(type_name);
+    if (type != attribute_types_.end()) {
+        auto found = type->second.find(attribute);
+        if (found != type->second.end()) {
+            return found->second;
+        }
+    }
+    return TypeInfo(TypeInfo::Kind::Unknown);
+}
+TypeInfo SemanticAnalyzer::getConstructorParameterType(const std::string& type_name, size_t index) const {
+    auto type = constructor_arg_types_.find(type_name);
+    if (type == constructor_arg_types_.end() || index >= type->second.size() || !type->second[index]) {
+        return TypeInfo(TypeInfo::Kind::Unknown);
+    }
+    return *type->second[index];
+}
+
+namespace {
+
+// Direct subexpressions of `expr`, in evaluation order
+void forEachSubexpression(Expr* expr, const std::function<void(Expr*)>& fn) {
+    auto statement = [&](Stmt* stmt) {
+        if (auto* expr_stmt = dynamic_cast<ExprStmt*>(stmt)) fn(expr_stmt->expr.get());
+    };
+    if (auto* unary = dynamic_cast<UnaryExpr*>(expr)) {
+        fn(unary->operand.get());
+    } else if (auto* binary = dynamic_cast<BinaryExpr*>(expr)) {
+        fn(binary->left.get());
+        fn(binary->right.get());
+    } else if (auto* call = dynamic_cast<CallExpr*>(expr)) {
+        for (auto& arg : call->args) fn(arg.get());
+    } else if (auto* let_expr = dynamic_cast<LetExpr*>(expr)) {
+        fn(let_expr->initializer.get());
+        statement(let_expr->body.get());
+    } else if (auto* assign = dynamic_cast<AssignExpr*>(expr)) {
+        fn(assign->value.get());
+    } else if (auto* if_expr = dynamic_cast<IfExpr*>(expr)) {
+        fn(if_expr->condition.get());
+        fn(if_expr->thenBranch.get());
+        if (if_expr->elseBranch) fn(if_expr->elseBranch.get());
+    } else if (auto* block = dynamic_cast<ExprBlock*>(expr)) {
+        for (auto& stmt : block->stmts) statement(stmt.get());
+    } else if (auto* loop = dynamic_cast<WhileExpr*>(expr)) {
+        fn(loop->condition.get());
+        fn(loop->body.get());
+    } else if (auto* new_expr = dynamic_cast<NewExpr*>(expr)) {
+        for (auto& arg : new_expr->args) fn(arg.get());
+    } else if (auto* member = dynamic_cast<MemberExpr*>(expr)) {
+        fn(member->object.get());
+    } else if (auto* member_assign = dynamic_cast<MemberAssignExpr*>(expr)) {
+        fn(member_assign->object.get());
+        fn(member_assign->value.get());
+    } else if (auto* method_call = dynamic_cast<MethodCallExpr*>(expr)) {
+        fn(method_call->object.get());
+        for (auto& arg : method_call->args) fn(arg.get());
+    }
+}
+
+// Expressions of a function body; the last one is the result
+std::vector<Expr*> bodyExpressions(Stmt* body) {
+    std::vector<Expr*> exprs;
+    if (auto* expr_stmt = dynamic_cast<ExprStmt*>(body)) {
+        exprs.push_back(expr_stmt->expr.get());
+    } else if (auto* block = dynamic_cast<Program*>(body)) {
+        for (auto& stmt : block->stmts) {
+            if (auto* inner = dynamic_cast<ExprStmt*>(stmt.get())) exprs.push_back(inner->expr.get());
+        }
+    }
+    return exprs;
+}
+
+bool sameType(const TypeInfo& a, const TypeInfo& b) {
+    return a.getKind() == b.getKind() && a.getTypeName() == b.getTypeName();
+}
+
+// Integer counters start (or restart) at literals below 2^40 and move by literal
+// steps of at most 2^10, so they need over 2^42 updates to leave the range
+// where doubles are exact (2^53): as i64 they compute the very same values
+constexpr double kMaxCounterStart = 1099511627776.0;
+constexpr double kMaxCounterStep = 1024.0;
+
+// Integral number literal no larger than `limit` in magnitude (negated literals included)
+bool isIntegralLiteral(Expr* expr, double limit) {
+    auto* unary = dynamic_cast<UnaryExpr*>(expr);
+    if (unary && unary->op == UnaryExpr::OP_NEG) {
+        expr = unary->operand.get();
+    }
+    auto* number = dynamic_cast<NumberExpr*>(expr);
+    return number && std::floor(number->value) == number->value && std::fabs(number->value) <= limit;
+}
+
+// `name := value` keeps `name` an integer counter: a literal, or `name` plus or minus a literal step
+bool isCounterUpdate(Expr* value, const std::string& name) {
+    if (isIntegralLiteral(value, kMaxCounterStart)) {
+        return true;
+    }
+    auto* binary = dynamic_cast<BinaryExpr*>(value);
+    if (!binary || (binary->op != BinaryExpr::OP_ADD && binary->op != BinaryExpr::OP_SUB)) {
+        return false;
+    }
+    auto is_counter = [&](Expr* operand) {
+        auto* variable = dynamic_cast<VariableExpr*>(operand);
+        return variable && variable->name == name;
+    };
+    return (is_counter(binary->left.get()) && isIntegralLiteral(binary->right.get(), kMaxCounterStep)) ||
+           (binary->op == BinaryExpr::OP_ADD && is_counter(binary->right.get()) &&
+            isIntegralLiteral(binary->left.get(), kMaxCounterStep));
+}
+
+// True if every assignment to `name` in `expr` (outside lets that shadow it) is a counter update
+bool onlyCounterUpdates(Expr* expr, const std::string& name) {
+    if (!expr) {
+        return true;
+    }
+    if (auto* let_expr = dynamic_cast<LetExpr*>(expr); let_expr && let_expr->name == name) {
+        return onlyCounterUpdates(let_expr->initializer.get(), name);
+    }
+    if (auto* assign = dynamic_cast<AssignExpr*>(expr); assign && assign->name == name &&
+                                                        !isCounterUpdate(assign->value.get(), name)) {
+        return false;
+    }
+    bool only_counter_updates = true;
+    forEachSubexpression(expr, [&](Expr* child) {
+        only_counter_updates = only_counter_updates && onlyCounterUpdates(child, name);
+    });
+    return only_counter_updates;
+}
+
+} // namespace
+
+TypeInfo SemanticAnalyzer::inferLetVariableType(LetExpr* let_expr, std::map<std::string, TypeInfo>& params) {
+    TypeInfo type = inferInitializerType(let_expr->initializer.get(), params);
+    
+    // Assignments in the body may give the variable another type
+    std::map<std::string, TypeInfo> scope = params;
+    scope[let_expr->name] = type;
+    std::function<void(Expr*)> visit_assignments = [&](Expr* expr) {
+        if (type.isUnknown() || !expr) return;
+        auto* assign = dynamic_cast<AssignExpr*>(expr);
+        if (assign && assign->name == let_expr->name &&
+            !sameType(inferInitializerType(assign->value.get(), scope), type)) {
+            type = TypeInfo(TypeInfo::Kind::Unknown);
+            return;
+        }
+        forEachSubexpression(expr, visit_assignments);
+    };
+    if (auto* body = dynamic_cast<ExprStmt*>(let_expr->body.get())) {
+        visit_assignments(body->expr.get());
+    }
+    return type;
+}
+
+void SemanticAnalyzer::forEachScopedExpression(Expr* expr, std::map<std::string, TypeInfo>& scope,
+                                               const ScopedExpressionFn& fn) {
+    if (!expr) {
+        return;
+    }
+    fn(expr, scope);
+    if (auto* let_expr = dynamic_cast<LetExpr*>(expr)) {
+        forEachScopedExpression(let_expr->initializer.get(), scope, fn);
+        std::map<std::string, TypeInfo> inner = scope;
+        inner[let_expr->name] = inferLetVariableType(let_expr, scope);
+        if (auto* body = dynamic_cast<ExprStmt*>(let_expr->body.get())) {
+            forEachScopedExpression(body->expr.get(), inner, fn);
+        }
+        return;
+    }
+    forEachSubexpression(expr, [&](Expr* child) { forEachScopedExpression(child, scope, fn); });
+}
+
+bool SemanticAnalyzer::collectCallArgumentTypes(Expr* expr, std::map<std::string, TypeInfo>& scope) {
+    bool changed = false;
+    forEachScopedExpression(expr, scope, [&](Expr* current, std::map<std::string, TypeInfo>& current_scope) {
+        if (auto* call = dynamic_cast<CallExpr*>(current)) {
+            if (function_decls_.count(call->callee)) {
+                for (size_t i = 0; i < call->args.size(); ++i) {
+                    changed |= joinArgumentType(function_arg_types_[call->callee], i,
+                                                inferInitializerType(call->args[i].get(), current_scope));
+                }
+            }
+        }
+        if (auto* new_expr = dynamic_cast<NewExpr*>(current)) {
+            // Constructor arguments decide the attribute layout (see inferAttributeTypes)
+            if (type_decls_.count(new_expr->typeName)) {
+                for (size_t i = 0; i < new_expr->args.size(); ++i) {
+                    changed |= joinArgumentType(constructor_arg_types_[new_expr->typeName], i,
+                                                inferInitializerType(new_expr->args[i].get(), current_scope));
+                }
+            }
+        }
+        if (auto* method_call = dynamic_cast<MethodCallExpr*>(current)) {
+            // El receptor no se conoce: se agrupan todas las llamadas por nombre de método,
+            // y solo cuentan los argumentos de tipo conocido
+            for (size_t i = 0; i < method_call->args.size(); ++i) {
+                TypeInfo arg_type = inferInitializerType(method_call->args[i].get(), current_scope);
+                if (!arg_type.isUnknown()) {
+                    changed |= joinArgumentType(method_arg_types_[method_call->method], i, arg_type);
+                }
+            }
+        }
+    });
+    return changed;
+}
+
+void SemanticAnalyzer::inferFunctionSignatures(Program* program) {
+    auto parameter_types = [this](FunctionDecl* decl) {
+        std::map<std::string, TypeInfo> params;
+        const auto& seen = function_arg_types_[decl->name];
+        for (size_t i = 0; i < decl->params.size(); ++i) {
+            // A parameter no call reaches keeps the analyzer's Number assumption
+            params[decl->params[i]] = i < seen.size() && seen[i] ? *seen[i] : TypeInfo(TypeInfo::Kind::Number);
+        }
+        return params;
+    };
+    
+    // Optimistic start (every result a Number, as the checking pass assumes),
+    // refined until the argument and result types stop changing
+    for (const auto& [name, decl] : function_decls_) {
+        symbol_table_.lookupFunction(name)->return_type = TypeInfo(TypeInfo::Kind::Number);
+    }
+    bool changed = true;
+    for (size_t round = 0; changed; ++round) {
+        changed = false;
+        for (auto& stmt : program->stmts) {
+            std::map<std::string, TypeInfo> scope;
+            if (auto* function = dynamic_cast<FunctionDecl*>(stmt.get())) {
+                scope = parameter_types(function);
+                for (Expr* expr : bodyExpressions(function->body.get())) {
+                    changed |= collectCallArgumentTypes(expr, scope);
+                }
+            } else if (auto* type = dynamic_cast<TypeDecl*>(stmt.get())) {
+                for (auto& arg : type->parentArgs) changed |= collectCallArgumentTypes(arg.get(), scope);
+                for (auto& attribute : type->attributes) changed |= collectCallArgumentTypes(attribute.second, scope);
+                for (auto& body : type->methodBodies) changed |= collectCallArgumentTypes(body.get(), scope);
+            } else if (auto* expr_stmt = dynamic_cast<ExprStmt*>(stmt.get())) {
+                changed |= collectCallArgumentTypes(expr_stmt->expr.get(), scope);
+            }
+        }
+        
+        for (const auto& [name, decl] : function_decls_) {
+            std::map<std::string, TypeInfo> scope = parameter_types(decl);
+            std::vector<Expr*> exprs = bodyExpressions(decl->body.get());
+            TypeInfo result = exprs.empty() ? TypeInfo(TypeInfo::Kind::Unknown)
+                                            : inferInitializerType(exprs.back(), scope);
+            TypeInfo& previous = symbol_table_.lookupFunction(name)->return_type;
+            // Past a few rounds anything still changing is given up on
+            bool give_up = round >= function_decls_.size() + 2;
+            if (give_up && previous.isUnknown()) {
+                continue;
+            }
+            if (!sameType(result, previous)) {
+                previous = give_up ? TypeInfo(TypeInfo::Kind::Unknown) : result;
+                changed = true;
+            }
+        }
+    }
+    
+    for (const auto& [name, decl] : function_decls_) {
+        auto function = symbol_table_.lookupFunction(name);
+        std::map<std::string, TypeInfo> params = parameter_types(decl);
+        function->parameter_types.clear();
+        for (const auto& param : decl->params) {
+            function->parameter_types.push_back(params[param]);
+        }
+    }
+}
+
+TypeInfo SemanticAnalyzer::getFunctionReturnType(const std::string& name) const {
+    auto function = symbol_table_.lookupFunction(name);
+    return function ? function->return_type : TypeInfo(TypeInfo::Kind::Unknown);
+}
+
+void SemanticAnalyzer::inferFunctionSpecializations(Program* program) {
+    // Shape of a call: Numbers and Booleans are passed unboxed, anything else as a
+    // dynamic value (Unknown). Where the generic version takes a Number the call converts.
+    std::vector<std::pair<std::string, std::vector<TypeInfo>>> pending;
+    auto collect = [&](Expr* expr, std::map<std::string, TypeInfo>& scope) {
+        forEachScopedExpression(expr, scope, [&](Expr* current, std::map<std::string, TypeInfo>& current_scope) {
+            auto* call = dynamic_cast<CallExpr*>(current);
+            auto decl = call ? function_decls_.find(call->callee) : function_decls_.end();
+            if (decl == function_decls_.end() || call->args.size() != decl->second->params.size()) {
+                return;
+            }
+            std::vector<TypeInfo> shape;
+            for (size_t i = 0; i < call->args.size(); ++i) {
+                TypeInfo::Kind kind = inferInitializerType(call->args[i].get(), current_scope).getKind();
+                if (getFunctionParameterType(call->callee, i).getKind() == TypeInfo::Kind::Number ||
+                    kind == TypeInfo::Kind::Number) {
+                    shape.emplace_back(TypeInfo::Kind::Number);
+                } else {
+                    shape.emplace_back(kind == TypeInfo::Kind::Boolean ? kind : TypeInfo::Kind::Unknown);
+                }
+            }
+            pending.emplace_back(call->callee, std::move(shape));
+        });
+    };
+    
+    // Calls made from generic code
+    for (auto& stmt : program->stmts) {
+        std::map<std::string, TypeInfo> scope;
+        if (auto* function = dynamic_cast<FunctionDecl*>(stmt.get())) {
+            for (size_t i = 0; i < function->params.size(); ++i) {
+                scope[function->params[i]] = getFunctionParameterType(function->name, i);
+            }
+            for (Expr* expr : bodyExpressions(function->body.get())) collect(expr, scope);
+        } else if (auto* type = dynamic_cast<TypeDecl*>(stmt.get())) {
+            for (auto& arg : type->parentArgs) collect(arg.get(), scope);
+            for (auto& attribute : type->attributes) collect(attribute.second, scope);
+            for (auto& body : type->methodBodies) collect(body.get(), scope);
+        } else if (auto* expr_stmt = dynamic_cast<ExprStmt*>(stmt.get())) {
+            collect(expr_stmt->expr.get(), scope);
+        }
+    }
+    
+    // Each new specialization is walked with its own types, which may ask for others
+    while (!pending.empty()) {
+        auto [name, shape] = std::move(pending.back());
+        pending.pop_back();
+        bool generic = true;
+        for (size_t i = 0; i < shape.size(); ++i) {
+            bool generic_number = getFunctionParameterType(name, i).getKind() == TypeInfo::Kind::Number;
+            generic = generic && (generic_number || shape[i].isUnknown());
+        }
+        auto& specializations = function_specializations_[name];
+        bool known = std::any_of(specializations.begin(), specializations.end(), [&](const FunctionSpecialization& s) {
+            return std::equal(s.parameter_types.begin(), s.parameter_types.end(), shape.begin(), sameType);
+        });
+        if (generic || known || specializations.size() >= kMaxSpecializations) {
+            continue;
+        }
+        
+        FunctionDecl* decl = function_decls_[name];
+        std::map<std::string, TypeInfo> scope;
+        for (size_t i = 0; i < shape.size(); ++i) {
+            scope[decl->params[i]] = shape[i];
+        }
+        std::vector<Expr*> exprs = bodyExpressions(decl->body.get());
+        TypeInfo result = exprs.empty() ? TypeInfo(TypeInfo::Kind::Unknown) : inferInitializerType(exprs.back(), scope);
+        specializations.push_back(FunctionSpecialization{shape, result});
+        for (Expr* expr : exprs) collect(expr, scope);
+    }
+}
+
+const std::vector<SemanticAnalyzer::FunctionSpecialization>&
+SemanticAnalyzer::getFunctionSpecializations(const std::string& name) const {
+    static const std::vector<FunctionSpecialization> none;
+    auto it = function_specializations_.find(name);
+    return it != function_specializations_.end() ? it->second : none;
+}
+
+void SemanticAnalyzer::inferMethodReturnTypes() {
+    for (const auto& [type_name, decl] : type_decls_) {
+        for (size_t i = 0; i < decl->methods.size() && i < decl->methodBodies.size(); ++i) {
+            const auto& [method_name, params] = decl->methods[i];
+            std::map<std::string, TypeInfo> scope;
+            for (size_t p = 0; p < params.size(); ++p) {
+                std::optional<TypeInfo> seen = getMethodParameterType(method_name, p);
+                scope[params[p]] = seen ? *seen : TypeInfo(TypeInfo::Kind::Unknown);
+            }
+            TypeInfo result = inferInitializerType(decl->methodBodies[i].get(), scope);
+            if (!result.isUnknown()) {
+                method_return_types_[type_name][method_name] = result;
+            }
+        }
+    }
+}
+
+void SemanticAnalyzer::inferIntegerVariables(Program* program) {
+    std::function<void(Expr*)> visit_expr = [&](Expr* expr) {
+        if (!expr) {
+            return;
+        }
+        if (auto* let_expr = dynamic_cast<LetExpr*>(expr)) {
+            auto* body = dynamic_cast<ExprStmt*>(let_expr->body.get());
+            if (body && isIntegralLiteral(let_expr->initializer.get(), kMaxCounterStart) &&
+                onlyCounterUpdates(body->expr.get(), let_expr->name)) {
+                integer_variables_.insert(let_expr);
+            }
+        }
+        forEachSubexpression(expr, visit_expr);
+    };
+    for (auto& stmt : program->stmts) {
+        if (auto* function = dynamic_cast<FunctionDecl*>(stmt.get())) {
+            for (Expr* expr : bodyExpressions(function->body.get())) visit_expr(expr);
+        } else if (auto* type = dynamic_cast<TypeDecl*>(stmt.get())) {
+            for (auto& arg : type->parentArgs) visit_expr(arg.get());
+            for (auto& attribute : type->attributes) visit_expr(attribute.second);
+            for (auto& body : type->methodBodies) visit_expr(body.get());
+        } else if (auto* expr_stmt = dynamic_cast<ExprStmt*>(stmt.get())) {
+            visit_expr(expr_stmt->expr.get());
+        }
+    }
+}
+
+bool SemanticAnalyzer::isIntegerVariable(const LetExpr* let_expr) const {
+    return integer_variables_.count(let_expr) > 0;
+}
+
+TypeInfo SemanticAnalyzer::getMethodReturnType(const std::string& type_name, const std::string& method) const {
+    auto type = method_return_types_.find(type_name);
+    if (type != method_return_types_.end()) {
+        auto found = type->second.find(method);
+        if (found != type->second.end()) {
+            return found->second;
+        }
+    }
+    return TypeInfo(TypeInfo::Kind::Unknown);
+}
+
+std::optional<TypeInfo> SemanticAnalyzer::getMethodParameterType(const std::string& method, size_t index) const {
+    auto it = method_arg_types_.find(method);
+    if (it == method_arg_types_.end() || index >= it->second.size()) {
+        return std::nullopt;
+    }
+    return it->second[index];
+}
+
+TypeInfo SemanticAnalyzer::getFunctionParameterType(const std::string& name, size_t index) const {
+    auto function = symbol_table_.lookupFunction(name);
+    if (!function || index >= function->parameter_types.size()) {
+        return TypeInfo(TypeInfo::Kind::Unknown);
+    }
+    return function->parameter_types[index];
+}
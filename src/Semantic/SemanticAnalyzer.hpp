@@ -5,6 +5,9 @@
 #include "TypeInfo.hpp"
 #include <vector>
 #include <iostream>
+#include <map>
+#include <functional>
+#include <optional>
 #include <unordered_set>
 
 /**
@@ -36,11 +39,27 @@ public:SemanticAnalyzer() : current_type_(TypeInfo::Kind::Unknown) {
             return;
         }
         
-        // First pass: collect function declarations
+        // First pass: collect function and type declarations
         collectFunctions(program);
         
-        // Second pass: analyze all expressions
+        // Second pass: parameter and result types of every function, and the
+        // constructor argument types, from their call and `new` sites
+        inferFunctionSignatures(program);
+        
+        // Third pass: specialized versions of functions, one per argument shape called
+        inferFunctionSpecializations(program);
+        
+        // Fourth pass: attribute types, from the constructor arguments seen
+        inferAttributeTypes();
+        
+        // Fifth pass: result types of the methods, from their bodies
+        inferMethodReturnTypes();
+        
+        // Sixth pass: analyze all expressions, with the types inferred above
         program->accept(this);
+        
+        // Seventh pass: let variables that only ever hold exact integers
+        inferIntegerVariables(program);
     }
     
     /**
@@ -76,6 +95,51 @@ public:SemanticAnalyzer() : current_type_(TypeInfo::Kind::Unknown) {
         return symbol_table_;
     }
     
+    /**
+     * @brief Inferred type of a type's own attribute (Unknown if it could not be inferred)
+     */
+    TypeInfo getAttributeType(const std::string& type_name, const std::string& attribute) const;
+    
+    /**
+     * @brief Type of the arguments passed for a type's constructor parameter,
+     * from its `new` sites and `inherits` clauses (Unknown if unseen or mixed)
+     */
+    TypeInfo getConstructorParameterType(const std::string& type_name, size_t index) const;
+    
+    /**
+     * @brief Inferred signature of a user function (Unknown = not statically known)
+     */
+    TypeInfo getFunctionReturnType(const std::string& name) const;
+    TypeInfo getFunctionParameterType(const std::string& name, size_t index) const;
+    
+    /**
+     * @brief A version of a function for one shape of arguments: Number and
+     * Boolean parameters are passed unboxed, Unknown ones as dynamic values
+     */
+    struct FunctionSpecialization {
+        std::vector<TypeInfo> parameter_types;
+        TypeInfo return_type;
+    };
+    static constexpr size_t kMaxSpecializations = 8; // per function
+    const std::vector<FunctionSpecialization>& getFunctionSpecializations(const std::string& name) const;
+    
+    /**
+     * @brief Type of the arguments passed to methods called `method` (nullopt if no call
+     * passes a known type; Unknown if the calls disagree)
+     */
+    std::optional<TypeInfo> getMethodParameterType(const std::string& method, size_t index) const;
+    
+    /**
+     * @brief Inferred result type of a method (Unknown if it could not be inferred)
+     */
+    TypeInfo getMethodReturnType(const std::string& type_name, const std::string& method) const;
+    
+    /**
+     * @brief True if the variable of `let_expr` starts at an integer literal and is only
+     * assigned literals or `x := x ± step`, so it always holds an exact integer in int64 range
+     */
+    bool isIntegerVariable(const LetExpr* let_expr) const;
+    
     // Visitor pattern implementation - ExprVisitor
     void visit(Program* prog) override;
     void visit(NumberExpr* expr) override;
@@ -153,9 +217,81 @@ private:
      */
     bool isReservedWord(const std::string& word);
     
+    /**
+     * @brief Merge a new observation into a constructor or function argument type
+     */
+    bool joinArgumentType(std::vector<std::optional<TypeInfo>>& seen, size_t index, const TypeInfo& type); // true if it changed
+    
+    /**
+     * @brief Type of an attribute initializer, given the constructor parameter types
+     *
+     * Side-effect free (no errors are reported): initializers are not part of
+     * the checked program, only of the object layout.
+     */
+    TypeInfo inferInitializerType(Expr* expr, std::map<std::string, TypeInfo>& params);
+    
+    /**
+     * @brief Type of a let variable: its initializer, unless the body assigns it another type
+     */
+    TypeInfo inferLetVariableType(LetExpr* let_expr, std::map<std::string, TypeInfo>& params);
+    
+    /**
+     * @brief Call `fn` on `expr` and every subexpression, with the types of the let variables in scope
+     */
+    using ScopedExpressionFn = std::function<void(Expr*, std::map<std::string, TypeInfo>&)>;
+    void forEachScopedExpression(Expr* expr, std::map<std::string, TypeInfo>& scope, const ScopedExpressionFn& fn);
+    
+    /**
+     * @brief Join the argument types of every user function and method call inside `expr`
+     */
+    bool collectCallArgumentTypes(Expr* expr, std::map<std::string, TypeInfo>& scope); // true if any changed
+    
+    /**
+     * @brief Fill in the parameter and return types of the user functions
+     */
+    void inferFunctionSignatures(Program* program);
+    
+    /**
+     * @brief Compute function_specializations_ from the argument shapes of the calls,
+     * including those made from inside other specializations
+     */
+    void inferFunctionSpecializations(Program* program);
+    
+    /**
+     * @brief Compute attribute_types_ once every `new` has been analyzed
+     */
+    void inferAttributeTypes();
+    
+    /**
+     * @brief Compute method_return_types_ from the last expression of every method body
+     */
+    void inferMethodReturnTypes();
+    
+    /**
+     * @brief Compute integer_variables_ (loop counters and the like)
+     */
+    void inferIntegerVariables(Program* program);
+    
 private:
     /**
      * @brief Store inheritance relationships (child -> parent)
      */
     std::map<std::string, std::string> inheritance_map_;
+    
+    /**
+     * @brief Type declarations by name, and what the analysis learned about them
+     */
+    std::map<std::string, TypeDecl*> type_decls_;
+    std::map<std::string, std::vector<std::optional<TypeInfo>>> constructor_arg_types_; // nullopt = never seen
+    std::map<std::string, std::map<std::string, TypeInfo>> attribute_types_;
+    
+    /**
+     * @brief User functions by name, and the argument types seen at their calls
+     */
+    std::map<std::string, FunctionDecl*> function_decls_;
+    std::map<std::string, std::vector<std::optional<TypeInfo>>> function_arg_types_; // nullopt = never seen
+    std::map<std::string, std::vector<std::optional<TypeInfo>>> method_arg_types_;   // by method name
+    std::map<std::string, std::vector<FunctionSpecialization>> function_specializations_;
+    std::map<std::string, std::map<std::string, TypeInfo>> method_return_types_;       // type -> method -> result
+    std::unordered_set<const LetExpr*> integer_variables_;
 };
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include <cstdio>
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 
 #include "AST/ast.hpp"
 #include "Evaluator/evaluator.hpp"
@@ -17,6 +21,7 @@
 
 #if ENABLE_LLVM
 #include "CodeGen/LLVMCodeGenerator.hpp"
+#include "CodeGen/TieredCompiler.hpp"
 // #include <llvm/Support/raw_ostream.h>
 // #include <llvm/IR/Verifier.h>
 #endif
@@ -38,6 +43,23 @@ int main(int argc, char *argv[])
     bool showIR = false;
     const char* filename = nullptr;
     const char* outputFile = nullptr;
+    unsigned optLevel = 0;
+    bool fastMath = false;
+    bool fpContract = false;
+    bool noNans = false;
+    bool intCounters = true;
+    const char* targetCpu = nullptr;
+    bool multiversion = false;
+    unsigned jobs = 1;
+    bool showStats = false;
+    const char* cacheDir = "";
+    const char* profileOut = nullptr;
+    const char* profileUse = nullptr;
+    bool tiered = false;
+    bool debugInfo = false;
+    bool instrument = false;
+    bool instrumentBranches = false;
+    uint64_t tierThreshold = 1000;
     CompilationMode mode = MODE_INTERPRET;
       // Parse arguments
     for (int i = 1; i < argc; i++) {
@@ -54,6 +76,51 @@ int main(int argc, char *argv[])
             std::cerr << "Error: LLVM support not available. Recompile with LLVM installed.\n";
             return 1;
 #endif
+        } else if (strcmp(argv[i], "--fast-math") == 0) {
+            fastMath = true;
+        } else if (strcmp(argv[i], "--fp-contract") == 0) {
+            fpContract = true;
+        } else if (strcmp(argv[i], "--no-nans") == 0) {
+            noNans = true;
+        } else if (strcmp(argv[i], "--no-int-counters") == 0) {
+            intCounters = false;
+        } else if (strncmp(argv[i], "--march=", 8) == 0) {
+            targetCpu = argv[i] + 8;
+        } else if (strcmp(argv[i], "--multiversion") == 0) {
+            multiversion = true;
+        } else if (strncmp(argv[i], "-O", 2) == 0 && argv[i][2] >= '0' && argv[i][2] <= '3' && argv[i][3] == '\0') {
+            optLevel = argv[i][2] - '0';
+        } else if (strncmp(argv[i], "--profile-out=", 14) == 0) {
+            profileOut = argv[i] + 14;
+        } else if (strncmp(argv[i], "--profile-use=", 14) == 0) {
+            profileUse = argv[i] + 14;
+        } else if (strcmp(argv[i], "--tiered") == 0) {
+#if ENABLE_LLVM
+            tiered = true;
+#else
+            std::cerr << "Error: LLVM support not available. Recompile with LLVM installed.\n";
+            return 1;
+#endif
+        } else if (strncmp(argv[i], "--tier-threshold=", 17) == 0) {
+            tierThreshold = strtoull(argv[i] + 17, nullptr, 10);
+        } else if (strcmp(argv[i], "--instrument") == 0) {
+            instrument = true;
+        } else if (strcmp(argv[i], "--instrument=branches") == 0) {
+            instrument = instrumentBranches = true;
+        } else if (strcmp(argv[i], "-g") == 0) {
+            debugInfo = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            showStats = true;
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            cacheDir = "hulk/.cache";
+        } else if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            cacheDir = "";
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+        } else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0') {
+            jobs = static_cast<unsigned>(std::max(1, atoi(argv[i] + 2)));
         } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
             outputFile = argv[++i];
         } else if (filename == nullptr) {
@@ -68,7 +135,26 @@ int main(int argc, char *argv[])
         std::cerr << "  --semantic  Solo análisis semántico" << std::endl;
         std::cerr << "  --llvm      Generar código LLVM IR" << std::endl;
         std::cerr << "  --show-ir   Mostrar código LLVM IR generado" << std::endl;
-        std::cerr << "  -o <file>   Archivo de salida (solo para --llvm)" << std::endl;
+        std::cerr << "  -O<n>       Nivel de optimización LLVM (0-3, por defecto 0)" << std::endl;
+        std::cerr << "  --fast-math Permitir reasociación y demás optimizaciones inseguras de punto flotante" << std::endl;
+        std::cerr << "  --fp-contract Permitir fusionar multiplicación y suma (FMA)" << std::endl;
+        std::cerr << "  --no-nans   Asumir que no aparecen NaN" << std::endl;
+        std::cerr << "  --no-int-counters Mantener como Number (double) los contadores enteros de los bucles" << std::endl;
+        std::cerr << "  --march=<cpu> Generar código para una CPU concreta (native = la de esta máquina)" << std::endl;
+        std::cerr << "  --multiversion Compilar las funciones numéricas calientes para AVX-512, AVX2 y x86-64 base" << std::endl;
+        std::cerr << "  --profile-out=<file> Interpretar y guardar un perfil de ejecución (ramas, llamadas, tipos)" << std::endl;
+        std::cerr << "  --profile-use=<file> Optimizar el código LLVM con un perfil de --profile-out" << std::endl;
+        std::cerr << "  --tiered    Interpretar y compilar con JIT (en segundo plano) las funciones calientes" << std::endl;
+        std::cerr << "  --tier-threshold=<n> Llamadas para considerar caliente una función (por defecto 1000)" << std::endl;
+        std::cerr << "  --instrument Contar llamadas y ciclos (rdtsc) de funciones y métodos del código compilado" << std::endl;
+        std::cerr << "  --instrument=branches Además contar ramas de if y vueltas de while" << std::endl;
+        std::cerr << "  -g          Generar información de depuración DWARF (gdb, perf) para --llvm y --tiered" << std::endl;
+        std::cerr << "  --stats     Mostrar estadísticas de generación de código y de --tiered" << std::endl;
+        std::cerr << "  --cache     Reutilizar módulos optimizados y código objeto de compilaciones anteriores (hulk/.cache)" << std::endl;
+        std::cerr << "  --cache-dir <dir> Igual que --cache, en otro directorio (se limita a 256 MB)" << std::endl;
+        std::cerr << "  --no-cache  No usar la caché (por defecto)" << std::endl;
+        std::cerr << "  -j <n>      Hilos para generar código objeto en paralelo (por defecto 1)" << std::endl;
+        std::cerr << "  -o <file>   Archivo de salida (solo para --llvm; .o genera código objeto)" << std::endl;
         return 1;
     }
 
@@ -89,6 +175,26 @@ int main(int argc, char *argv[])
         std::cout << "\n\n";
     }
 
+    // El perfil se asocia al texto exacto del fuente (los node_id dependen de él)
+    std::string sourceHash;
+    if (profileOut || profileUse) {
+        std::ifstream source(filename, std::ios::binary);
+        std::ostringstream contents;
+        contents << source.rdbuf();
+        sourceHash = ExecutionProfile::hashSource(contents.str());
+    }
+    ExecutionProfile profile;
+    bool hasProfile = false;
+    if (profileUse) {
+        if (!profile.load(profileUse)) {
+            std::cerr << "Advertencia: no se pudo leer el perfil " << profileUse << "; se ignora" << std::endl;
+        } else if (profile.sourceHash != sourceHash) {
+            std::cerr << "Advertencia: el perfil " << profileUse << " corresponde a otra versión del fuente; se ignora" << std::endl;
+        } else {
+            hasProfile = true;
+        }
+    }
+
     yylineno = 1;
     yyin = file;    if (yyparse() != 0 || rootAST == nullptr)
     {
@@ -147,14 +253,39 @@ int main(int argc, char *argv[])
         if (debugMode) std::cout << "=== Iniciando generación de código LLVM ===\n";
           try {
             LLVMCodeGenerator codegen("hulk_module", analyzer_ptr);
+            codegen.setFastMathOptions(fastMath, fpContract, noNans);
+            codegen.setIntegerCounters(intCounters);
+            codegen.setVerbose(debugMode);
+            if (targetCpu && !codegen.setTargetCPU(targetCpu)) {
+                fclose(file);
+                return 1;
+            }
+            codegen.setMultiversioning(multiversion);
+            codegen.setObjectCacheDir(cacheDir);
+            if (hasProfile) {
+                codegen.setProfile(&profile);
+            }
+            if (debugInfo) {
+                codegen.enableDebugInfo(filename);
+            }
+            codegen.setInstrumentation(instrument, instrumentBranches);
             rootAST->accept(&codegen);
+            if (optLevel > 0) {
+                codegen.optimizeModule(optLevel);
+            }
             
-            if (mode == MODE_LLVM || showIR) {
+            if (mode == MODE_LLVM && outputFile) {
+                codegen.writeOutput(outputFile, jobs);
+            } else if (mode == MODE_LLVM || showIR) {
                 std::cout << "\n=== Código LLVM IR Generado ===\n";
                 codegen.printModule();
                 std::cout << "=== Fin del código LLVM IR ===\n\n";
             }
             
+            if (showStats) {
+                codegen.printStats(std::cerr);
+            }
+            
             if (debugMode) std::cout << "=== Generación de código LLVM completada ===\n";
             
             // Si solo queremos mostrar IR, continuamos con la ejecución normal
@@ -194,7 +325,32 @@ int main(int argc, char *argv[])
         std::cout << "\n=== Ejecución ===\n";
         try {
             EvaluatorVisitor evaluator;
+            if (profileOut) {
+                profile.sourceHash = sourceHash;
+                evaluator.profile = &profile;
+            }
+#if ENABLE_LLVM
+            std::unique_ptr<TieredCompiler> nativeTier;
+            if (tiered) {
+                nativeTier = std::make_unique<TieredCompiler>(evaluator.functions, tierThreshold,
+                                                              optLevel ? optLevel : 2,
+                                                              debugInfo ? filename : "",
+                                                              targetCpu ? targetCpu : "native");
+                nativeTier->setInstrumentation(instrument, instrumentBranches);
+                nativeTier->setObjectCacheDir(cacheDir);
+                evaluator.nativeTier = nativeTier.get();
+            }
+#endif
             rootAST->accept(&evaluator);
+#if ENABLE_LLVM
+            if (nativeTier && showStats) {
+                nativeTier->printStats(std::cerr, evaluator.functionCalls, evaluator.methodCalls,
+                                       evaluator.loopIterations);
+            }
+#endif
+            if (profileOut && !profile.save(profileOut)) {
+                std::cerr << "Advertencia: no se pudo escribir el perfil " << profileOut << std::endl;
+            }
             if (debugMode) {
                 std::cout << "\n=== Programa terminado exitosamente ===\n";
             }